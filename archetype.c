@@ -0,0 +1,101 @@
+/* String manipulation functions (memset, memcpy) */
+#include <string.h>
+/* Archetype declarations */
+#include "archetype.h"
+
+/* Bytes of an element of each component's column, 0 for components with no data */
+static const size_t COMPONENT_SIZES[COMPONENT_TYPES] = {
+    sizeof(Position),       /* COMPONENT_POSITION */
+    sizeof(char),           /* COMPONENT_SYMBOL */
+    sizeof(Collectible),    /* COMPONENT_COLLECTIBLE */
+    0                       /* COMPONENT_BLOCKING */
+};
+
+/* Return 1 if an archetype stores a column for a component */
+static int hasColumn(const Archetype* archetype, int component) {
+    return (archetype->components & COMPONENT_BIT(component)) && COMPONENT_SIZES[component] > 0;
+}
+
+/* Allocate an empty archetype of the given components with room for a number of entities, returns 0 if out of memory */
+int initArchetype(Archetype* archetype, Arena* arena, unsigned int components, int capacity) {
+    memset(archetype, 0, sizeof(*archetype));
+    archetype->components = components;
+    archetype->arena = arena;
+    archetype->capacity = capacity > 0 ? capacity : 1;
+    int ok = initEntityPool(&archetype->pool, arena, archetype->capacity);
+    for (int component = 0; component < COMPONENT_TYPES; component++) {
+        if (hasColumn(archetype, component)) {
+            archetype->columns[component] = arenaAlloc(arena, (size_t)archetype->capacity * COMPONENT_SIZES[component]);
+            ok = ok && archetype->columns[component] != NULL;
+        }
+    }
+    if (!ok) {
+        freeArchetype(archetype);
+        return 0;
+    }
+    return 1;
+}
+
+/* Free the columns of an archetype, the ones from an arena go with the arena */
+void freeArchetype(Archetype* archetype) {
+    for (int component = 0; component < COMPONENT_TYPES; component++) {
+        arenaRelease(archetype->arena, archetype->columns[component]);
+    }
+    freeEntityPool(&archetype->pool);
+    memset(archetype, 0, sizeof(*archetype));
+}
+
+/* Make room in the columns for at least the given number of entities, returns 0 if out of memory */
+int reserveArchetype(Archetype* archetype, int count) {
+    if (count <= archetype->capacity) {
+        return 1;
+    }
+
+    /* The columns at least double, so spawning one entity at a time only copies them a few times */
+    int capacity = archetype->capacity * 2 > count ? archetype->capacity * 2 : count;
+    for (int component = 0; component < COMPONENT_TYPES; component++) {
+        if (hasColumn(archetype, component)) {
+            void* column = arenaGrow(archetype->arena, archetype->columns[component],
+                                     (size_t)archetype->capacity * COMPONENT_SIZES[component],
+                                     (size_t)capacity * COMPONENT_SIZES[component]);
+            if (column == NULL) {
+                return 0;
+            }
+            archetype->columns[component] = column;
+        }
+    }
+    archetype->capacity = capacity;
+    return 1;
+}
+
+/* Add an entity with zeroed components after the last one, returns its index or -1 if out of memory */
+int spawnArchetypeEntity(Archetype* archetype) {
+    if (!reserveArchetype(archetype, archetype->pool.count + 1) || spawnEntity(&archetype->pool).generation == 0) {
+        return -1;
+    }
+    int index = archetype->pool.count - 1;
+    for (int component = 0; component < COMPONENT_TYPES; component++) {
+        if (hasColumn(archetype, component)) {
+            memset((char*)archetype->columns[component] + (size_t)index * COMPONENT_SIZES[component], 0,
+                   COMPONENT_SIZES[component]);
+        }
+    }
+    return index;
+}
+
+/* Remove the entity at an index, the last entity moves into it */
+void despawnArchetypeEntity(Archetype* archetype, int index) {
+    int last = despawnEntity(&archetype->pool, index);
+    for (int component = 0; component < COMPONENT_TYPES; component++) {
+        if (hasColumn(archetype, component)) {
+            size_t size = COMPONENT_SIZES[component];
+            char* column = (char*)archetype->columns[component];
+            memcpy(column + (size_t)index * size, column + (size_t)last * size, size);
+        }
+    }
+}
+
+/* Remove every entity */
+void clearArchetype(Archetype* archetype) {
+    clearEntityPool(&archetype->pool);
+}
@@ -0,0 +1,75 @@
+/**
+ * SpaceXplorer Archetype Header
+ *
+ * This header defines the components entities are made of and the
+ * archetypes storing them. An archetype holds every entity with the same
+ * set of components, one contiguous column per component, so a system
+ * that needs only positions walks an array of positions. Entities are
+ * kept densely packed by an entity pool: removing one moves the last
+ * entity of the archetype into its place in every column.
+ */
+
+#ifndef SPACEXPLORER_ARCHETYPE_H
+#define SPACEXPLORER_ARCHETYPE_H
+
+/* Dense indices and handles of the entities */
+#include "entity_pool.h"
+
+/**
+ * 2D Position structure for game objects
+ * Used to track location of the ship, asteroid, junk, and obstacles
+ */
+typedef struct {
+    int x; /* X-coordinate (horizontal position) */
+    int y; /* Y-coordinate (vertical position) */
+} Position;
+
+/**
+ * Collectible component
+ * What the ship gets for moving onto the entity
+ */
+typedef struct {
+    int type;           /* Kind of item, a JunkType for junk */
+    int value;          /* Score value when collected */
+} Collectible;
+
+/* Components of an entity, each an archetype column, except blocking which only marks the entity */
+typedef enum {
+    COMPONENT_POSITION,     /* Position of the entity's cell */
+    COMPONENT_SYMBOL,       /* Character displayed on the map, a char */
+    COMPONENT_COLLECTIBLE,  /* Collectible the ship picks up */
+    COMPONENT_BLOCKING,     /* Stops the ship, asteroids and the line of sight, no data */
+    COMPONENT_TYPES
+} ComponentType;
+
+/* Bit of a component in an archetype's set of components */
+#define COMPONENT_BIT(component) (1u << (component))
+/* Column of a component as an array of its type, NULL if the archetype does not have it */
+#define ARCHETYPE_COLUMN(archetype, component, type) ((type*)(archetype)->columns[component])
+
+/**
+ * Archetype
+ * The components of entity i are element i of each column
+ */
+typedef struct {
+    unsigned int components;            /* COMPONENT_BIT of each component the entities have */
+    EntityPool pool;                    /* Slots and handles of the entities, pool.count is the number of entities */
+    int capacity;                       /* Number of entities the columns have room for */
+    void* columns[COMPONENT_TYPES];     /* Column of each component with data, NULL for the others */
+    Arena* arena;                       /* Arena the columns come from, NULL for the heap */
+} Archetype;
+
+/* Allocate an empty archetype of the given components with room for a number of entities, returns 0 if out of memory */
+int initArchetype(Archetype* archetype, Arena* arena, unsigned int components, int capacity);
+/* Free the columns of an archetype, the ones from an arena go with the arena */
+void freeArchetype(Archetype* archetype);
+/* Make room in the columns for at least the given number of entities, returns 0 if out of memory */
+int reserveArchetype(Archetype* archetype, int count);
+/* Add an entity with zeroed components after the last one, returns its index or -1 if out of memory */
+int spawnArchetypeEntity(Archetype* archetype);
+/* Remove the entity at an index, the last entity moves into it */
+void despawnArchetypeEntity(Archetype* archetype, int index);
+/* Remove every entity */
+void clearArchetype(Archetype* archetype);
+
+#endif /* SPACEXPLORER_ARCHETYPE_H */
@@ -0,0 +1,150 @@
+/* Standard input/output functions (fprintf) */
+#include <stdio.h>
+/* String manipulation functions (memcpy, memset) */
+#include <string.h>
+/* Arena declarations */
+#include "arena.h"
+
+#ifndef _WIN32
+/* Memory mapping functions (mmap, munmap) */
+#include <sys/mman.h>
+#endif
+
+/* Alignment of every piece handed out, a cache line so arrays never share one */
+#define ARENA_ALIGNMENT 64
+
+/* Reserve an arena of the given size, returns 0 if the address space cannot be reserved */
+int initArena(Arena* arena, size_t bytes) {
+    memset(arena, 0, sizeof(*arena));
+
+#ifndef _WIN32
+    /* Anonymous pages read as zero and only take memory once they are written */
+    void* base = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base != MAP_FAILED) {
+        arena->base = (char*)base;
+        arena->reserved = bytes;
+        arena->isMapped = 1;
+        return 1;
+    }
+#endif
+
+    /* Fall back to one zeroed block from the heap */
+    arena->base = (char*)calloc(1, bytes);
+    if (arena->base == NULL) {
+        return 0;
+    }
+    arena->reserved = bytes;
+    return 1;
+}
+
+/* Release the whole arena at once */
+void freeArena(Arena* arena) {
+#ifndef _WIN32
+    if (arena->isMapped) {
+        munmap(arena->base, arena->reserved);
+    } else {
+        free(arena->base);
+    }
+#else
+    free(arena->base);
+#endif
+    memset(arena, 0, sizeof(*arena));
+}
+
+/* Hand out zeroed bytes from an arena, or from the heap with a NULL arena, returns NULL if out of memory */
+void* arenaAlloc(Arena* arena, size_t bytes) {
+    if (arena == NULL) {
+        return calloc(1, bytes > 0 ? bytes : 1);
+    }
+
+    /* Nothing handed out is ever written back to zero, so fresh bytes of the range are still zero */
+    size_t start = (arena->used + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+    if (start > arena->reserved || bytes > arena->reserved - start) {
+        return NULL;
+    }
+    arena->used = start + bytes;
+    return arena->base + start;
+}
+
+/* Grow an allocation to a new size keeping its contents, in place if it is the arena's last one, returns NULL if out of memory */
+void* arenaGrow(Arena* arena, void* block, size_t oldBytes, size_t newBytes) {
+    if (arena == NULL) {
+        return realloc(block, newBytes > 0 ? newBytes : 1);
+    }
+
+    /* The last piece handed out can grow into the free bytes after it */
+    char* bytes = (char*)block;
+    if (bytes != NULL && bytes + oldBytes == arena->base + arena->used) {
+        if (newBytes <= oldBytes || newBytes - oldBytes <= arena->reserved - arena->used) {
+            arena->used = (size_t)(bytes - arena->base) + (newBytes > oldBytes ? newBytes : oldBytes);
+            return block;
+        }
+        return NULL;
+    }
+
+    /* Any other piece is copied to a new one, its old bytes stay used until the arena is freed */
+    void* grown = arenaAlloc(arena, newBytes);
+    if (grown != NULL && block != NULL) {
+        memcpy(grown, block, oldBytes < newBytes ? oldBytes : newBytes);
+    }
+    return grown;
+}
+
+/* Give an allocation back, which only frees it when it came from the heap */
+void arenaRelease(Arena* arena, void* block) {
+    if (arena == NULL) {
+        free(block);
+    }
+}
+
+#if defined(SPACEXPLORER_ALLOC_CHECK) && defined(__GLIBC__)
+/* The allocator glibc uses when its functions are not replaced */
+extern void* __libc_malloc(size_t bytes);
+extern void* __libc_calloc(size_t count, size_t bytes);
+extern void* __libc_realloc(void* block, size_t bytes);
+
+/* Flag set while the calling thread's heap allocations are counted */
+static _Thread_local int allocCheckActive;
+/* Heap allocations counted on the calling thread */
+static _Thread_local long long allocCheckCount;
+
+/* Count a heap allocation of the calling thread if it is being checked */
+static void countAllocation(void) {
+    if (allocCheckActive) {
+        allocCheckCount++;
+    }
+}
+
+/* Heap allocation replaced to be counted */
+void* malloc(size_t bytes) {
+    countAllocation();
+    return __libc_malloc(bytes);
+}
+
+/* Zeroed heap allocation replaced to be counted */
+void* calloc(size_t count, size_t bytes) {
+    countAllocation();
+    return __libc_calloc(count, bytes);
+}
+
+/* Heap reallocation replaced to be counted */
+void* realloc(void* block, size_t bytes) {
+    countAllocation();
+    return __libc_realloc(block, bytes);
+}
+
+/* Start counting the heap allocations of the calling thread */
+void beginAllocCheck(void) {
+    allocCheckCount = 0;
+    allocCheckActive = 1;
+}
+
+/* Stop counting and abort with a message naming the code checked if there were any */
+void endAllocCheck(const char* where) {
+    allocCheckActive = 0;
+    if (allocCheckCount > 0) {
+        fprintf(stderr, "%s made %lld heap allocations\n", where, allocCheckCount);
+        abort();
+    }
+}
+#endif
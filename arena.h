@@ -0,0 +1,58 @@
+/**
+ * SpaceXplorer Arena Header
+ *
+ * This header defines the arena a game allocates all of its memory from.
+ * The arena reserves one range of address space when the game is set up
+ * and hands out pieces of it by moving a pointer forward, so nothing is
+ * freed on its own and the whole range is released at once when the game
+ * is cleaned up. The pages of the range only take memory once they are
+ * written, so the reservation can leave plenty of room for entities added
+ * during the game. Modules that can run without a game take a NULL arena
+ * to allocate from the heap instead.
+ *
+ * Building with SPACEXPLORER_ALLOC_CHECK on glibc also counts the heap
+ * allocations made between ALLOC_CHECK_BEGIN and ALLOC_CHECK_END on the
+ * calling thread, and aborts if a turn of the game made any.
+ */
+
+#ifndef SPACEXPLORER_ARENA_H
+#define SPACEXPLORER_ARENA_H
+
+/* Size types (size_t) and the heap functions */
+#include <stdlib.h>
+
+/**
+ * Arena
+ * Bytes base[0] to base[used - 1] are handed out, the rest up to reserved are free
+ */
+typedef struct {
+    char* base;         /* Start of the reserved range, NULL if none */
+    size_t reserved;    /* Bytes reserved */
+    size_t used;        /* Bytes handed out */
+    int isMapped;       /* Flag set if the range was mapped rather than allocated from the heap */
+} Arena;
+
+/* Reserve an arena of the given size, returns 0 if the address space cannot be reserved */
+int initArena(Arena* arena, size_t bytes);
+/* Release the whole arena at once */
+void freeArena(Arena* arena);
+/* Hand out zeroed bytes from an arena, or from the heap with a NULL arena, returns NULL if out of memory */
+void* arenaAlloc(Arena* arena, size_t bytes);
+/* Grow an allocation to a new size keeping its contents, in place if it is the arena's last one, returns NULL if out of memory */
+void* arenaGrow(Arena* arena, void* block, size_t oldBytes, size_t newBytes);
+/* Give an allocation back, which only frees it when it came from the heap */
+void arenaRelease(Arena* arena, void* block);
+
+#if defined(SPACEXPLORER_ALLOC_CHECK) && defined(__GLIBC__)
+/* Start counting the heap allocations of the calling thread */
+void beginAllocCheck(void);
+/* Stop counting and abort with a message naming the code checked if there were any */
+void endAllocCheck(const char* where);
+#define ALLOC_CHECK_BEGIN() beginAllocCheck()
+#define ALLOC_CHECK_END(where) endAllocCheck(where)
+#else
+#define ALLOC_CHECK_BEGIN() ((void)0)
+#define ALLOC_CHECK_END(where) ((void)0)
+#endif
+
+#endif /* SPACEXPLORER_ARENA_H */
@@ -0,0 +1,389 @@
+/* Size types (size_t) */
+#include <stdlib.h>
+/* String manipulation functions (memset, memcpy) */
+#include <string.h>
+/* Asteroid field declarations */
+#include "asteroid_field.h"
+/* Worker threads the tiles are moved on */
+#include "thread_pool.h"
+
+/* Cells of the occupancy index packed into one word */
+#define FIELD_CELLS_PER_WORD 32
+/* Asteroids moved by one call of the step kernel */
+#define FIELD_BLOCK 256
+/* Width and height of a tile in cells, the most steps taken between two handoffs */
+#define FIELD_TILE_SIZE (1 << FIELD_TILE_SHIFT)
+/* Number of slots of a tile's neighbourhood, itself and the 8 tiles around it */
+#define FIELD_NEIGHBOURS 9
+
+/*
+ * The step kernel is compiled for each vector width of x86-64 and the
+ * widest one the processor supports is picked when the program loads.
+ * It needs gathers and per-lane shifts, so the baseline version is scalar.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define FIELD_KERNEL_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define FIELD_KERNEL_CLONES
+#endif
+
+/**
+ * One step of a turn
+ * Shared by the tile tasks, which only write to the data of their own tile
+ * and set bits of the next step's index
+ */
+typedef struct {
+    AsteroidField* field;       /* Field being moved */
+    const unsigned int* cells;  /* Index the step reads, with the asteroids where they start marked */
+    unsigned int* next;         /* Index the asteroids are marked in where they end, NULL after the last step */
+    int firstStep;              /* Flag set in the first step of a turn */
+    int shared;                 /* Flag set if other threads mark the same index */
+    int shipX;                  /* Ship X-coordinate */
+    int shipY;                  /* Ship Y-coordinate */
+} FieldStep;
+
+/* Read the occupancy bit of a cell */
+static inline int cellBlocked(const unsigned int* restrict cells, unsigned int index) {
+    return (int)(cells[index / FIELD_CELLS_PER_WORD] >> (index % FIELD_CELLS_PER_WORD)) & 1;
+}
+
+/* Set the occupancy bits of the cells of a run of asteroids, atomically if other threads set bits of the same index */
+static void markLanes(unsigned int* restrict cells, const int* restrict xs, const int* restrict ys, int count,
+                      int width, int shared) {
+    if (shared) {
+        for (int i = 0; i < count; i++) {
+            unsigned int index = (unsigned int)(ys[i] * width + xs[i]);
+            __atomic_fetch_or(&cells[index / FIELD_CELLS_PER_WORD], 1u << (index % FIELD_CELLS_PER_WORD), __ATOMIC_RELAXED);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            unsigned int index = (unsigned int)(ys[i] * width + xs[i]);
+            cells[index / FIELD_CELLS_PER_WORD] |= 1u << (index % FIELD_CELLS_PER_WORD);
+        }
+    }
+}
+
+/* Number of words of an occupancy index */
+static size_t indexWords(const AsteroidField* field) {
+    return ((size_t)field->width * field->height + FIELD_CELLS_PER_WORD - 1) / FIELD_CELLS_PER_WORD;
+}
+
+/* Number of the tile a cell is in */
+static inline int tileOf(const AsteroidField* field, int x, int y) {
+    return (y >> FIELD_TILE_SHIFT) * field->tilesX + (x >> FIELD_TILE_SHIFT);
+}
+
+/* Allocate a field of asteroids for a world with no obstacles from an arena or the heap, returns 0 if out of memory */
+int initAsteroidField(AsteroidField* field, Arena* arena, int count, int width, int height) {
+    size_t lanes = (size_t)count + 1;
+    memset(field, 0, sizeof(*field));
+    field->arena = arena;
+    field->count = count;
+    field->capacity = (int)lanes;
+    field->width = width;
+    field->height = height;
+    field->tilesX = (width + FIELD_TILE_SIZE - 1) / FIELD_TILE_SIZE;
+    field->tilesY = (height + FIELD_TILE_SIZE - 1) / FIELD_TILE_SIZE;
+    size_t tiles = (size_t)field->tilesX * field->tilesY;
+
+    int ok = 1;
+    int** arrays[] = {&field->x, &field->y, &field->dx, &field->dy, &field->id,
+                      &field->spare[0], &field->spare[1], &field->spare[2], &field->spare[3], &field->spare[4]};
+    for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+        *arrays[i] = (int*)arenaAlloc(arena, lanes * sizeof(int));
+        ok = ok && *arrays[i] != NULL;
+    }
+    size_t words = indexWords(field);
+    field->cells = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    field->stepCells[0] = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    field->stepCells[1] = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    field->tileStart = (int*)arenaAlloc(arena, (tiles + 1) * sizeof(int));
+    field->spareStart = (int*)arenaAlloc(arena, (tiles + 1) * sizeof(int));
+    field->tileMoves = (int*)arenaAlloc(arena, tiles * FIELD_NEIGHBOURS * sizeof(int));
+    field->tileHits = (int*)arenaAlloc(arena, tiles * sizeof(int));
+    if (!ok || field->cells == NULL || field->stepCells[0] == NULL || field->stepCells[1] == NULL || field->tileStart == NULL || field->spareStart == NULL ||
+        field->tileMoves == NULL || field->tileHits == NULL) {
+        freeAsteroidField(field);
+        return 0;
+    }
+    return 1;
+}
+
+/* Free the arrays of a field, the ones from an arena go with the arena */
+void freeAsteroidField(AsteroidField* field) {
+    arenaRelease(field->arena, field->x);
+    arenaRelease(field->arena, field->y);
+    arenaRelease(field->arena, field->dx);
+    arenaRelease(field->arena, field->dy);
+    arenaRelease(field->arena, field->id);
+    for (int i = 0; i < 5; i++) {
+        arenaRelease(field->arena, field->spare[i]);
+    }
+    arenaRelease(field->arena, field->cells);
+    arenaRelease(field->arena, field->stepCells[0]);
+    arenaRelease(field->arena, field->stepCells[1]);
+    arenaRelease(field->arena, field->tileStart);
+    arenaRelease(field->arena, field->spareStart);
+    arenaRelease(field->arena, field->tileMoves);
+    arenaRelease(field->arena, field->tileHits);
+    memset(field, 0, sizeof(*field));
+}
+
+/* Add an asteroid after the last one placed, sorted into its tile by the next step, returns 0 if out of memory */
+int addFieldAsteroid(AsteroidField* field, int x, int y, int dx, int dy) {
+    /* Double the asteroid arrays and their spares when full, the ones already grown are kept if another fails */
+    if (field->count + 1 >= field->capacity) {
+        int capacity = field->capacity * 2;
+        int** arrays[] = {&field->x, &field->y, &field->dx, &field->dy, &field->id,
+                          &field->spare[0], &field->spare[1], &field->spare[2], &field->spare[3], &field->spare[4]};
+        for (size_t i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++) {
+            int* grown = (int*)arenaGrow(field->arena, *arrays[i], (size_t)field->capacity * sizeof(int), (size_t)capacity * sizeof(int));
+            if (grown == NULL) {
+                return 0;
+            }
+            *arrays[i] = grown;
+        }
+        field->capacity = capacity;
+    }
+
+    int i = field->count++;
+    field->x[i] = x;
+    field->y[i] = y;
+    field->dx[i] = dx;
+    field->dy[i] = dy;
+    field->id[i] = i;
+    field->unsorted = 1;
+    return 1;
+}
+
+/* Mark a cell of the occupancy index as an obstacle */
+void markFieldObstacle(AsteroidField* field, int x, int y) {
+    markLanes(field->cells, &x, &y, 1, field->width, 0);
+}
+
+/* Clear every obstacle from the occupancy index */
+void clearFieldObstacles(AsteroidField* field) {
+    memset(field->cells, 0, indexWords(field) * sizeof(unsigned int));
+}
+
+/* Swap the asteroid arrays and tile starts with the spare ones the handoff filled */
+static void swapSpares(AsteroidField* field) {
+    int** arrays[] = {&field->x, &field->y, &field->dx, &field->dy, &field->id};
+    for (int i = 0; i < 5; i++) {
+        int* swap = *arrays[i];
+        *arrays[i] = field->spare[i];
+        field->spare[i] = swap;
+    }
+    int* swap = field->tileStart;
+    field->tileStart = field->spareStart;
+    field->spareStart = swap;
+}
+
+/* Copy an asteroid into a slot of the spare arrays */
+static void copyToSpare(AsteroidField* field, int from, int to) {
+    field->spare[0][to] = field->x[from];
+    field->spare[1][to] = field->y[from];
+    field->spare[2][to] = field->dx[from];
+    field->spare[3][to] = field->dy[from];
+    field->spare[4][to] = field->id[from];
+}
+
+/* Sort the asteroids by tile after they were placed or moved without the field */
+void sortAsteroidField(AsteroidField* field) {
+    int tiles = field->tilesX * field->tilesY;
+
+    /* Stable counting sort, the asteroids of a tile keep their order */
+    int* starts = field->spareStart;
+    memset(starts, 0, (size_t)(tiles + 1) * sizeof(int));
+    for (int i = 0; i < field->count; i++) {
+        starts[tileOf(field, field->x[i], field->y[i]) + 1]++;
+    }
+    for (int t = 0; t < tiles; t++) {
+        starts[t + 1] += starts[t];
+    }
+
+    /* The old tile starts are free to use as the next slot of each tile */
+    int* next = field->tileStart;
+    memcpy(next, starts, (size_t)(tiles + 1) * sizeof(int));
+    for (int i = 0; i < field->count; i++) {
+        copyToSpare(field, i, next[tileOf(field, field->x[i], field->y[i])]++);
+    }
+    swapSpares(field);
+    field->drift = 0;
+    field->unsorted = 0;
+}
+
+/*
+ * Move a run of asteroids one step, the same bounces as stepAsteroid but
+ * with every branch turned into a select so the loop vectorizes. Asteroids
+ * whose hit flag is set stay on the ship's cell.
+ */
+FIELD_KERNEL_CLONES
+static void stepFieldLanes(int* restrict xs, int* restrict ys, int* restrict dxs, int* restrict dys,
+                           int* restrict hits, int count, const unsigned int* restrict cells, int width, int height,
+                           int shipX, int shipY) {
+    for (int i = 0; i < count; i++) {
+        int x = xs[i], y = ys[i], dx = dxs[i], dy = dys[i], hit = hits[i];
+
+        /* Reverse the direction along an axis that would leave the world */
+        dx = (unsigned int)(x + dx) >= (unsigned int)width ? -dx : dx;
+        dy = (unsigned int)(y + dy) >= (unsigned int)height ? -dy : dy;
+        int nextX = x + dx, nextY = y + dy;
+
+        /* A blocked cell reverses both directions, directions are never zero so the reversed one is not either */
+        int bounce = cellBlocked(cells, (unsigned int)(nextY * width + nextX));
+        int bounceX = bounce ? -dx : dx, bounceY = bounce ? -dy : dy;
+        int backX = x + bounceX, backY = y + bounceY;
+
+        /* Stay in place if the way back leaves the world or is blocked too, the current cell is read instead then */
+        int outside = ((unsigned int)backX >= (unsigned int)width) | ((unsigned int)backY >= (unsigned int)height);
+        int back = cellBlocked(cells, (unsigned int)((outside ? y : backY) * width + (outside ? x : backX)));
+        int stay = bounce & (outside | back);
+        int newX = bounce ? (stay ? x : backX) : nextX;
+        int newY = bounce ? (stay ? y : backY) : nextY;
+
+        /* Asteroids that already hit the ship stop there */
+        xs[i] = hit ? x : newX;
+        ys[i] = hit ? y : newY;
+        dxs[i] = hit ? dxs[i] : bounceX;
+        dys[i] = hit ? dys[i] : bounceY;
+        hits[i] = hit | ((newX == shipX) & (newY == shipY));
+    }
+}
+
+/* Slot of the 3x3 neighbourhood of the tile at a row and column that a cell is in */
+static inline int neighbourSlot(int row, int column, int x, int y) {
+    return ((y >> FIELD_TILE_SHIFT) - row + 1) * 3 + ((x >> FIELD_TILE_SHIFT) - column + 1);
+}
+
+/* Mark the cells of the asteroids of one tile in the next step's index */
+static void markTileTask(void* context, int tile) {
+    const FieldStep* step = (const FieldStep*)context;
+    const AsteroidField* field = step->field;
+    int start = field->tileStart[tile];
+    markLanes(step->next, field->x + start, field->y + start, field->tileStart[tile + 1] - start,
+              field->width, step->shared);
+}
+
+/* Move the asteroids of one tile a step and mark where they end up */
+static void stepTileTask(void* context, int tile) {
+    const FieldStep* step = (const FieldStep*)context;
+    AsteroidField* field = step->field;
+    int hits[FIELD_BLOCK];
+    int anyHit = 0;
+
+    for (int start = field->tileStart[tile]; start < field->tileStart[tile + 1]; start += FIELD_BLOCK) {
+        int count = field->tileStart[tile + 1] - start < FIELD_BLOCK ? field->tileStart[tile + 1] - start : FIELD_BLOCK;
+        int* xs = field->x + start;
+        int* ys = field->y + start;
+
+        /* After the first step an asteroid on the ship's cell has hit it and stays there */
+        for (int i = 0; i < count; i++) {
+            hits[i] = !step->firstStep & (xs[i] == step->shipX) & (ys[i] == step->shipY);
+        }
+        stepFieldLanes(xs, ys, field->dx + start, field->dy + start, hits, count,
+                       step->cells, field->width, field->height, step->shipX, step->shipY);
+        for (int i = 0; i < count; i++) {
+            anyHit |= hits[i];
+        }
+        if (step->next != NULL) {
+            markLanes(step->next, xs, ys, count, field->width, step->shared);
+        }
+    }
+    field->tileHits[tile] = anyHit;
+}
+
+/* Count the asteroids of one tile going to each of its neighbours, they cannot have gone further */
+static void countMovesTask(void* context, int tile) {
+    AsteroidField* field = (AsteroidField*)context;
+    int* moves = field->tileMoves + (size_t)tile * FIELD_NEIGHBOURS;
+    int row = tile / field->tilesX, column = tile % field->tilesX;
+    memset(moves, 0, FIELD_NEIGHBOURS * sizeof(int));
+    for (int i = field->tileStart[tile]; i < field->tileStart[tile + 1]; i++) {
+        moves[neighbourSlot(row, column, field->x[i], field->y[i])]++;
+    }
+}
+
+/* Copy the asteroids of one tile to the places the handoff gave them */
+static void handOffTileTask(void* context, int tile) {
+    AsteroidField* field = (AsteroidField*)context;
+    int* moves = field->tileMoves + (size_t)tile * FIELD_NEIGHBOURS;
+    int row = tile / field->tilesX, column = tile % field->tilesX;
+    for (int i = field->tileStart[tile]; i < field->tileStart[tile + 1]; i++) {
+        copyToSpare(field, i, moves[neighbourSlot(row, column, field->x[i], field->y[i])]++);
+    }
+}
+
+/*
+ * Turn the counts of asteroids each tile hands to its neighbours into the
+ * slots they are copied to. Every tile takes the asteroids coming to it
+ * from its neighbours in tile order, each neighbour's in their old order,
+ * which is a stable sort of all asteroids by their new tile.
+ */
+static void planHandOff(AsteroidField* field) {
+    int next = 0;
+    for (int row = 0; row < field->tilesY; row++) {
+        for (int column = 0; column < field->tilesX; column++) {
+            field->spareStart[row * field->tilesX + column] = next;
+            for (int fromRow = row - 1; fromRow <= row + 1; fromRow++) {
+                for (int fromColumn = column - 1; fromColumn <= column + 1; fromColumn++) {
+                    if (fromRow < 0 || fromRow >= field->tilesY || fromColumn < 0 || fromColumn >= field->tilesX) {
+                        continue;
+                    }
+                    int from = fromRow * field->tilesX + fromColumn;
+                    int* slot = &field->tileMoves[(size_t)from * FIELD_NEIGHBOURS +
+                                                  (row - fromRow + 1) * 3 + (column - fromColumn + 1)];
+                    int count = *slot;
+                    *slot = next;
+                    next += count;
+                }
+            }
+        }
+    }
+    field->spareStart[field->tilesX * field->tilesY] = next;
+}
+
+/* Move every asteroid the given number of steps on the thread pool, returns 1 if one hit the ship */
+int stepAsteroidField(AsteroidField* field, int steps, int shipX, int shipY) {
+    int tiles = field->tilesX * field->tilesY;
+    size_t bytes = indexWords(field) * sizeof(unsigned int);
+    int anyHit = 0;
+    if (steps <= 0) {
+        return 0;
+    }
+
+    /* Asteroids added or moved without the field are sorted into their tiles once, before the first step */
+    if (field->unsorted) {
+        sortAsteroidField(field);
+    }
+
+    /* Mark where every asteroid starts in the first step's index */
+    FieldStep step = {field, NULL, field->stepCells[0], 1, workerThreads() > 1, shipX, shipY};
+    memcpy(step.next, field->cells, bytes);
+    runParallel(tiles, markTileTask, &step);
+
+    for (int s = 0; s < steps; s++) {
+        /* Hand the asteroids to the tiles they are in before they could go past a neighbouring one */
+        if (field->drift == FIELD_TILE_SIZE) {
+            runParallel(tiles, countMovesTask, field);
+            planHandOff(field);
+            runParallel(tiles, handOffTileTask, field);
+            swapSpares(field);
+            field->drift = 0;
+        }
+
+        /* Every asteroid moves against where the others were before the step, while the next index is built */
+        step.cells = field->stepCells[s & 1];
+        step.next = s + 1 < steps ? field->stepCells[(s + 1) & 1] : NULL;
+        if (step.next != NULL) {
+            memcpy(step.next, field->cells, bytes);
+        }
+        step.firstStep = s == 0;
+        runParallel(tiles, stepTileTask, &step);
+        for (int t = 0; t < tiles; t++) {
+            anyHit |= field->tileHits[t];
+        }
+        field->drift++;
+    }
+    return anyHit != 0;
+}
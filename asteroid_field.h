@@ -0,0 +1,73 @@
+/**
+ * SpaceXplorer Asteroid Field Header
+ *
+ * This header defines the asteroids of a game, stored as separate arrays
+ * of x, y, dx and dy so a turn of movement runs over all of them as one
+ * vector loop. Obstacles are found through an occupancy index of one bit
+ * per cell. Asteroids bounce off each other like off obstacles, so before
+ * every step a copy of the index is made with the cell of every asteroid
+ * marked as well, and all asteroids move against that copy at once.
+ *
+ * The arrays are kept sorted by the square tile of the world each asteroid
+ * is in, and the tiles are moved in parallel on the thread pool. Once the
+ * asteroids may have moved a tile width since they were sorted, so one can
+ * at most be in a neighbouring tile, they are handed to the tiles they are
+ * in now in a fixed order. The order of the arrays, and so every result, is
+ * the same for any number of threads.
+ */
+
+#ifndef SPACEXPLORER_ASTEROID_FIELD_H
+#define SPACEXPLORER_ASTEROID_FIELD_H
+
+/* Tiles are 1 << FIELD_TILE_SHIFT cells wide and high */
+#define FIELD_TILE_SHIFT 6
+
+/* Arena the arrays are allocated from */
+#include "arena.h"
+
+/**
+ * Asteroid field
+ * Asteroid i is at (x[i], y[i]) moving by (dx[i], dy[i]) each step, the
+ * asteroids that were in tile t when they were last sorted are numbers
+ * tileStart[t] to tileStart[t + 1] - 1
+ */
+typedef struct {
+    int count;              /* Number of asteroids */
+    int capacity;           /* Number of asteroids the arrays have room for, always more than count */
+    int* x;                 /* X-coordinates */
+    int* y;                 /* Y-coordinates */
+    int* dx;                /* Horizontal directions, -1, 0 or 1 */
+    int* dy;                /* Vertical directions, -1, 0 or 1 */
+    int* id;                /* Order each asteroid was placed in, kept when it changes tiles */
+    int width;              /* Width of the world */
+    int height;             /* Height of the world */
+    unsigned int* cells;    /* Occupancy index of the obstacles, a bit per cell */
+    unsigned int* stepCells[2]; /* Index with the asteroids marked, read by one step while the next one's is built */
+    int tilesX;             /* Number of tile columns */
+    int tilesY;             /* Number of tile rows */
+    int* tileStart;         /* First asteroid of each tile, one entry more than there are tiles */
+    int* tileMoves;         /* Asteroids each tile hands to each of its 3x3 neighbours, then where they go */
+    int* tileHits;          /* Flag per tile set if one of its asteroids hit the ship in the step */
+    int drift;              /* Steps taken since the asteroids were last sorted into their tiles */
+    int unsorted;           /* Flag set when asteroids were added or moved since the last sort, the next step sorts them first */
+    int* spare[5];          /* Arrays the handoff copies x, y, dx, dy and id into, then swaps with them */
+    int* spareStart;        /* tileStart being built by the handoff */
+    Arena* arena;           /* Arena the arrays come from, NULL for the heap */
+} AsteroidField;
+
+/* Allocate a field of asteroids for a world with no obstacles from an arena or the heap, returns 0 if out of memory */
+int initAsteroidField(AsteroidField* field, Arena* arena, int count, int width, int height);
+/* Free the arrays of a field, the ones from an arena go with the arena */
+void freeAsteroidField(AsteroidField* field);
+/* Add an asteroid after the last one placed, sorted into its tile by the next step, returns 0 if out of memory */
+int addFieldAsteroid(AsteroidField* field, int x, int y, int dx, int dy);
+/* Mark a cell of the occupancy index as an obstacle */
+void markFieldObstacle(AsteroidField* field, int x, int y);
+/* Clear every obstacle from the occupancy index */
+void clearFieldObstacles(AsteroidField* field);
+/* Sort the asteroids by tile after they were placed or moved without the field */
+void sortAsteroidField(AsteroidField* field);
+/* Move every asteroid the given number of steps on the thread pool, returns 1 if one hit the ship */
+int stepAsteroidField(AsteroidField* field, int steps, int shipX, int shipY);
+
+#endif /* SPACEXPLORER_ASTEROID_FIELD_H */
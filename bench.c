@@ -0,0 +1,516 @@
+/**
+ * SpaceXplorer Benchmarks
+ * Times the hot game functions over a range of world sizes and entity
+ * counts and writes the results as JSON, so runs of different versions
+ * can be compared
+ *
+ * Usage: spacexplorer_bench [--sizes N,N,...] [--asteroids N,N,...] [--obstacles N] [--junk N]
+ *                           [--min-time MS] [--filter NAME] [--output FILE]
+ *                           [--threads N] [--scaling]
+ */
+
+/* Standard input/output functions (printf, fprintf, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, qsort, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (strcmp, strstr, etc.) */
+#include <string.h>
+/* Game-specific declarations and structures */
+#include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Monotonic clock for the measurements */
+#include "timing.h"
+/* Number of threads the asteroid field is moved on */
+#include "thread_pool.h"
+/* Procedural placement of obstacles and junk */
+#include "worldgen.h"
+/* Cells the ship can reach from where it starts */
+#include "reachability.h"
+/* Worlds read from level files */
+#include "level.h"
+/* Bit-packed copies of a game's board */
+#include "compact_game.h"
+
+/* Number of timed runs of every benchmark, the median is reported */
+#define BENCH_REPETITIONS 5
+/* Largest number of world sizes or asteroid counts accepted on the command line */
+#define BENCH_MAX_SIZES 16
+/* Seed used for every generated world so runs are comparable */
+#define BENCH_SEED 12345
+/* Events kept pending on the wheel of the event benchmark */
+#define BENCH_PENDING_EVENTS 32768
+/* Recently scheduled events the event benchmark cancels and schedules again */
+#define BENCH_CANCELLED_EVENTS 64
+/* Leaderboard file written by the leaderboard benchmarks */
+#define BENCH_LEADERBOARD_FILE "spacexplorer_bench_leaderboard.txt"
+/* Level file written by the level benchmark */
+#define BENCH_LEVEL_FILE "spacexplorer_bench_level.txt"
+
+/**
+ * Benchmark case
+ * World size and entity counts the game is set up with
+ */
+typedef struct {
+    int size;           /* Width and height of the square world */
+    int asteroids;      /* Number of asteroids */
+    int obstacles;      /* Number of obstacles */
+    int junk;           /* Number of junk items */
+} BenchCase;
+
+/* Function timed by a benchmark, runs the given number of operations on a prepared game */
+typedef void (*BenchFunction)(Game* game, long long iterations);
+/* Untimed preparation of a benchmark, sets up the game it runs on and any files it reads */
+typedef void (*BenchSetup)(Game* game);
+
+/* Value every benchmark feeds its results into so the work is not optimized away */
+static volatile long long benchSink = 0;
+/* Output of the game being benchmarked */
+static OutputBuffer benchOutput;
+/* Minimum duration of one timed run in nanoseconds */
+static long long minRunNanos = 20000000LL;
+/* Only benchmarks whose name contains this text are run, NULL runs all */
+static const char* nameFilter = NULL;
+/* Where the JSON results are written */
+static FILE* results = NULL;
+/* Number of results written so far */
+static int resultCount = 0;
+
+/* Apply a benchmark case to the game settings, entity counts are clamped like a config file */
+static void configureCase(BenchCase* benchCase) {
+    setDefaultConfig(&gameConfig);
+    gameConfig.worldWidth = benchCase->size;
+    gameConfig.worldHeight = benchCase->size;
+    gameConfig.asteroidCount = benchCase->asteroids;
+    gameConfig.obstacleCount = benchCase->obstacles;
+    gameConfig.junkCounts[MEDIUM] = benchCase->junk;
+    gameConfig.seed = BENCH_SEED;
+    validateConfig(&gameConfig);
+
+    /* Report the counts actually used */
+    benchCase->asteroids = gameConfig.asteroidCount;
+    benchCase->obstacles = gameConfig.obstacleCount;
+    benchCase->junk = gameConfig.junkCounts[MEDIUM];
+}
+
+/* Create a game for the current settings with its output going to memory */
+static void prepareGame(Game* game) {
+    memset(game, 0, sizeof(*game));
+    strcpy(game->playerName, "bench");
+    game->difficulty = MEDIUM;
+    game->output = &benchOutput;
+    setupGame(game);
+}
+
+/* Place every object of a new world, the part of initGame after the prompts */
+static void benchSetupGame(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        Game fresh;
+        prepareGame(&fresh);
+        benchSink += fresh.ship.position.x;
+        cleanupGame(&fresh);
+    }
+    (void)game;
+}
+
+/* Generate the obstacles and junk of a world procedurally, on cells the prepared game left free */
+static void benchGenerateWorld(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        GeneratedWorld generated;
+        if (generateWorld(&generated, game->world, game->worldWidth, game->worldHeight, (unsigned int)i,
+                          game->impassableCount, game->junkCount)) {
+            benchSink += generated.obstacleCount + generated.junkCount;
+            freeGeneratedWorld(&generated);
+        }
+    }
+}
+
+/* Fill the cells the ship can reach on its fuel, then the ones it could reach with no limit */
+static void benchFloodFill(Game* game, long long iterations) {
+    ReachMap map;
+    if (!initReachMap(&map, game->worldWidth, game->worldHeight)) {
+        return;
+    }
+    int moves = game->ship.fuel / gameConfig.fuelConsumption[game->difficulty];
+    for (long long i = 0; i < iterations; i++) {
+        floodFillReach(&map, game->obstacleMap, game->ship.position.x, game->ship.position.y, (i & 1) ? -1 : moves);
+        benchSink += cellReached(&map, 0, 0);
+    }
+    freeReachMap(&map);
+}
+
+/* Prepare a world of the case and draw it into the level file of the level benchmark */
+static void setupLevelFile(Game* game) {
+    prepareGame(game);
+    FILE* file = fopen(BENCH_LEVEL_FILE, "w");
+    if (file == NULL) {
+        return;
+    }
+    for (int y = 0; y < game->worldHeight; y++) {
+        fwrite(game->world[y], 1, (size_t)game->worldWidth, file);
+        fputc('\n', file);
+    }
+    fclose(file);
+    LEVEL_FILE = BENCH_LEVEL_FILE;
+}
+
+/* Set up games from the level file drawn from the prepared game's world */
+static void benchLoadLevel(Game* game, long long iterations) {
+    (void)game;
+    if (LEVEL_FILE == NULL) {
+        return;
+    }
+    for (long long i = 0; i < iterations; i++) {
+        Game fresh;
+        prepareGame(&fresh);
+        benchSink += fresh.impassableCount + fresh.junkCount;
+        cleanupGame(&fresh);
+    }
+}
+
+/* Draw the world into a memory buffer */
+static void benchRenderWorld(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        clearOutputBuffer(&benchOutput);
+        renderWorld(game);
+        benchSink += (long long)benchOutput.length;
+    }
+}
+
+/* Move every asteroid for one turn */
+static void benchMoveAsteroid(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        game->isGameOver = 0;
+        moveAsteroid(game);
+        benchSink += game->asteroids.x[0];
+    }
+}
+
+/* Move every asteroid for one turn with the kernel selectKernels picked for the game */
+static void benchAsteroidField(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        game->isGameOver = 0;
+        game->moveAsteroids(game);
+        benchSink += game->asteroids.x[0];
+    }
+}
+
+/* Move the ship back and forth, including the asteroid moves and collision checks of each turn */
+static void benchMoveSpaceship(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        game->isGameOver = 0;
+        game->score = 0;
+        game->ship.fuel = game->ship.maxFuel;
+        moveSpaceship(game, (i & 1) ? -1 : 1, 0);
+        benchSink += game->ship.position.x;
+    }
+}
+
+/* Prepare a streamed world of the case, with its sector thread and sector file */
+static void setupStreamedWorld(Game* game) {
+    gameConfig.streamingWorld = 1;
+    prepareGame(game);
+    gameConfig.streamingWorld = 0;
+}
+
+/* Fly the ship across a streamed world, moving the map and loading sectors as it goes */
+static void benchStreamedFlight(Game* game, long long iterations) {
+    /* A random walk drifting right, which never stays stuck behind obstacles */
+    static const int moves[8][2] = {{1, 0}, {1, 0}, {1, 0}, {1, 0}, {0, 1}, {0, -1}, {-1, 0}, {1, 0}};
+    unsigned int state = 2463534242u;
+    for (long long i = 0; i < iterations; i++) {
+        game->isGameOver = 0;
+        game->score = 0;
+        game->ship.fuel = game->ship.maxFuel;
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        moveSpaceship(game, moves[state % 8][0], moves[state % 8][1]);
+        benchSink += game->originX;
+    }
+}
+
+/* Check the ship against every junk item */
+static void benchCheckCollisions(Game* game, long long iterations) {
+    for (long long i = 0; i < iterations; i++) {
+        game->isGameOver = 0;
+        game->score = 0;
+        checkCollisions(game);
+        benchSink += game->isGameOver;
+    }
+}
+
+/* Pack the board of the prepared game into its compact state and unpack it again in place */
+static void benchCompactGame(Game* game, long long iterations) {
+    CompactGame* compact = (CompactGame*)malloc(packedGameSize(game));
+    if (compact == NULL) {
+        return;
+    }
+    for (long long i = 0; i < iterations; i++) {
+        packGame(game, compact);
+        unpackGame(game, compact);
+        benchSink += compact->bytes;
+    }
+    free(compact);
+}
+
+/* Fill a leaderboard with the maximum number of entries */
+static int fillLeaderboard(LeaderboardEntry leaderboard[]) {
+    for (int i = 0; i < MAX_LEADERBOARD_ENTRIES; i++) {
+        snprintf(leaderboard[i].playerName, MAX_NAME_LENGTH, "Player%d", i);
+        leaderboard[i].score = 1000 - i * 50;
+        leaderboard[i].difficulty = (Difficulty)(i % 3);
+    }
+    return MAX_LEADERBOARD_ENTRIES;
+}
+
+/* Write a full leaderboard file */
+static void benchSaveLeaderboard(Game* game, long long iterations) {
+    LeaderboardEntry leaderboard[MAX_LEADERBOARD_ENTRIES];
+    int count = fillLeaderboard(leaderboard);
+    for (long long i = 0; i < iterations; i++) {
+        saveLeaderboard(leaderboard, count);
+    }
+    (void)game;
+}
+
+/* Write the full leaderboard file the load benchmark reads */
+static void setupLeaderboardFile(Game* game) {
+    LeaderboardEntry leaderboard[MAX_LEADERBOARD_ENTRIES];
+    saveLeaderboard(leaderboard, fillLeaderboard(leaderboard));
+    (void)game;
+}
+
+/* Read a full leaderboard file */
+static void benchLoadLeaderboard(Game* game, long long iterations) {
+    LeaderboardEntry leaderboard[MAX_LEADERBOARD_ENTRIES];
+    for (long long i = 0; i < iterations; i++) {
+        int count;
+        loadLeaderboard(leaderboard, &count);
+        benchSink += count;
+    }
+    (void)game;
+}
+
+/* Wheel of the event benchmark, filled on its first run and kept so every run sees the same load */
+static EventWheel benchWheel;
+/* Handles of the events the event benchmark cancels next */
+static EventHandle benchCancelled[BENCH_CANCELLED_EVENTS];
+/* Random state of the event benchmark's delays */
+static unsigned int benchEventState = BENCH_SEED;
+
+/* Random delay of up to 65535 turns, spread over the levels of the wheel */
+static int benchEventDelay(void) {
+    benchEventState ^= benchEventState << 13;
+    benchEventState ^= benchEventState >> 17;
+    benchEventState ^= benchEventState << 5;
+    return 1 + (int)(benchEventState & 0xFFFF);
+}
+
+/* Turns of a wheel with many pending events, each cancelling and scheduling one and handling the due ones */
+static void benchEventWheel(Game* game, long long iterations) {
+    if (benchWheel.capacity == 0) {
+        initEventWheel(&benchWheel, NULL);
+        for (int i = 0; i < BENCH_PENDING_EVENTS; i++) {
+            EventHandle handle = scheduleEvent(&benchWheel, benchEventDelay(), 0, i);
+            benchCancelled[i % BENCH_CANCELLED_EVENTS] = handle;
+        }
+    }
+    for (long long i = 0; i < iterations; i++) {
+        int slot = (int)(i % BENCH_CANCELLED_EVENTS);
+        benchSink += cancelEvent(&benchWheel, benchCancelled[slot]);
+        benchCancelled[slot] = scheduleEvent(&benchWheel, benchEventDelay(), 0, slot);
+        advanceEventWheel(&benchWheel);
+
+        /* Due events are scheduled again so the number pending stays the same */
+        int type;
+        int data;
+        while (nextDueEvent(&benchWheel, &type, &data)) {
+            benchSink += data;
+            scheduleEvent(&benchWheel, benchEventDelay(), type, data);
+        }
+    }
+    (void)game;
+}
+
+/* Compare two timings for sorting */
+static int compareTimings(const void* a, const void* b) {
+    double left = *(const double*)a;
+    double right = *(const double*)b;
+    return (left > right) - (left < right);
+}
+
+/**
+ * Time one benchmark on a case and write its result, a NULL case runs without a world
+ * The setup runs before any timing, NULL prepares a world of the case
+ */
+static void runBenchmark(const char* name, const BenchCase* benchCase, BenchSetup setup, BenchFunction function) {
+    if (nameFilter != NULL && strstr(name, nameFilter) == NULL) {
+        return;
+    }
+
+    Game game;
+    if (setup != NULL) {
+        setup(&game);
+    } else if (benchCase != NULL) {
+        prepareGame(&game);
+    }
+
+    /* Double the iterations until one run takes long enough to time reliably */
+    long long iterations = 1;
+    for (;;) {
+        long long start = currentTimeNanos();
+        function(&game, iterations);
+        long long elapsed = currentTimeNanos() - start;
+        if (elapsed >= minRunNanos || iterations >= (1LL << 40)) break;
+        iterations *= 2;
+    }
+
+    /* Repeat the timed run and keep the time per operation of each */
+    double timings[BENCH_REPETITIONS];
+    for (int r = 0; r < BENCH_REPETITIONS; r++) {
+        long long start = currentTimeNanos();
+        function(&game, iterations);
+        timings[r] = (double)(currentTimeNanos() - start) / (double)iterations;
+    }
+    qsort(timings, BENCH_REPETITIONS, sizeof(double), compareTimings);
+
+    fprintf(results, "%s    {\"name\": \"%s\"", resultCount > 0 ? ",\n" : "", name);
+    if (benchCase != NULL) {
+        fprintf(results, ", \"width\": %d, \"height\": %d, \"asteroids\": %d, \"obstacles\": %d, \"junk\": %d, \"threads\": %d",
+                benchCase->size, benchCase->size, benchCase->asteroids, benchCase->obstacles, benchCase->junk,
+                workerThreads());
+    }
+    fprintf(results, ", \"iterations\": %lld, \"ns_per_op\": %.1f, \"ns_per_op_min\": %.1f, \"ns_per_op_max\": %.1f}",
+            iterations, timings[BENCH_REPETITIONS / 2], timings[0], timings[BENCH_REPETITIONS - 1]);
+    resultCount++;
+
+    /* Progress on the console, next to the JSON */
+    if (benchCase != NULL) {
+        fprintf(stderr, "%-16s %5dx%-5d %8d asteroids %14.1f ns/op %4d threads\n", name, benchCase->size,
+                benchCase->size, benchCase->asteroids, timings[BENCH_REPETITIONS / 2], workerThreads());
+        cleanupGame(&game);
+    } else {
+        fprintf(stderr, "%-16s %-11s %12.1f ns/op\n", name, "", timings[BENCH_REPETITIONS / 2]);
+    }
+}
+
+/**
+ * Benchmark entry point
+ * Runs every benchmark on every world size and writes the JSON results
+ */
+int main(int argc, char* argv[]) {
+    int sizes[BENCH_MAX_SIZES] = {18, 64, 256, 1024};
+    int sizeCount = 4;
+    int asteroids[BENCH_MAX_SIZES] = {-1};
+    int asteroidCount = 1;
+    int obstacles = -1, junk = -1;
+    const char* outputPath = NULL;
+    int threads = 0;
+    int scaling = 0;
+
+    /* Parse command line options, entity counts default to densities matching the default world */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            sizeCount = 0;
+            for (char* item = strtok(argv[++i], ","); item != NULL && sizeCount < BENCH_MAX_SIZES;
+                 item = strtok(NULL, ",")) {
+                sizes[sizeCount++] = atoi(item);
+            }
+        } else if (strcmp(argv[i], "--asteroids") == 0 && i + 1 < argc) {
+            /* Several counts run every world size with each, to see how the cost grows with them */
+            asteroidCount = 0;
+            for (char* item = strtok(argv[++i], ","); item != NULL && asteroidCount < BENCH_MAX_SIZES;
+                 item = strtok(NULL, ",")) {
+                asteroids[asteroidCount++] = atoi(item);
+            }
+        } else if (strcmp(argv[i], "--obstacles") == 0 && i + 1 < argc) {
+            obstacles = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--junk") == 0 && i + 1 < argc) {
+            junk = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            minRunNanos = atoll(argv[++i]) * 1000000LL;
+        } else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            nameFilter = argv[++i];
+        } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            /* Threads the asteroid field is moved on, one per processor by default */
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--scaling") == 0) {
+            /* Also time the asteroid field on every number of threads up to --threads */
+            scaling = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--sizes N,N,...] [--asteroids N,N,...] [--obstacles N] [--junk N]\n"
+                            "       [--min-time MS] [--filter NAME] [--output FILE]\n"
+                            "       [--threads N] [--scaling]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    results = outputPath != NULL ? fopen(outputPath, "w") : stdout;
+    if (results == NULL) {
+        perror(outputPath);
+        return 1;
+    }
+    LEADERBOARD_FILE = BENCH_LEADERBOARD_FILE;
+    initOutputBuffer(&benchOutput);
+    setWorkerThreads(threads);
+    threads = workerThreads();
+
+    fprintf(results, "{\n  \"version\": 1,\n  \"repetitions\": %d,\n  \"min_time_ms\": %lld,\n  \"results\": [\n",
+            BENCH_REPETITIONS, minRunNanos / 1000000LL);
+
+    /* World benchmarks on every size with every asteroid count */
+    for (int s = 0; s < sizeCount; s++) {
+        for (int a = 0; a < asteroidCount; a++) {
+            int cells = sizes[s] * sizes[s];
+            BenchCase benchCase;
+            benchCase.size = sizes[s];
+            benchCase.asteroids = asteroids[a] >= 0 ? asteroids[a] : (cells / 256 > 1 ? cells / 256 : 1);
+            benchCase.obstacles = obstacles >= 0 ? obstacles : (cells / 100 > 3 ? cells / 100 : 3);
+            benchCase.junk = junk >= 0 ? junk : cells / 8;
+            configureCase(&benchCase);
+
+            runBenchmark("setupGame", &benchCase, NULL, benchSetupGame);
+            runBenchmark("generateWorld", &benchCase, NULL, benchGenerateWorld);
+            runBenchmark("floodFill", &benchCase, NULL, benchFloodFill);
+            runBenchmark("loadLevel", &benchCase, setupLevelFile, benchLoadLevel);
+            LEVEL_FILE = NULL;
+            remove(BENCH_LEVEL_FILE);
+            runBenchmark("renderWorld", &benchCase, NULL, benchRenderWorld);
+            runBenchmark("moveAsteroid", &benchCase, NULL, benchMoveAsteroid);
+            runBenchmark("asteroidField", &benchCase, NULL, benchAsteroidField);
+            runBenchmark("moveSpaceship", &benchCase, NULL, benchMoveSpaceship);
+            runBenchmark("streamedFlight", &benchCase, setupStreamedWorld, benchStreamedFlight);
+            runBenchmark("checkCollisions", &benchCase, NULL, benchCheckCollisions);
+            runBenchmark("compactGame", &benchCase, NULL, benchCompactGame);
+
+            /* The same turns on 1 to the requested number of threads, the results are identical on each */
+            if (scaling) {
+                for (int t = 1; t <= threads; t++) {
+                    setWorkerThreads(t);
+                    runBenchmark("fieldScaling", &benchCase, NULL, benchAsteroidField);
+                }
+                setWorkerThreads(threads);
+            }
+        }
+    }
+
+    /* The leaderboard always holds at most MAX_LEADERBOARD_ENTRIES entries */
+    runBenchmark("saveLeaderboard", NULL, NULL, benchSaveLeaderboard);
+    runBenchmark("loadLeaderboard", NULL, setupLeaderboardFile, benchLoadLeaderboard);
+    remove(BENCH_LEADERBOARD_FILE);
+
+    /* The cost of a turn does not depend on how many events are pending */
+    runBenchmark("eventWheel", NULL, NULL, benchEventWheel);
+    freeEventWheel(&benchWheel);
+
+    fprintf(results, "\n  ]\n}\n");
+    if (results != stdout) {
+        fclose(results);
+    }
+    freeOutputBuffer(&benchOutput);
+    stopWorkerThreads();
+    return 0;
+}
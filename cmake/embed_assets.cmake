@@ -0,0 +1,31 @@
+# Generate a C header that embeds text asset files as string constants
+#
+# Usage: cmake -DOUTPUT=<header> -DASSETS=<NAME=file|NAME=file> -P embed_assets.cmake
+
+file(WRITE ${OUTPUT}.tmp "/* Generated by cmake/embed_assets.cmake, do not edit */\n\n")
+file(APPEND ${OUTPUT}.tmp "#ifndef SPACEXPLORER_ASSETS_H\n#define SPACEXPLORER_ASSETS_H\n\n")
+
+string(REPLACE "|" ";" ASSETS "${ASSETS}")
+foreach(asset ${ASSETS})
+    # Split NAME=path into the constant name and the source file
+    string(FIND "${asset}" "=" separator)
+    string(SUBSTRING "${asset}" 0 ${separator} name)
+    math(EXPR start "${separator} + 1")
+    string(SUBSTRING "${asset}" ${start} -1 path)
+
+    # Escape the text so it can be written as a C string literal, one line per line
+    file(READ ${path} content)
+    string(REPLACE "\\" "\\\\" content "${content}")
+    string(REPLACE "\"" "\\\"" content "${content}")
+    string(REPLACE "\r" "" content "${content}")
+    string(REPLACE "\n" "\\n\"\n    \"" content "${content}")
+
+    get_filename_component(filename ${path} NAME)
+    file(APPEND ${OUTPUT}.tmp "/* Contents of assets/${filename} */\nstatic const char ${name}[] =\n    \"${content}\";\n\n")
+endforeach()
+
+file(APPEND ${OUTPUT}.tmp "#endif /* SPACEXPLORER_ASSETS_H */\n")
+
+# Only touch the header when the contents changed, to avoid needless rebuilds
+file(COPY_FILE ${OUTPUT}.tmp ${OUTPUT} ONLY_IF_DIFFERENT)
+file(REMOVE ${OUTPUT}.tmp)
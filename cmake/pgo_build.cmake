@@ -0,0 +1,38 @@
+# Build spaceXplorerV2 with profile-guided and link-time optimization
+#
+# Stage one builds the game and the headless simulator instrumented and runs
+# the training workload, which leaves a profile next to every object file.
+# Stage two reconfigures the same tree to compile with that profile and LTO,
+# so the object paths and therefore the profile file names match.
+#
+# Usage: cmake -DSOURCE_DIR=<src> -DBINARY_DIR=<dir> -DC_COMPILER=<cc> -DOUTPUT=<exe> -P pgo_build.cmake
+
+# Run a command and stop the build if it fails
+function(run_step description)
+    message(STATUS "PGO: ${description}")
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "PGO: ${description} failed")
+    endif()
+endfunction()
+
+# Stage one, instrumented build and training run
+run_step("configuring the instrumented build"
+    ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${BINARY_DIR} -DCMAKE_C_COMPILER=${C_COMPILER}
+    -DCMAKE_BUILD_TYPE=Release -DSPACEXPLORER_PGO=OFF -DSPACEXPLORER_PGO_STAGE=generate)
+run_step("building the instrumented simulator" ${CMAKE_COMMAND} --build ${BINARY_DIR} --target spacexplorer_sim)
+
+# Profiles of an earlier run would be added to, start from a clean slate
+file(GLOB_RECURSE old_profiles ${BINARY_DIR}/*.gcda)
+if(old_profiles)
+    file(REMOVE ${old_profiles})
+endif()
+run_step("running the training workload" ${CMAKE_COMMAND} --build ${BINARY_DIR} --target spacexplorer_pgo_train)
+
+# Stage two, optimized rebuild with the profile
+run_step("configuring the optimized build"
+    ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${BINARY_DIR} -DSPACEXPLORER_PGO_STAGE=use)
+run_step("building the optimized game" ${CMAKE_COMMAND} --build ${BINARY_DIR} --target spaceXplorerV2)
+
+get_filename_component(name ${OUTPUT} NAME)
+file(COPY_FILE ${BINARY_DIR}/${name} ${OUTPUT})
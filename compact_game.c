@@ -0,0 +1,305 @@
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Compact game declarations */
+#include "compact_game.h"
+
+/* Bits of each word of the bitboards */
+#define COMPACT_BITS_PER_WORD 32
+
+/**
+ * Compact game layout
+ * Where each array starts in the block of a compact game
+ */
+typedef struct {
+    size_t asteroids;   /* Asteroid positions */
+    size_t junk;        /* Junk positions */
+    size_t obstacles;   /* Obstacle bitboard, a bit per cell */
+    size_t collected;   /* Junk collected bits */
+    size_t directions;  /* Asteroid direction nibbles, dx + 1 in the low two bits and dy + 1 in the high two */
+    size_t types;       /* Junk type nibbles */
+    size_t bytes;       /* Size of the block, a whole number of words so states of a batch stay aligned */
+} CompactLayout;
+
+/* Return the number of words of a bitset of the given number of bits */
+static size_t bitWords(size_t bits) {
+    return (bits + COMPACT_BITS_PER_WORD - 1) / COMPACT_BITS_PER_WORD;
+}
+
+/* Work out where the arrays of a compact game of a world size and entity counts start */
+static CompactLayout compactLayout(int worldWidth, int worldHeight, int asteroidCount, int junkCount) {
+    CompactLayout layout;
+    layout.asteroids = sizeof(CompactGame);
+    layout.junk = layout.asteroids + (size_t)asteroidCount * sizeof(CompactPosition);
+    layout.obstacles = layout.junk + (size_t)junkCount * sizeof(CompactPosition);
+    layout.collected = layout.obstacles + bitWords((size_t)worldWidth * worldHeight) * sizeof(unsigned int);
+    layout.directions = layout.collected + bitWords((size_t)junkCount) * sizeof(unsigned int);
+    layout.types = layout.directions + ((size_t)asteroidCount + 1) / 2;
+    layout.bytes = (layout.types + ((size_t)junkCount + 1) / 2 + sizeof(unsigned int) - 1) & ~(sizeof(unsigned int) - 1);
+    return layout;
+}
+
+/* Work out where the arrays of a compact game start */
+static CompactLayout layoutOf(const CompactGame* compact) {
+    return compactLayout(compact->worldWidth, compact->worldHeight, (int)compact->asteroidCount, (int)compact->junkCount);
+}
+
+/* Return a nibble of an array of two per byte */
+static int getNibble(const unsigned char* nibbles, int index) {
+    return (nibbles[index / 2] >> (index % 2 * 4)) & 15;
+}
+
+/* Set a nibble of a zeroed array of two per byte */
+static void setNibble(unsigned char* nibbles, int index, int value) {
+    nibbles[index / 2] |= (unsigned char)((value & 15) << (index % 2 * 4));
+}
+
+/* Return a bit of a bitset */
+static int getBit(const unsigned int* bits, size_t index) {
+    return (int)(bits[index / COMPACT_BITS_PER_WORD] >> (index % COMPACT_BITS_PER_WORD)) & 1;
+}
+
+/* Set a bit of a bitset */
+static void setBit(unsigned int* bits, size_t index) {
+    bits[index / COMPACT_BITS_PER_WORD] |= 1u << (index % COMPACT_BITS_PER_WORD);
+}
+
+/* Return the size of the block of a compact game of a world size and entity counts */
+size_t compactGameSize(int worldWidth, int worldHeight, int asteroidCount, int junkCount) {
+    return compactLayout(worldWidth, worldHeight, asteroidCount, junkCount).bytes;
+}
+
+/* Return the size of the block a game packs into, 0 for a streamed game */
+size_t packedGameSize(const Game* game) {
+    if (game->sectors != NULL) {
+        return 0;
+    }
+    return compactGameSize(game->worldWidth, game->worldHeight, game->asteroids.count, game->junkCount);
+}
+
+/* Pack the board of a game into a block of packedGameSize bytes, returns 0 for a streamed game */
+int packGame(const Game* game, CompactGame* compact) {
+    /* The map of a streamed world is a window into a world with no size */
+    size_t bytes = packedGameSize(game);
+    if (bytes == 0) {
+        return 0;
+    }
+    memset(compact, 0, bytes);
+    compact->bytes = (unsigned int)bytes;
+    compact->worldWidth = (unsigned short)game->worldWidth;
+    compact->worldHeight = (unsigned short)game->worldHeight;
+    compact->ship.x = (unsigned short)game->ship.position.x;
+    compact->ship.y = (unsigned short)game->ship.position.y;
+    compact->difficulty = (unsigned char)game->difficulty;
+    compact->flags = (unsigned char)((game->isGameOver ? COMPACT_GAME_OVER : 0) | (game->hasWon ? COMPACT_WON : 0));
+    compact->shieldTurns = game->shielded ? eventTurnsLeft(&game->events, game->shieldExpiry) : 0;
+    compact->fuel = game->ship.fuel;
+    compact->maxFuel = game->ship.maxFuel;
+    compact->health = game->ship.health;
+    compact->maxHealth = game->ship.maxHealth;
+    compact->metal = game->ship.metal;
+    compact->plastic = game->ship.plastic;
+    compact->electronics = game->ship.electronics;
+    compact->fuelCells = game->ship.fuelCells;
+    compact->score = game->score;
+    compact->asteroidCount = (unsigned int)game->asteroids.count;
+    compact->junkCount = (unsigned int)game->junkCount;
+
+    CompactLayout layout = layoutOf(compact);
+    char* block = (char*)compact;
+
+    /* The field is kept in tile order, so the asteroids are stored by placement number */
+    const AsteroidField* field = &game->asteroids;
+    CompactPosition* asteroids = (CompactPosition*)(block + layout.asteroids);
+    unsigned char* directions = (unsigned char*)(block + layout.directions);
+    for (int a = 0; a < field->count; a++) {
+        int id = field->id[a];
+        asteroids[id].x = (unsigned short)field->x[a];
+        asteroids[id].y = (unsigned short)field->y[a];
+        setNibble(directions, id, (field->dx[a] + 1) | (field->dy[a] + 1) << 2);
+    }
+
+    /* The junk keeps the order of its archetype, none of it collected */
+    const Archetype* junk = &game->entities[ENTITY_JUNK];
+    const Position* junkPositions = ARCHETYPE_COLUMN(junk, COMPONENT_POSITION, Position);
+    const Collectible* collectibles = ARCHETYPE_COLUMN(junk, COMPONENT_COLLECTIBLE, Collectible);
+    CompactPosition* junkCells = (CompactPosition*)(block + layout.junk);
+    unsigned char* types = (unsigned char*)(block + layout.types);
+    for (int i = 0; i < game->junkCount; i++) {
+        junkCells[i].x = (unsigned short)junkPositions[i].x;
+        junkCells[i].y = (unsigned short)junkPositions[i].y;
+        setNibble(types, i, collectibles[i].type);
+    }
+
+    /* Obstacles all look the same, so only their cells are kept */
+    const Archetype* obstacles = &game->entities[ENTITY_OBSTACLES];
+    const Position* obstaclePositions = ARCHETYPE_COLUMN(obstacles, COMPONENT_POSITION, Position);
+    unsigned int* board = (unsigned int*)(block + layout.obstacles);
+    for (int i = 0; i < game->impassableCount; i++) {
+        setBit(board, (size_t)obstaclePositions[i].y * game->worldWidth + obstaclePositions[i].x);
+    }
+    return 1;
+}
+
+/* Set the board of a game to a compact game, reusing its world if the size matches, returns 0 if out of memory */
+int unpackGame(Game* game, const CompactGame* compact) {
+    CompactLayout layout = layoutOf(compact);
+    const char* block = (const char*)compact;
+    const unsigned int* board = (const unsigned int*)(block + layout.obstacles);
+    const unsigned int* collected = (const unsigned int*)(block + layout.collected);
+    int width = compact->worldWidth;
+    int height = compact->worldHeight;
+    size_t cells = (size_t)width * height;
+
+    /* Count what is placed, to make room for it at once */
+    int obstacleCount = 0;
+    for (size_t w = 0; w < bitWords(cells); w++) {
+        obstacleCount += __builtin_popcount(board[w]);
+    }
+    int junkCount = 0;
+    for (int i = 0; i < (int)compact->junkCount; i++) {
+        junkCount += !getBit(collected, (size_t)i);
+    }
+
+    /* A world of another size is created again, otherwise its memory and its events stay */
+    int recreated = game->world == NULL || game->worldWidth != width || game->worldHeight != height;
+    if (recreated) {
+        if (game->world != NULL) {
+            cleanupGame(game);
+        }
+        game->worldWidth = width;
+        game->worldHeight = height;
+        game->impassableCount = obstacleCount;
+        game->junkCount = junkCount;
+        createWorld(game);
+    }
+
+    /* Clear the board, everything on it is placed again */
+    memset(game->obstacleMap, 0, cells);
+    clearFieldObstacles(&game->asteroids);
+    clearFogOfWar(&game->fog);
+    for (int kind = 0; kind < ENTITY_KINDS; kind++) {
+        clearArchetype(&game->entities[kind]);
+    }
+    game->impassableCount = 0;
+    game->junkCount = 0;
+    if (!reserveEntities(game, obstacleCount, junkCount)) {
+        return 0;
+    }
+
+    /* The field's arrays are allocated again if asteroids were added since */
+    AsteroidField* field = &game->asteroids;
+    int asteroidCount = (int)compact->asteroidCount;
+    if (field->capacity <= asteroidCount) {
+        Arena* arena = field->arena;
+        freeAsteroidField(field);
+        if (!initAsteroidField(field, arena, asteroidCount, width, height)) {
+            return 0;
+        }
+    }
+
+    game->ship.position.x = compact->ship.x;
+    game->ship.position.y = compact->ship.y;
+    game->ship.fuel = compact->fuel;
+    game->ship.maxFuel = compact->maxFuel;
+    game->ship.health = compact->health;
+    game->ship.maxHealth = compact->maxHealth;
+    game->ship.metal = compact->metal;
+    game->ship.plastic = compact->plastic;
+    game->ship.electronics = compact->electronics;
+    game->ship.fuelCells = compact->fuelCells;
+    game->score = compact->score;
+    game->difficulty = (Difficulty)compact->difficulty;
+    game->isGameOver = (compact->flags & COMPACT_GAME_OVER) != 0;
+    game->hasWon = (compact->flags & COMPACT_WON) != 0;
+
+    /* A recreated world starts the repeating events of its difficulty over */
+    if (recreated) {
+        scheduleRepeatingEvents(game);
+    }
+
+    /* The shield drops when the packed game's would have, replacing any expiry the game had pending */
+    cancelEvent(&game->events, game->shieldExpiry);
+    memset(&game->shieldExpiry, 0, sizeof(game->shieldExpiry));
+    game->shielded = compact->shieldTurns > 0;
+    if (game->shielded) {
+        game->shieldExpiry = scheduleEvent(&game->events, compact->shieldTurns, EVENT_SHIELD_EXPIRES, 0);
+    }
+
+    /* Mark every cell as free, then put the ship and the asteroids on the map as a new world does */
+    for (int y = 0; y < height; y++) {
+        memset(game->world[y], '.', (size_t)width);
+    }
+    game->world[game->ship.position.y][game->ship.position.x] = 'S';
+    field->count = asteroidCount;
+    for (int a = 0; a < asteroidCount; a++) {
+        Asteroid asteroid;
+        compactAsteroid(compact, a, &asteroid);
+        field->x[a] = asteroid.position.x;
+        field->y[a] = asteroid.position.y;
+        field->dx[a] = asteroid.direction.x;
+        field->dy[a] = asteroid.direction.y;
+        field->id[a] = a;
+        game->world[asteroid.position.y][asteroid.position.x] = asteroid.symbol;
+    }
+    sortAsteroidField(field);
+
+    /* Obstacles claim their cells in row order, then the junk still there in its order */
+    for (size_t cell = 0; cell < cells; cell++) {
+        if (getBit(board, cell)) {
+            placeObstacle(game, (int)(cell % width), (int)(cell / width));
+        }
+    }
+    for (int i = 0; i < (int)compact->junkCount; i++) {
+        if (!compactJunkCollected(compact, i)) {
+            Position position = compactJunkPosition(compact, i);
+            placeJunk(game, position.x, position.y, compactJunkType(compact, i));
+        }
+    }
+
+    /* Look around from the ship and pick the kernels for the asteroids there are now */
+    updateSight(game);
+    selectKernels(game);
+    return 1;
+}
+
+/* Return 1 if a cell of a compact game is an obstacle */
+int compactObstacle(const CompactGame* compact, int x, int y) {
+    const unsigned int* board = (const unsigned int*)((const char*)compact + layoutOf(compact).obstacles);
+    return getBit(board, (size_t)y * compact->worldWidth + x);
+}
+
+/* Read the asteroid placed at an index of a compact game */
+void compactAsteroid(const CompactGame* compact, int index, Asteroid* asteroid) {
+    CompactLayout layout = layoutOf(compact);
+    const CompactPosition* asteroids = (const CompactPosition*)((const char*)compact + layout.asteroids);
+    int direction = getNibble((const unsigned char*)compact + layout.directions, index);
+    asteroid->position.x = asteroids[index].x;
+    asteroid->position.y = asteroids[index].y;
+    asteroid->direction.x = (direction & 3) - 1;
+    asteroid->direction.y = (direction >> 2) - 1;
+    asteroid->symbol = 'A';
+}
+
+/* Return the position of a junk item of a compact game */
+Position compactJunkPosition(const CompactGame* compact, int index) {
+    const CompactPosition* junk = (const CompactPosition*)((const char*)compact + layoutOf(compact).junk);
+    Position position = {junk[index].x, junk[index].y};
+    return position;
+}
+
+/* Return the type of a junk item of a compact game */
+JunkType compactJunkType(const CompactGame* compact, int index) {
+    return (JunkType)getNibble((const unsigned char*)compact + layoutOf(compact).types, index);
+}
+
+/* Return 1 if a junk item of a compact game was collected */
+int compactJunkCollected(const CompactGame* compact, int index) {
+    const unsigned int* collected = (const unsigned int*)((const char*)compact + layoutOf(compact).collected);
+    return getBit(collected, (size_t)index);
+}
+
+/* Mark a junk item of a compact game as collected */
+void collectCompactJunk(CompactGame* compact, int index) {
+    unsigned int* collected = (unsigned int*)((char*)compact + layoutOf(compact).collected);
+    setBit(collected, (size_t)index);
+}
@@ -0,0 +1,87 @@
+/**
+ * SpaceXplorer Compact Game Header
+ *
+ * This header defines a bit-packed copy of the state of a game's board:
+ * the ship, the asteroids, the obstacles and the junk, with 16-bit
+ * coordinates, asteroid directions and junk types in nibbles, the
+ * obstacles in a bitboard of one bit per cell and a bit per junk item
+ * set once it is collected. A compact game is one block with its arrays
+ * following the header, so a batch of them is laid out back to back and
+ * a state is copied with memcpy. Packing a game and unpacking it again
+ * gives the same board. The turns left on the ship's shield are kept
+ * with it. The other timed events, the fog's explored cells and streamed
+ * worlds are not part of it: a reused world keeps its repeating events
+ * and a recreated one starts them over.
+ */
+
+#ifndef SPACEXPLORER_COMPACT_GAME_H
+#define SPACEXPLORER_COMPACT_GAME_H
+
+/* Size type for the blocks */
+#include <stddef.h>
+/* Game structures the state is packed from */
+#include "game.h"
+
+/* Compact game flag, the game has ended */
+#define COMPACT_GAME_OVER 1
+/* Compact game flag, the player won */
+#define COMPACT_WON 2
+
+/**
+ * Compact cell position
+ * World sizes are at most WORLD_MAX_SIZE, so both coordinates fit 16 bits
+ */
+typedef struct {
+    unsigned short x;   /* X-coordinate */
+    unsigned short y;   /* Y-coordinate */
+} CompactPosition;
+
+/**
+ * Compact game
+ * Followed in its block by the asteroid positions, the junk positions,
+ * the obstacle bitboard, the junk collected bits, the asteroid direction
+ * nibbles and the junk type nibbles. Asteroids are in placement order
+ */
+typedef struct {
+    unsigned int bytes;             /* Size of the block, where the next state of a batch starts */
+    unsigned short worldWidth;      /* Width of the game world */
+    unsigned short worldHeight;     /* Height of the game world */
+    CompactPosition ship;           /* Location of the ship */
+    unsigned char difficulty;       /* Game difficulty */
+    unsigned char flags;            /* COMPACT_* flags */
+    int fuel;                       /* Current fuel level */
+    int maxFuel;                    /* Maximum fuel capacity */
+    int health;                     /* Current health points */
+    int maxHealth;                  /* Maximum health points */
+    int metal;                      /* Count of metal pieces in inventory */
+    int plastic;                    /* Count of plastic pieces in inventory */
+    int electronics;                /* Count of electronics in inventory */
+    int fuelCells;                  /* Count of fuel cells in inventory */
+    int score;                      /* Player's current score */
+    int shieldTurns;                /* Turns until the shield drops, 0 while it is down */
+    unsigned int asteroidCount;     /* Number of asteroids */
+    unsigned int junkCount;         /* Number of junk items, collected ones included */
+} CompactGame;
+
+/* Return the size of the block of a compact game of a world size and entity counts */
+size_t compactGameSize(int worldWidth, int worldHeight, int asteroidCount, int junkCount);
+/* Return the size of the block a game packs into, 0 for a streamed game */
+size_t packedGameSize(const Game* game);
+/* Pack the board of a game into a block of packedGameSize bytes, returns 0 for a streamed game */
+int packGame(const Game* game, CompactGame* compact);
+/* Set the board of a game to a compact game, reusing its world if the size matches, returns 0 if out of memory */
+int unpackGame(Game* game, const CompactGame* compact);
+/* Return 1 if a cell of a compact game is an obstacle */
+int compactObstacle(const CompactGame* compact, int x, int y);
+/* Read the asteroid placed at an index of a compact game */
+void compactAsteroid(const CompactGame* compact, int index, Asteroid* asteroid);
+/* Return the position of a junk item of a compact game */
+Position compactJunkPosition(const CompactGame* compact, int index);
+/* Return the type of a junk item of a compact game */
+JunkType compactJunkType(const CompactGame* compact, int index);
+/* Return 1 if a junk item of a compact game was collected */
+int compactJunkCollected(const CompactGame* compact, int index);
+/* Mark a junk item of a compact game as collected */
+void collectCompactJunk(CompactGame* compact, int index);
+
+#endif /* SPACEXPLORER_COMPACT_GAME_H */
@@ -0,0 +1,328 @@
+/* String manipulation functions (strlen, memcmp, etc.) */
+#include <string.h>
+/* Structure member offsets (offsetof) */
+#include <stddef.h>
+/* Time types (time_t) */
+#include <time.h>
+/* File status functions (stat) */
+#include <sys/stat.h>
+/* Game-specific declarations and structures */
+#include "game.h"
+/* Configuration declarations */
+#include "config.h"
+/* Read-only file views */
+#include "mapped_file.h"
+/* Default assets embedded at build time */
+#include "assets.h"
+
+#ifdef __linux__
+/* File change notifications (inotify_init1, inotify_add_watch) */
+#include <sys/inotify.h>
+/* File descriptor functions (read, close) */
+#include <unistd.h>
+#endif
+
+/* Settings used by the running game */
+GameConfig gameConfig;
+
+/**
+ * Configuration key description
+ * Maps a key name to the integer field (or table of fields) it sets
+ */
+typedef struct {
+    const char* name;   /* Key name as written in the file */
+    size_t offset;      /* Offset of the first value in GameConfig */
+    int count;          /* Number of comma-separated values */
+} ConfigKey;
+
+/* All keys understood by the parser */
+static const ConfigKey CONFIG_KEYS[] = {
+    {"width", offsetof(GameConfig, worldWidth), 1},
+    {"height", offsetof(GameConfig, worldHeight), 1},
+    {"fuel_levels", offsetof(GameConfig, fuelLevels), DIFFICULTY_LEVELS},
+    {"fuel_consumption", offsetof(GameConfig, fuelConsumption), DIFFICULTY_LEVELS},
+    {"junk_counts", offsetof(GameConfig, junkCounts), DIFFICULTY_LEVELS},
+    {"asteroid_speeds", offsetof(GameConfig, asteroidSpeeds), DIFFICULTY_LEVELS},
+    {"win_scores", offsetof(GameConfig, winScores), DIFFICULTY_LEVELS},
+    {"junk_values", offsetof(GameConfig, junkValues), JUNK_TYPES},
+    {"max_health", offsetof(GameConfig, maxHealth), 1},
+    {"repair_amount", offsetof(GameConfig, repairAmount), 1},
+    {"refuel_amount", offsetof(GameConfig, refuelAmount), 1},
+    {"obstacles", offsetof(GameConfig, obstacleCount), 1},
+    {"asteroids", offsetof(GameConfig, asteroidCount), 1},
+    {"seed", offsetof(GameConfig, seed), 1},
+    {"junk_respawn_turns", offsetof(GameConfig, junkRespawnTurns), 1},
+    {"fuel_leak_turns", offsetof(GameConfig, fuelLeakTurns), DIFFICULTY_LEVELS},
+    {"fuel_leak_amount", offsetof(GameConfig, fuelLeakAmount), 1},
+    {"shield_turns", offsetof(GameConfig, shieldTurns), 1},
+    {"asteroid_spawn_turns", offsetof(GameConfig, asteroidSpawnTurns), DIFFICULTY_LEVELS},
+    {"fog_of_war", offsetof(GameConfig, fogOfWar), 1},
+    {"sight_radius", offsetof(GameConfig, sightRadius), 1},
+    {"procedural_world", offsetof(GameConfig, proceduralWorld), 1},
+    {"winnable_worlds", offsetof(GameConfig, winnableWorlds), 1},
+    {"streaming_world", offsetof(GameConfig, streamingWorld), 1},
+    {"sector_cache_kb", offsetof(GameConfig, sectorCacheKb), 1}
+};
+
+/* Number of entries in the key table */
+#define CONFIG_KEY_COUNT ((int)(sizeof(CONFIG_KEYS) / sizeof(CONFIG_KEYS[0])))
+
+/* Reset settings to the defaults embedded from assets/config.txt */
+void setDefaultConfig(GameConfig* config) {
+    static GameConfig defaults;
+    static int parsed = 0;
+
+    /* The embedded text is parsed once and copied afterwards */
+    if (!parsed) {
+        memset(&defaults, 0, sizeof(defaults));
+        parseConfig(&defaults, DEFAULT_CONFIG_TEXT, sizeof(DEFAULT_CONFIG_TEXT) - 1);
+        parsed = 1;
+    }
+    *config = defaults;
+}
+
+/* Find the table entry for a key that is not null-terminated */
+static const ConfigKey* findConfigKey(const char* name, size_t length) {
+    for (int i = 0; i < CONFIG_KEY_COUNT; i++) {
+        if (strlen(CONFIG_KEYS[i].name) == length &&
+            memcmp(CONFIG_KEYS[i].name, name, length) == 0) {
+            return &CONFIG_KEYS[i];
+        }
+    }
+    return NULL;
+}
+
+/* Parse key=value lines in a single pass over the buffer */
+int parseConfig(GameConfig* config, const char* text, size_t length) {
+    const char* p = text;
+    const char* end = text + length;
+    int applied = 0;
+
+    while (p < end) {
+        /* Skip indentation and blank lines */
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
+        if (p >= end) break;
+
+        /* Skip comment lines */
+        if (*p == '#') {
+            while (p < end && *p != '\n') p++;
+            continue;
+        }
+
+        /* Read the key up to the '=' separator */
+        const char* key = p;
+        while (p < end && *p != '=' && *p != '\n' && *p != ' ' && *p != '\t') p++;
+        size_t keyLength = (size_t)(p - key);
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+
+        /* Ignore lines without a value */
+        if (p >= end || *p != '=') {
+            while (p < end && *p != '\n') p++;
+            continue;
+        }
+        p++;
+
+        /* Unknown keys are read but not stored */
+        const ConfigKey* entry = findConfigKey(key, keyLength);
+        int* target = entry != NULL ? (int*)((char*)config + entry->offset) : NULL;
+        int index = 0;
+
+        /* Read comma-separated integers until the end of the line */
+        while (p < end && *p != '\n') {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+
+            /* Read an optional sign followed by digits */
+            int negative = 0;
+            if (p < end && (*p == '-' || *p == '+')) {
+                negative = (*p == '-');
+                p++;
+            }
+            int digits = 0;
+            long value = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                if (value < 1000000000L) value = value * 10 + (*p - '0');
+                digits++;
+                p++;
+            }
+
+            /* Store the value if the key has room for it */
+            if (digits > 0 && target != NULL && index < entry->count) {
+                target[index] = (int)(negative ? -value : value);
+            }
+            if (digits > 0) index++;
+
+            /* Move to the next value, stop at anything unexpected */
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) p++;
+            if (p < end && *p == ',') {
+                p++;
+            } else {
+                while (p < end && *p != '\n') p++;
+            }
+        }
+
+        if (target != NULL && index > 0) {
+            applied++;
+        }
+    }
+
+    return applied;
+}
+
+/* Clamp a value into the given range */
+static int clampValue(int value, int min, int max) {
+    if (value < min) return min;
+    if (value > max) return max;
+    return value;
+}
+
+/* Clamp settings to values the game can support */
+void validateConfig(GameConfig* config) {
+    /* Ensure world dimensions are not below the minimum allowed size */
+    config->worldWidth = clampValue(config->worldWidth, WORLD_MIN_SIZE, WORLD_MAX_SIZE);
+    config->worldHeight = clampValue(config->worldHeight, WORLD_MIN_SIZE, WORLD_MAX_SIZE);
+
+    /* Asteroids may share cells, but the field is kept below half of the world */
+    int cells = config->worldWidth * config->worldHeight;
+    config->asteroidCount = clampValue(config->asteroidCount, 0, cells / 2);
+
+    /* Obstacles and junk share the cells left over by the ship and asteroid edges */
+    int edgeCells = 2 * (config->worldWidth + config->worldHeight) - 4;
+    int freeCells = cells - 1 - (config->asteroidCount < edgeCells ? config->asteroidCount : edgeCells);
+    config->obstacleCount = clampValue(config->obstacleCount, 0, freeCells / 2);
+
+    for (int i = 0; i < DIFFICULTY_LEVELS; i++) {
+        config->fuelLevels[i] = clampValue(config->fuelLevels[i], 1, 1000000000);
+        config->fuelConsumption[i] = clampValue(config->fuelConsumption[i], 0, 1000000000);
+        config->junkCounts[i] = clampValue(config->junkCounts[i], 0, freeCells - config->obstacleCount);
+        config->asteroidSpeeds[i] = clampValue(config->asteroidSpeeds[i], 0, 1000);
+        config->winScores[i] = clampValue(config->winScores[i], 1, 1000000000);
+        config->fuelLeakTurns[i] = clampValue(config->fuelLeakTurns[i], 0, 1000000);
+        config->asteroidSpawnTurns[i] = clampValue(config->asteroidSpawnTurns[i], 0, 1000000);
+    }
+
+    config->maxHealth = clampValue(config->maxHealth, 1, 1000000000);
+    config->repairAmount = clampValue(config->repairAmount, 0, 1000000000);
+    config->refuelAmount = clampValue(config->refuelAmount, 0, 1000000000);
+
+    /* Timed events are scheduled at most a million turns ahead, well within the event wheel */
+    config->junkRespawnTurns = clampValue(config->junkRespawnTurns, 0, 1000000);
+    config->fuelLeakAmount = clampValue(config->fuelLeakAmount, 0, 1000000000);
+    config->shieldTurns = clampValue(config->shieldTurns, 0, 1000000);
+
+    /* Casting recurses once per row of sight, so the radius is kept to a small part of the largest world */
+    config->fogOfWar = clampValue(config->fogOfWar, 0, 1);
+    config->sightRadius = clampValue(config->sightRadius, 1, 256);
+    config->proceduralWorld = clampValue(config->proceduralWorld, 0, 1);
+    config->winnableWorlds = clampValue(config->winnableWorlds, 0, 1);
+
+    /* The sectors around the map are kept past the budget, so a small one only means more reading back */
+    config->streamingWorld = clampValue(config->streamingWorld, 0, 1);
+    config->sectorCacheKb = clampValue(config->sectorCacheKb, 64, 4194304);
+}
+
+/* Parse a configuration file on top of the given settings */
+int loadConfigFile(GameConfig* config, const char* path) {
+    MappedFile file;
+    if (!mapFile(&file, path)) {
+        return 0;
+    }
+    parseConfig(config, file.data, file.length);
+    unmapFile(&file);
+    return 1;
+}
+
+/* Path of the watched configuration file */
+static char watchPath[256];
+/* Last modification time seen for the watched file */
+static time_t watchModified;
+#ifdef __linux__
+/* inotify descriptor, or -1 when not watching */
+static int watchDescriptor = -1;
+/* File name part of the watched path */
+static const char* watchName;
+#endif
+
+/* Read the modification time of a file, 0 if it does not exist */
+static time_t fileModifiedTime(const char* path) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        return 0;
+    }
+    return info.st_mtime;
+}
+
+/* Start watching a configuration file for changes */
+void startConfigWatch(const char* path) {
+    stopConfigWatch();
+    strncpy(watchPath, path, sizeof(watchPath) - 1);
+    watchPath[sizeof(watchPath) - 1] = 0;
+    watchModified = fileModifiedTime(watchPath);
+
+#ifdef __linux__
+    /* Watch the directory, since editors often replace the file instead of writing it */
+    char directory[256];
+    const char* slash = strrchr(watchPath, '/');
+    if (slash != NULL) {
+        size_t length = (size_t)(slash - watchPath);
+        memcpy(directory, watchPath, length);
+        directory[length > 0 ? length : 1] = 0;
+        if (length == 0) directory[0] = '/';
+        watchName = slash + 1;
+    } else {
+        strcpy(directory, ".");
+        watchName = watchPath;
+    }
+
+    watchDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watchDescriptor >= 0 &&
+        inotify_add_watch(watchDescriptor, directory, IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        close(watchDescriptor);
+        watchDescriptor = -1;
+    }
+#endif
+}
+
+/* Check without blocking if the watched file changed */
+int pollConfigWatch(void) {
+    if (watchPath[0] == 0) {
+        return 0;
+    }
+
+#ifdef __linux__
+    if (watchDescriptor >= 0) {
+        /* Drain all pending events and look for the watched file name */
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        int changed = 0;
+        ssize_t length;
+        while ((length = read(watchDescriptor, events, sizeof(events))) > 0) {
+            for (char* p = events; p < events + length; ) {
+                struct inotify_event* event = (struct inotify_event*)p;
+                if (event->len > 0 && strcmp(event->name, watchName) == 0) {
+                    changed = 1;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+
+    /* Without change notifications, compare modification times instead */
+    time_t modified = fileModifiedTime(watchPath);
+    if (modified != watchModified) {
+        watchModified = modified;
+        return modified != 0;
+    }
+    return 0;
+}
+
+/* Stop watching the configuration file */
+void stopConfigWatch(void) {
+#ifdef __linux__
+    if (watchDescriptor >= 0) {
+        close(watchDescriptor);
+        watchDescriptor = -1;
+    }
+#endif
+    watchPath[0] = 0;
+}
@@ -0,0 +1,72 @@
+/**
+ * SpaceXplorer Configuration Header
+ *
+ * This header defines the tunable game settings and the functions
+ * used to read them from the key=value configuration file and to
+ * watch that file for changes while a game is running.
+ */
+
+#ifndef SPACEXPLORER_CONFIG_H
+#define SPACEXPLORER_CONFIG_H
+
+/* Size types (size_t) */
+#include <stddef.h>
+
+/* Number of difficulty levels with their own balance values */
+#define DIFFICULTY_LEVELS 3
+/* Number of junk types with their own score values */
+#define JUNK_TYPES 4
+
+/**
+ * Tunable game settings
+ * Per-difficulty tables are indexed by Difficulty (Easy, Medium, Hard),
+ * junk values are indexed by JunkType (Metal, Plastic, Electronics, Fuel cell)
+ */
+typedef struct {
+    int worldWidth;                          /* Width of the game world */
+    int worldHeight;                         /* Height of the game world */
+    int fuelLevels[DIFFICULTY_LEVELS];       /* Starting and maximum fuel */
+    int fuelConsumption[DIFFICULTY_LEVELS];  /* Fuel used by each move */
+    int junkCounts[DIFFICULTY_LEVELS];       /* Number of junk items placed */
+    int asteroidSpeeds[DIFFICULTY_LEVELS];   /* Asteroid cells moved per turn */
+    int winScores[DIFFICULTY_LEVELS];        /* Score required to win */
+    int junkValues[JUNK_TYPES];              /* Score value of each junk type */
+    int maxHealth;                           /* Starting and maximum health */
+    int repairAmount;                        /* Health restored by one metal */
+    int refuelAmount;                        /* Fuel restored by one fuel cell */
+    int obstacleCount;                       /* Number of impassable cells */
+    int asteroidCount;                       /* Number of asteroids */
+    int seed;                                /* Random seed, 0 seeds from the clock */
+    int junkRespawnTurns;                    /* Turns until collected junk drifts back in, 0 never */
+    int fuelLeakTurns[DIFFICULTY_LEVELS];    /* Turns between fuel leaks, 0 never */
+    int fuelLeakAmount;                      /* Fuel lost by each leak */
+    int shieldTurns;                         /* Turns the shield raised by electronics lasts, 0 none */
+    int asteroidSpawnTurns[DIFFICULTY_LEVELS]; /* Turns between new asteroids, 0 never */
+    int fogOfWar;                            /* Flag set to hide the cells the ship cannot see */
+    int sightRadius;                         /* Cells the ship sees in every direction */
+    int proceduralWorld;                     /* Flag set to shape the world from noise instead of scattering it evenly */
+    int winnableWorlds;                      /* Flag set to generate worlds again when obstacles cut the ship off from junk in range */
+    int streamingWorld;                      /* Flag set to stream an endless world in sectors, the map following the ship */
+    int sectorCacheKb;                       /* Kilobytes of streamed sectors kept in memory */
+} GameConfig;
+
+/* Settings used by the running game */
+extern GameConfig gameConfig;
+
+/* Reset settings to the default values built into the game */
+void setDefaultConfig(GameConfig* config);
+/* Parse key=value text in a single pass, returns the number of keys applied */
+int parseConfig(GameConfig* config, const char* text, size_t length);
+/* Clamp settings to values the game can support */
+void validateConfig(GameConfig* config);
+/* Parse a configuration file on top of the given settings, returns 1 if the file exists */
+int loadConfigFile(GameConfig* config, const char* path);
+
+/* Start watching a configuration file for changes */
+void startConfigWatch(const char* path);
+/* Check without blocking if the watched file changed, returns 1 if it did */
+int pollConfigWatch(void);
+/* Stop watching the configuration file */
+void stopConfigWatch(void);
+
+#endif /* SPACEXPLORER_CONFIG_H */
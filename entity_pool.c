@@ -0,0 +1,126 @@
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Entity pool declarations */
+#include "entity_pool.h"
+
+/* Chain slots from the first given one to the end of the pool into the free list in slot order */
+static void freeSlotsFrom(EntityPool* pool, int first) {
+    for (int slot = pool->capacity - 1; slot >= first; slot--) {
+        pool->generations[slot] = 0;
+        pool->indices[slot] = pool->freeSlot;
+        pool->freeSlot = slot;
+    }
+}
+
+/* Allocate a pool with room for the given number of entities from an arena or the heap, returns 0 if out of memory */
+int initEntityPool(EntityPool* pool, Arena* arena, int capacity) {
+    memset(pool, 0, sizeof(*pool));
+    pool->arena = arena;
+    pool->capacity = capacity > 0 ? capacity : 1;
+    pool->freeSlot = -1;
+    pool->slots = (int*)arenaAlloc(arena, (size_t)pool->capacity * sizeof(int));
+    pool->indices = (int*)arenaAlloc(arena, (size_t)pool->capacity * sizeof(int));
+    pool->generations = (unsigned int*)arenaAlloc(arena, (size_t)pool->capacity * sizeof(unsigned int));
+    if (pool->slots == NULL || pool->indices == NULL || pool->generations == NULL) {
+        freeEntityPool(pool);
+        return 0;
+    }
+    freeSlotsFrom(pool, 0);
+    return 1;
+}
+
+/* Free the tables of a pool, the ones from an arena go with the arena */
+void freeEntityPool(EntityPool* pool) {
+    arenaRelease(pool->arena, pool->slots);
+    arenaRelease(pool->arena, pool->indices);
+    arenaRelease(pool->arena, pool->generations);
+    memset(pool, 0, sizeof(*pool));
+    pool->freeSlot = -1;
+}
+
+/* Double the tables of a pool, returns 0 if out of memory */
+static int growPool(EntityPool* pool) {
+    int capacity = pool->capacity * 2;
+    size_t oldBytes = (size_t)pool->capacity * sizeof(int);
+    size_t newBytes = (size_t)capacity * sizeof(int);
+    int* slots = (int*)arenaGrow(pool->arena, pool->slots, oldBytes, newBytes);
+    if (slots == NULL) {
+        return 0;
+    }
+    pool->slots = slots;
+    int* indices = (int*)arenaGrow(pool->arena, pool->indices, oldBytes, newBytes);
+    if (indices == NULL) {
+        return 0;
+    }
+    pool->indices = indices;
+    unsigned int* generations = (unsigned int*)arenaGrow(pool->arena, pool->generations,
+                                                         (size_t)pool->capacity * sizeof(unsigned int),
+                                                         (size_t)capacity * sizeof(unsigned int));
+    if (generations == NULL) {
+        return 0;
+    }
+    pool->generations = generations;
+
+    /* The new slots go on the free list, which is empty when the pool is full */
+    int first = pool->capacity;
+    pool->capacity = capacity;
+    freeSlotsFrom(pool, first);
+    return 1;
+}
+
+/* Spawn an entity at index count - 1, growing the pool when full, returns a zeroed handle if out of memory */
+EntityHandle spawnEntity(EntityPool* pool) {
+    EntityHandle handle = {0, 0};
+    if (pool->freeSlot < 0 && !growPool(pool)) {
+        return handle;
+    }
+    int slot = pool->freeSlot;
+    pool->freeSlot = pool->indices[slot];
+
+    /* Generation 0 is never handed out, so a zeroed handle matches no entity */
+    if (++pool->generations[slot] == 0) {
+        pool->generations[slot] = 1;
+    }
+    int index = pool->count++;
+    pool->slots[index] = slot;
+    pool->indices[slot] = index;
+    handle.slot = slot;
+    handle.generation = pool->generations[slot];
+    return handle;
+}
+
+/* Despawn the entity at an index, the last entity moves into it, returns the index it moved from */
+int despawnEntity(EntityPool* pool, int index) {
+    int slot = pool->slots[index];
+    int last = --pool->count;
+    pool->slots[index] = pool->slots[last];
+    pool->indices[pool->slots[index]] = index;
+
+    /* Bumping the generation makes the handles to the despawned entity stale */
+    pool->generations[slot]++;
+    pool->indices[slot] = pool->freeSlot;
+    pool->freeSlot = slot;
+    return last;
+}
+
+/* Despawn every entity */
+void clearEntityPool(EntityPool* pool) {
+    while (pool->count > 0) {
+        despawnEntity(pool, pool->count - 1);
+    }
+}
+
+/* Return the handle of the entity at an index */
+EntityHandle entityHandle(const EntityPool* pool, int index) {
+    EntityHandle handle = {pool->slots[index], pool->generations[pool->slots[index]]};
+    return handle;
+}
+
+/* Return the index of the entity a handle refers to, -1 if it was despawned */
+int entityIndex(const EntityPool* pool, EntityHandle handle) {
+    if (handle.generation == 0 || handle.slot < 0 || handle.slot >= pool->capacity ||
+        pool->generations[handle.slot] != handle.generation) {
+        return -1;
+    }
+    return pool->indices[handle.slot];
+}
@@ -0,0 +1,60 @@
+/**
+ * SpaceXplorer Entity Pool Header
+ *
+ * This header defines a pool keeping track of a changing set of entities
+ * whose data the owner stores in dense arrays. Live entities are always
+ * indices 0 to count - 1 of those arrays, so walking them touches nothing
+ * that was removed. Removing an entity moves the last one into its index,
+ * which the owner mirrors in its arrays, so spawning and despawning both
+ * take constant time. Every entity also has a slot that stays put while
+ * its index changes, and handles of a slot and its generation find the
+ * entity wherever it has moved, or tell that it is gone.
+ */
+
+#ifndef SPACEXPLORER_ENTITY_POOL_H
+#define SPACEXPLORER_ENTITY_POOL_H
+
+/* Arena the slot tables are allocated from */
+#include "arena.h"
+
+/**
+ * Handle of an entity
+ * The generation tells a live entity from a later one reusing its slot,
+ * a zeroed handle refers to no entity
+ */
+typedef struct {
+    int slot;                   /* Slot of the entity */
+    unsigned int generation;    /* Generation of the slot when the entity was spawned */
+} EntityHandle;
+
+/**
+ * Entity pool
+ * The entity at index i is in slot slots[i], a live slot s holds index
+ * indices[s] and a free one the next free slot
+ */
+typedef struct {
+    int count;                  /* Number of live entities */
+    int capacity;               /* Number of slots */
+    int* slots;                 /* Slot of the entity at each index */
+    int* indices;               /* Index of each live slot's entity, the next free slot of a free one */
+    unsigned int* generations;  /* Bumped every time a slot is taken */
+    int freeSlot;               /* First free slot, -1 if none */
+    Arena* arena;               /* Arena the tables come from, NULL for the heap */
+} EntityPool;
+
+/* Allocate a pool with room for the given number of entities from an arena or the heap, returns 0 if out of memory */
+int initEntityPool(EntityPool* pool, Arena* arena, int capacity);
+/* Free the tables of a pool, the ones from an arena go with the arena */
+void freeEntityPool(EntityPool* pool);
+/* Spawn an entity at index count - 1, growing the pool when full, returns a zeroed handle if out of memory */
+EntityHandle spawnEntity(EntityPool* pool);
+/* Despawn the entity at an index, the last entity moves into it, returns the index it moved from */
+int despawnEntity(EntityPool* pool, int index);
+/* Despawn every entity */
+void clearEntityPool(EntityPool* pool);
+/* Return the handle of the entity at an index */
+EntityHandle entityHandle(const EntityPool* pool, int index);
+/* Return the index of the entity a handle refers to, -1 if it was despawned */
+int entityIndex(const EntityPool* pool, EntityHandle handle);
+
+#endif /* SPACEXPLORER_ENTITY_POOL_H */
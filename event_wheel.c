@@ -0,0 +1,175 @@
+/* Size types (size_t) */
+#include <stdlib.h>
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Event wheel declarations */
+#include "event_wheel.h"
+
+/* Number of nodes the pool starts with */
+#define EVENT_WHEEL_INITIAL_NODES 64
+
+/* Set up an empty wheel at turn 0, the node pool grows in an arena or the heap as events are scheduled */
+void initEventWheel(EventWheel* wheel, Arena* arena) {
+    memset(wheel, 0, sizeof(*wheel));
+    wheel->arena = arena;
+    memset(wheel->heads, -1, sizeof(wheel->heads));
+    memset(wheel->tails, -1, sizeof(wheel->tails));
+    wheel->freeNode = -1;
+}
+
+/* Free the node pool of a wheel, a pool in an arena goes with the arena */
+void freeEventWheel(EventWheel* wheel) {
+    arenaRelease(wheel->arena, wheel->nodes);
+    initEventWheel(wheel, NULL);
+}
+
+/* Append a node to the slot its due turn falls in, the lowest level whose ring reaches it */
+static void insertNode(EventWheel* wheel, int index) {
+    EventNode* node = &wheel->nodes[index];
+    int level = 0;
+    while (level < EVENT_WHEEL_LEVELS - 1 &&
+           (node->due >> (EVENT_WHEEL_BITS * (level + 1))) != (wheel->now >> (EVENT_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    int slot = level * EVENT_WHEEL_SLOTS + (int)((node->due >> (EVENT_WHEEL_BITS * level)) & (EVENT_WHEEL_SLOTS - 1));
+
+    /* Events of a slot keep the order they were scheduled in */
+    node->slot = slot;
+    node->prev = wheel->tails[slot];
+    node->next = -1;
+    if (node->prev >= 0) {
+        wheel->nodes[node->prev].next = index;
+    } else {
+        wheel->heads[slot] = index;
+    }
+    wheel->tails[slot] = index;
+}
+
+/* Unlink a node from the slot it is on */
+static void removeNode(EventWheel* wheel, int index) {
+    EventNode* node = &wheel->nodes[index];
+    if (node->prev >= 0) {
+        wheel->nodes[node->prev].next = node->next;
+    } else {
+        wheel->heads[node->slot] = node->next;
+    }
+    if (node->next >= 0) {
+        wheel->nodes[node->next].prev = node->prev;
+    } else {
+        wheel->tails[node->slot] = node->prev;
+    }
+}
+
+/* Return a node to the free list, which invalidates the handles to it */
+static void releaseNode(EventWheel* wheel, int index) {
+    wheel->nodes[index].slot = -1;
+    wheel->nodes[index].next = wheel->freeNode;
+    wheel->freeNode = index;
+    wheel->pending--;
+}
+
+/* Double the node pool, returns 0 if out of memory */
+static int growPool(EventWheel* wheel) {
+    int capacity = wheel->capacity > 0 ? wheel->capacity * 2 : EVENT_WHEEL_INITIAL_NODES;
+    EventNode* nodes = (EventNode*)arenaGrow(wheel->arena, wheel->nodes, (size_t)wheel->capacity * sizeof(EventNode),
+                                             (size_t)capacity * sizeof(EventNode));
+    if (nodes == NULL) {
+        return 0;
+    }
+
+    /* Chain the new nodes into the free list in index order */
+    for (int i = capacity - 1; i >= wheel->capacity; i--) {
+        nodes[i].slot = -1;
+        nodes[i].generation = 0;
+        nodes[i].next = wheel->freeNode;
+        wheel->freeNode = i;
+    }
+    wheel->nodes = nodes;
+    wheel->capacity = capacity;
+    return 1;
+}
+
+/* Schedule an event the given number of turns ahead, at least 1, returns a zeroed handle if out of memory */
+EventHandle scheduleEvent(EventWheel* wheel, int delay, int type, int data) {
+    EventHandle handle = {0, 0};
+    if (wheel->freeNode < 0 && !growPool(wheel)) {
+        return handle;
+    }
+    if (delay < 1) delay = 1;
+    if (delay > EVENT_WHEEL_MAX_DELAY) delay = EVENT_WHEEL_MAX_DELAY;
+
+    int index = wheel->freeNode;
+    EventNode* node = &wheel->nodes[index];
+    wheel->freeNode = node->next;
+    node->due = wheel->now + delay;
+    node->type = type;
+    node->data = data;
+    node->generation++;
+    insertNode(wheel, index);
+    wheel->pending++;
+
+    handle.node = index;
+    handle.generation = node->generation;
+    return handle;
+}
+
+/* Return 1 if a handle refers to an event that is still pending */
+static int eventPending(const EventWheel* wheel, EventHandle handle) {
+    if (handle.node < 0 || handle.node >= wheel->capacity || handle.generation == 0) {
+        return 0;
+    }
+    const EventNode* node = &wheel->nodes[handle.node];
+    return node->slot >= 0 && node->generation == handle.generation;
+}
+
+/* Cancel a scheduled event, returns 1 if it was still pending */
+int cancelEvent(EventWheel* wheel, EventHandle handle) {
+    if (!eventPending(wheel, handle)) {
+        return 0;
+    }
+    removeNode(wheel, handle.node);
+    releaseNode(wheel, handle.node);
+    return 1;
+}
+
+/* Return the turns until a scheduled event is due, 0 if it is no longer pending */
+int eventTurnsLeft(const EventWheel* wheel, EventHandle handle) {
+    if (!eventPending(wheel, handle)) {
+        return 0;
+    }
+    return (int)(wheel->nodes[handle.node].due - wheel->now);
+}
+
+/* Move the wheel to the next turn */
+void advanceEventWheel(EventWheel* wheel) {
+    wheel->now++;
+
+    /* Entering a new slot of a higher level moves its events down, each to the lowest level reaching it */
+    for (int level = EVENT_WHEEL_LEVELS - 1; level > 0; level--) {
+        if ((wheel->now & ((1LL << (EVENT_WHEEL_BITS * level)) - 1)) != 0) {
+            continue;
+        }
+        int slot = level * EVENT_WHEEL_SLOTS + (int)((wheel->now >> (EVENT_WHEEL_BITS * level)) & (EVENT_WHEEL_SLOTS - 1));
+        int index = wheel->heads[slot];
+        wheel->heads[slot] = -1;
+        wheel->tails[slot] = -1;
+        while (index >= 0) {
+            int next = wheel->nodes[index].next;
+            insertNode(wheel, index);
+            index = next;
+        }
+    }
+}
+
+/* Take the next event due on the current turn, returns 0 when there are no more */
+int nextDueEvent(EventWheel* wheel, int* type, int* data) {
+    int index = wheel->heads[(int)(wheel->now & (EVENT_WHEEL_SLOTS - 1))];
+    if (index < 0) {
+        return 0;
+    }
+    *type = wheel->nodes[index].type;
+    *data = wheel->nodes[index].data;
+    removeNode(wheel, index);
+    releaseNode(wheel, index);
+    return 1;
+}
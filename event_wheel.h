@@ -0,0 +1,83 @@
+/**
+ * SpaceXplorer Event Wheel Header
+ *
+ * This header defines a hierarchical timing wheel of events keyed by turn.
+ * Each level is a ring of slots covering 64 times the turns of the level
+ * below, and an event sits in the lowest level whose ring still reaches
+ * its turn. When the turn crosses into the next slot of a higher level,
+ * the events of that slot are moved down, so each turn only looks at the
+ * events that are due instead of all pending ones. Events are nodes of a
+ * pool reused through a free list, and the handles returned when they are
+ * scheduled cancel them in constant time.
+ */
+
+#ifndef SPACEXPLORER_EVENT_WHEEL_H
+#define SPACEXPLORER_EVENT_WHEEL_H
+
+/* Arena the node pool is allocated from */
+#include "arena.h"
+
+/* Bits of the turn number each level of the wheel covers */
+#define EVENT_WHEEL_BITS 6
+/* Number of slots of each level */
+#define EVENT_WHEEL_SLOTS (1 << EVENT_WHEEL_BITS)
+/* Number of levels of the wheel */
+#define EVENT_WHEEL_LEVELS 4
+/* Longest delay in turns, longer ones are shortened to it so the top level never wraps onto its current slot */
+#define EVENT_WHEEL_MAX_DELAY (((EVENT_WHEEL_SLOTS - 1) << (EVENT_WHEEL_BITS * (EVENT_WHEEL_LEVELS - 1))) - 1)
+
+/**
+ * Handle of a scheduled event
+ * The generation tells a pending event from a later one reusing its node,
+ * a zeroed handle refers to no event
+ */
+typedef struct {
+    int node;                   /* Index of the event's node in the pool */
+    unsigned int generation;    /* Generation of the node when the event was scheduled */
+} EventHandle;
+
+/**
+ * Event node
+ * Linked into the list of its slot while pending, or into the free list
+ */
+typedef struct {
+    long long due;              /* Turn the event is due on */
+    int type;                   /* Kind of event, defined by the user of the wheel */
+    int data;                   /* Value passed along with the event */
+    int slot;                   /* Slot list the node is on, -1 while free */
+    int prev;                   /* Previous node of the list, -1 at its head */
+    int next;                   /* Next node of the list, -1 at its tail */
+    unsigned int generation;    /* Bumped every time the node is taken from the free list */
+} EventNode;
+
+/**
+ * Timing wheel
+ * Slot s of level l is list l * EVENT_WHEEL_SLOTS + s
+ */
+typedef struct {
+    long long now;                                              /* Current turn */
+    int heads[EVENT_WHEEL_LEVELS * EVENT_WHEEL_SLOTS];          /* First node of each slot, -1 if empty */
+    int tails[EVENT_WHEEL_LEVELS * EVENT_WHEEL_SLOTS];          /* Last node of each slot, -1 if empty */
+    EventNode* nodes;                                           /* Pool of event nodes */
+    int capacity;                                               /* Number of nodes in the pool */
+    int freeNode;                                               /* First node of the free list, -1 if none */
+    int pending;                                                /* Number of scheduled events */
+    Arena* arena;                                               /* Arena the pool grows in, NULL for the heap */
+} EventWheel;
+
+/* Set up an empty wheel at turn 0, the node pool grows in an arena or the heap as events are scheduled */
+void initEventWheel(EventWheel* wheel, Arena* arena);
+/* Free the node pool of a wheel, a pool in an arena goes with the arena */
+void freeEventWheel(EventWheel* wheel);
+/* Schedule an event the given number of turns ahead, at least 1, returns a zeroed handle if out of memory */
+EventHandle scheduleEvent(EventWheel* wheel, int delay, int type, int data);
+/* Cancel a scheduled event, returns 1 if it was still pending */
+int cancelEvent(EventWheel* wheel, EventHandle handle);
+/* Return the turns until a scheduled event is due, 0 if it is no longer pending */
+int eventTurnsLeft(const EventWheel* wheel, EventHandle handle);
+/* Move the wheel to the next turn */
+void advanceEventWheel(EventWheel* wheel);
+/* Take the next event due on the current turn, returns 0 when there are no more */
+int nextDueEvent(EventWheel* wheel, int* type, int* data);
+
+#endif /* SPACEXPLORER_EVENT_WHEEL_H */
@@ -0,0 +1,302 @@
+/* Standard input/output functions (fopen, fwrite, etc.) */
+#include <stdio.h>
+/* Signal handling (signal, raise) */
+#include <signal.h>
+/* String manipulation functions (memcmp, memset) */
+#include <string.h>
+/* Flight recorder declarations */
+#include "flight_recorder.h"
+
+#ifndef _WIN32
+/* File descriptor functions (open, write, close), safe to call from a signal handler */
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/*
+ * File layout, all numbers little-endian:
+ * - header: "SXFR", then version, world width, world height, difficulty,
+ *   asteroid count, turns played and turns kept as 32-bit numbers
+ * - every kept turn, oldest first: turn number (32 bits), command, option,
+ *   events and asteroid count (8 bits each), ship x, ship y and hit asteroid
+ *   (16 bits each), fuel, health and score (32 bits each), then x and y of
+ *   each kept asteroid (16 bits each)
+ */
+
+/* Size of the file header in bytes */
+#define FLIGHT_HEADER_SIZE 32
+/* Size of a turn without its asteroids in bytes */
+#define FLIGHT_TURN_SIZE 26
+/* Largest file the recorder writes */
+#define FLIGHT_FILE_SIZE (FLIGHT_HEADER_SIZE + FLIGHT_RECORDER_TURNS * (FLIGHT_TURN_SIZE + FLIGHT_RECORDER_ASTEROIDS * 4))
+
+/* File path the flight recorder is saved to */
+const char* FLIGHT_RECORDER_FILE = "flightrecorder.bin";
+
+/**
+ * Recorder state
+ * The ring of turns and what is needed to tell what changed in the next one
+ */
+typedef struct {
+    FlightTurn turns[FLIGHT_RECORDER_TURNS];    /* Ring of turns, indexed by turn number modulo the size */
+    unsigned int totalTurns;                    /* Number of turns recorded */
+    int worldWidth;                             /* Width of the game world */
+    int worldHeight;                            /* Height of the game world */
+    Difficulty difficulty;                      /* Game difficulty */
+    int asteroidCount;                          /* Number of asteroids in the game */
+    Spaceship lastShip;                         /* Ship after the previous turn */
+    int lastScore;                              /* Score after the previous turn */
+    int asteroidSlots[FLIGHT_RECORDER_ASTEROIDS]; /* Where each kept asteroid was in the field last turn, -1 once dropped */
+} FlightRecorder;
+
+/* The recorder of the console game */
+static FlightRecorder recorder;
+/* File contents built by the crash handler, kept static so the handler needs no allocation */
+static unsigned char crashBuffer[FLIGHT_FILE_SIZE];
+/* Flag indicating if the crash handlers are installed */
+static int crashHandlersInstalled = 0;
+
+/* Store a 16-bit number little-endian */
+static unsigned char* put16(unsigned char* out, unsigned int value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    return out + 2;
+}
+
+/* Store a 32-bit number little-endian */
+static unsigned char* put32(unsigned char* out, unsigned int value) {
+    out[0] = (unsigned char)value;
+    out[1] = (unsigned char)(value >> 8);
+    out[2] = (unsigned char)(value >> 16);
+    out[3] = (unsigned char)(value >> 24);
+    return out + 4;
+}
+
+/* Read a 16-bit little-endian number */
+static unsigned int get16(const unsigned char* in) {
+    return (unsigned int)in[0] | (unsigned int)in[1] << 8;
+}
+
+/* Read a 32-bit little-endian number */
+static unsigned int get32(const unsigned char* in) {
+    return (unsigned int)in[0] | (unsigned int)in[1] << 8 | (unsigned int)in[2] << 16 | (unsigned int)in[3] << 24;
+}
+
+/* Build the file contents in a buffer of FLIGHT_FILE_SIZE bytes, returns their length */
+static size_t encodeRecorder(unsigned char* buffer) {
+    unsigned int kept = recorder.totalTurns < FLIGHT_RECORDER_TURNS ? recorder.totalTurns : FLIGHT_RECORDER_TURNS;
+    unsigned char* out = buffer;
+    out[0] = 'S'; out[1] = 'X'; out[2] = 'F'; out[3] = 'R';
+    out = put32(out + 4, FLIGHT_RECORDER_VERSION);
+    out = put32(out, (unsigned int)recorder.worldWidth);
+    out = put32(out, (unsigned int)recorder.worldHeight);
+    out = put32(out, (unsigned int)recorder.difficulty);
+    out = put32(out, (unsigned int)recorder.asteroidCount);
+    out = put32(out, recorder.totalTurns);
+    out = put32(out, kept);
+
+    for (unsigned int i = recorder.totalTurns - kept; i < recorder.totalTurns; i++) {
+        const FlightTurn* turn = &recorder.turns[i % FLIGHT_RECORDER_TURNS];
+        out = put32(out, turn->turn);
+        *out++ = (unsigned char)turn->command;
+        *out++ = turn->option;
+        *out++ = turn->events;
+        *out++ = turn->asteroidCount;
+        out = put16(out, turn->shipX);
+        out = put16(out, turn->shipY);
+        out = put16(out, turn->hitAsteroid);
+        out = put32(out, (unsigned int)turn->fuel);
+        out = put32(out, (unsigned int)turn->health);
+        out = put32(out, (unsigned int)turn->score);
+        for (int a = 0; a < turn->asteroidCount; a++) {
+            out = put16(out, turn->asteroidX[a]);
+            out = put16(out, turn->asteroidY[a]);
+        }
+    }
+    return (size_t)(out - buffer);
+}
+
+/* Write bytes to a file, only with calls that are safe in a signal handler where possible */
+static int writeRecorderFile(const char* path, const unsigned char* data, size_t length) {
+#ifndef _WIN32
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return 0;
+    }
+    size_t done = 0;
+    while (done < length) {
+        ssize_t written = write(fd, data + done, length - done);
+        if (written <= 0) {
+            close(fd);
+            return 0;
+        }
+        done += (size_t)written;
+    }
+    close(fd);
+    return 1;
+#else
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        return 0;
+    }
+    size_t written = fwrite(data, 1, length, file);
+    fclose(file);
+    return written == length;
+#endif
+}
+
+/* Save the record, then let the signal take its default course */
+static void handleCrashSignal(int signalNumber) {
+    writeRecorderFile(FLIGHT_RECORDER_FILE, crashBuffer, encodeRecorder(crashBuffer));
+    signal(signalNumber, SIG_DFL);
+    raise(signalNumber);
+}
+
+/* Start recording a new console game and save the record if the program crashes */
+void startFlightRecorder(const Game* game) {
+    recorder.totalTurns = 0;
+    recorder.worldWidth = game->worldWidth;
+    recorder.worldHeight = game->worldHeight;
+    recorder.difficulty = game->difficulty;
+    recorder.asteroidCount = game->asteroids.count;
+    recorder.lastShip = game->ship;
+    recorder.lastScore = game->score;
+    memset(recorder.asteroidSlots, 0, sizeof(recorder.asteroidSlots));
+
+    if (!crashHandlersInstalled) {
+        signal(SIGSEGV, handleCrashSignal);
+        signal(SIGABRT, handleCrashSignal);
+        signal(SIGFPE, handleCrashSignal);
+        signal(SIGILL, handleCrashSignal);
+#ifdef SIGBUS
+        signal(SIGBUS, handleCrashSignal);
+#endif
+        crashHandlersInstalled = 1;
+    }
+}
+
+/* Record the state after a command was applied, telling what happened from what changed */
+void recordTurn(const Game* game, char command, int option) {
+    FlightTurn* turn = &recorder.turns[recorder.totalTurns % FLIGHT_RECORDER_TURNS];
+    const Spaceship* ship = &game->ship;
+    const Spaceship* last = &recorder.lastShip;
+    recorder.totalTurns++;
+
+    turn->turn = recorder.totalTurns;
+    turn->command = command;
+    turn->option = (unsigned char)option;
+    turn->shipX = (unsigned short)ship->position.x;
+    turn->shipY = (unsigned short)ship->position.y;
+    turn->fuel = ship->fuel;
+    turn->health = ship->health;
+    turn->score = game->score;
+
+    /* Events are the differences from the previous turn */
+    unsigned char events = 0;
+    if (ship->position.x != last->position.x || ship->position.y != last->position.y) {
+        events |= FLIGHT_MOVED;
+    } else if (command == 'W' || command == 'A' || command == 'S' || command == 'D') {
+        events |= FLIGHT_BLOCKED;
+    }
+    if (game->score > recorder.lastScore) events |= FLIGHT_COLLECTED;
+    if (ship->metal < last->metal) events |= FLIGHT_REPAIRED;
+    if (ship->fuelCells < last->fuelCells) events |= FLIGHT_REFUELED;
+    if (game->hasWon) events |= FLIGHT_WON;
+    if (game->isGameOver && ship->fuel <= 0) events |= FLIGHT_OUT_OF_FUEL;
+
+    /* An asteroid on the ship's cell ended the game, the first placed one if several are there */
+    const AsteroidField* field = &game->asteroids;
+    turn->hitAsteroid = FLIGHT_NO_ASTEROID;
+    if (game->isGameOver && !game->hasWon) {
+        int hit = -1;
+        for (int a = 0; a < field->count; a++) {
+            if (field->x[a] == ship->position.x && field->y[a] == ship->position.y && (hit < 0 || field->id[a] < hit)) {
+                hit = field->id[a];
+            }
+        }
+        if (hit >= 0) {
+            turn->hitAsteroid = (unsigned short)(hit < FLIGHT_NO_ASTEROID ? hit : FLIGHT_NO_ASTEROID - 1);
+            events |= FLIGHT_HIT;
+        }
+    }
+    turn->events = events;
+
+    /* The field is kept in tile order, the kept asteroids are looked up again only after they were sorted */
+    int asteroidCount = field->count < FLIGHT_RECORDER_ASTEROIDS ? field->count : FLIGHT_RECORDER_ASTEROIDS;
+    int* slots = recorder.asteroidSlots;
+    turn->asteroidCount = (unsigned char)asteroidCount;
+    for (int id = 0; id < asteroidCount; id++) {
+        if (slots[id] >= field->count || (slots[id] >= 0 && field->id[slots[id]] != id)) {
+            for (int kept = 0; kept < FLIGHT_RECORDER_ASTEROIDS; kept++) {
+                slots[kept] = -1;
+            }
+            for (int a = 0; a < field->count; a++) {
+                if (field->id[a] < asteroidCount) {
+                    slots[field->id[a]] = a;
+                }
+            }
+        }
+        if (slots[id] >= 0) {
+            turn->asteroidX[id] = (unsigned short)field->x[slots[id]];
+            turn->asteroidY[id] = (unsigned short)field->y[slots[id]];
+        }
+    }
+
+    recorder.lastShip = *ship;
+    recorder.lastScore = game->score;
+}
+
+/* Save the recorded turns to a file, returns 0 if it could not be written */
+int saveFlightRecorder(const char* path) {
+    static unsigned char buffer[FLIGHT_FILE_SIZE];
+    return writeRecorderFile(path, buffer, encodeRecorder(buffer));
+}
+
+/* Decode the contents of a flight recorder file, returns 0 if they are not one */
+int decodeFlightLog(const unsigned char* data, size_t length, FlightLog* log) {
+    if (length < FLIGHT_HEADER_SIZE || memcmp(data, "SXFR", 4) != 0 || get32(data + 4) != FLIGHT_RECORDER_VERSION) {
+        return 0;
+    }
+    log->worldWidth = (int)get32(data + 8);
+    log->worldHeight = (int)get32(data + 12);
+    log->difficulty = (Difficulty)get32(data + 16);
+    log->asteroidCount = (int)get32(data + 20);
+    log->totalTurns = get32(data + 24);
+    unsigned int kept = get32(data + 28);
+    if (kept > FLIGHT_RECORDER_TURNS) {
+        return 0;
+    }
+
+    /* Turns vary in size with their asteroid count, check each one fits */
+    size_t position = FLIGHT_HEADER_SIZE;
+    for (unsigned int i = 0; i < kept; i++) {
+        if (length - position < FLIGHT_TURN_SIZE) {
+            return 0;
+        }
+        const unsigned char* in = data + position;
+        FlightTurn* turn = &log->turns[i];
+        turn->turn = get32(in);
+        turn->command = (char)in[4];
+        turn->option = in[5];
+        turn->events = in[6];
+        turn->asteroidCount = in[7];
+        turn->shipX = (unsigned short)get16(in + 8);
+        turn->shipY = (unsigned short)get16(in + 10);
+        turn->hitAsteroid = (unsigned short)get16(in + 12);
+        turn->fuel = (int)get32(in + 14);
+        turn->health = (int)get32(in + 18);
+        turn->score = (int)get32(in + 22);
+        position += FLIGHT_TURN_SIZE;
+
+        if (turn->asteroidCount > FLIGHT_RECORDER_ASTEROIDS || length - position < (size_t)turn->asteroidCount * 4) {
+            return 0;
+        }
+        for (int a = 0; a < turn->asteroidCount; a++) {
+            turn->asteroidX[a] = (unsigned short)get16(data + position);
+            turn->asteroidY[a] = (unsigned short)get16(data + position + 2);
+            position += 4;
+        }
+    }
+    log->turnCount = (int)kept;
+    return 1;
+}
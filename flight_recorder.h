@@ -0,0 +1,91 @@
+/**
+ * SpaceXplorer Flight Recorder Header
+ *
+ * This header defines the record of the most recent turns of a console
+ * game. Every turn stores the command, the ship, the first asteroids and
+ * what happened into a fixed ring, and the ring is saved to a binary file
+ * when the game ends or the program crashes, so a lost game can be
+ * replayed turn by turn with spacexplorer_flightlog.
+ */
+
+#ifndef SPACEXPLORER_FLIGHT_RECORDER_H
+#define SPACEXPLORER_FLIGHT_RECORDER_H
+
+/* Size type for the file contents */
+#include <stddef.h>
+/* Game structures the turns are taken from */
+#include "game.h"
+
+/* Number of turns kept, older ones are overwritten */
+#define FLIGHT_RECORDER_TURNS 256
+/* Number of asteroids whose positions are kept each turn, the first ones placed */
+#define FLIGHT_RECORDER_ASTEROIDS 8
+/* Version of the file layout */
+#define FLIGHT_RECORDER_VERSION 1
+/* Asteroid index meaning no asteroid hit the ship */
+#define FLIGHT_NO_ASTEROID 0xFFFF
+
+/* Turn event bit, the ship moved */
+#define FLIGHT_MOVED 1
+/* Turn event bit, a move was stopped by the world edge or an obstacle */
+#define FLIGHT_BLOCKED 2
+/* Turn event bit, junk was collected */
+#define FLIGHT_COLLECTED 4
+/* Turn event bit, metal was used to repair the ship */
+#define FLIGHT_REPAIRED 8
+/* Turn event bit, a fuel cell was used */
+#define FLIGHT_REFUELED 16
+/* Turn event bit, an asteroid hit the ship */
+#define FLIGHT_HIT 32
+/* Turn event bit, the ship ran out of fuel */
+#define FLIGHT_OUT_OF_FUEL 64
+/* Turn event bit, the player reached the winning score */
+#define FLIGHT_WON 128
+
+/**
+ * Recorded turn
+ * State after the command was applied, in the compact form it is kept in
+ */
+typedef struct {
+    unsigned int turn;                                  /* Turn number, counting from 1 */
+    char command;                                       /* Command the player entered */
+    unsigned char option;                               /* Item chosen for the (U)se command */
+    unsigned char events;                               /* FLIGHT_* bits of what happened */
+    unsigned char asteroidCount;                        /* Number of asteroid positions kept */
+    unsigned short shipX;                               /* Ship X-coordinate */
+    unsigned short shipY;                               /* Ship Y-coordinate */
+    unsigned short hitAsteroid;                         /* Index of the asteroid that hit, or FLIGHT_NO_ASTEROID */
+    int fuel;                                           /* Fuel left */
+    int health;                                         /* Health left */
+    int score;                                          /* Score so far */
+    unsigned short asteroidX[FLIGHT_RECORDER_ASTEROIDS]; /* Asteroid X-coordinates */
+    unsigned short asteroidY[FLIGHT_RECORDER_ASTEROIDS]; /* Asteroid Y-coordinates */
+} FlightTurn;
+
+/**
+ * Decoded flight recorder file
+ * The game it was recorded in and its last turns, oldest first
+ */
+typedef struct {
+    int worldWidth;                             /* Width of the game world */
+    int worldHeight;                            /* Height of the game world */
+    Difficulty difficulty;                      /* Game difficulty */
+    int asteroidCount;                          /* Number of asteroids in the game */
+    unsigned int totalTurns;                    /* Number of turns played, including dropped ones */
+    int turnCount;                              /* Number of turns kept */
+    FlightTurn turns[FLIGHT_RECORDER_TURNS];    /* Kept turns, oldest first */
+} FlightLog;
+
+/* File path the flight recorder is saved to */
+extern const char* FLIGHT_RECORDER_FILE;
+
+/* Start recording a new console game and save the record if the program crashes */
+void startFlightRecorder(const Game* game);
+/* Record the state after a command was applied */
+void recordTurn(const Game* game, char command, int option);
+/* Save the recorded turns to a file, returns 0 if it could not be written */
+int saveFlightRecorder(const char* path);
+/* Decode the contents of a flight recorder file, returns 0 if they are not one */
+int decodeFlightLog(const unsigned char* data, size_t length, FlightLog* log);
+
+#endif /* SPACEXPLORER_FLIGHT_RECORDER_H */
@@ -0,0 +1,96 @@
+/**
+ * SpaceXplorer Flight Log
+ * Prints a flight recorder file as a readable log of the last turns
+ *
+ * Usage: spacexplorer_flightlog [file]
+ */
+
+/* Standard input/output functions (printf, fprintf, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free) */
+#include <stdlib.h>
+/* Flight recorder file decoding */
+#include "flight_recorder.h"
+/* Whole-file reading */
+#include "mapped_file.h"
+
+/* Names of the turn events in bit order */
+static const char* eventNames[8] = {
+    "moved", "blocked", "collected", "repaired", "refueled", "HIT", "OUT OF FUEL", "WON"
+};
+/* Names of the difficulties */
+static const char* difficultyNames[3] = {"Easy", "Medium", "Hard"};
+
+/* Print one turn as a line of the log */
+static void printTurn(const FlightTurn* turn) {
+    char command[8];
+    if (turn->command == 'U') {
+        snprintf(command, sizeof(command), "U%d", turn->option);
+    } else {
+        snprintf(command, sizeof(command), "%c", turn->command >= ' ' ? turn->command : '?');
+    }
+    printf("%6u  %-4s (%5u,%5u) %6d %6d %6d  ", turn->turn, command, turn->shipX, turn->shipY,
+           turn->fuel, turn->health, turn->score);
+
+    /* Events, or a dash on a quiet turn */
+    int printed = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        if (turn->events & (1 << bit)) {
+            printf("%s%s", printed ? "," : "", eventNames[bit]);
+            printed++;
+        }
+    }
+    if (turn->events & FLIGHT_HIT) {
+        printf(" by #%u", turn->hitAsteroid);
+    }
+    printf("%s\n", printed ? "" : "-");
+
+    /* Kept asteroid positions on their own line */
+    if (turn->asteroidCount > 0) {
+        printf("        asteroids:");
+        for (int a = 0; a < turn->asteroidCount; a++) {
+            printf(" #%d(%u,%u)", a, turn->asteroidX[a], turn->asteroidY[a]);
+        }
+        printf("\n");
+    }
+}
+
+/**
+ * Flight log entry point
+ * Decodes the file and prints its turns, oldest first
+ */
+int main(int argc, char* argv[]) {
+    const char* path = argc > 1 ? argv[1] : FLIGHT_RECORDER_FILE;
+    if (argc > 2) {
+        fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+        return 1;
+    }
+
+    MappedFile file;
+    if (!mapFile(&file, path)) {
+        fprintf(stderr, "Could not read %s\n", path);
+        return 1;
+    }
+    FlightLog* log = (FlightLog*)malloc(sizeof(FlightLog));
+    if (log == NULL || !decodeFlightLog((const unsigned char*)file.data, file.length, log)) {
+        fprintf(stderr, "%s is not a flight recorder file\n", path);
+        free(log);
+        unmapFile(&file);
+        return 1;
+    }
+    unmapFile(&file);
+
+    printf("%dx%d world, %s, %d asteroids, %u turns played, last %d kept\n", log->worldWidth, log->worldHeight,
+           log->difficulty >= EASY && log->difficulty <= HARD ? difficultyNames[log->difficulty] : "unknown",
+           log->asteroidCount, log->totalTurns, log->turnCount);
+    if (log->asteroidCount > FLIGHT_RECORDER_ASTEROIDS) {
+        printf("(asteroid positions are kept for the first %d only)\n", FLIGHT_RECORDER_ASTEROIDS);
+    }
+    printf("\n%6s  %-4s %-13s %6s %6s %6s  %s\n", "turn", "cmd", "ship", "fuel", "health", "score", "events");
+    for (int i = 0; i < log->turnCount; i++) {
+        printTurn(&log->turns[i]);
+    }
+
+    free(log);
+    return 0;
+}
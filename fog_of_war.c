@@ -0,0 +1,186 @@
+/* Size types (size_t) */
+#include <stdlib.h>
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Fog of war declarations */
+#include "fog_of_war.h"
+
+/* Cells packed into one word of a bitset */
+#define FOG_CELLS_PER_WORD 32
+
+/* Coordinate transforms mapping the first octant onto each of the eight around the ship */
+static const int OCTANTS[8][4] = {
+    {1, 0, 0, 1}, {0, 1, 1, 0}, {0, -1, 1, 0}, {-1, 0, 0, 1},
+    {-1, 0, 0, -1}, {0, -1, -1, 0}, {0, 1, -1, 0}, {1, 0, 0, -1}
+};
+
+/* Read the bit of a cell in a bitset */
+static int cellBit(const FogOfWar* fog, const unsigned int* bits, int x, int y) {
+    return (int)(bits[(size_t)y * fog->rowWords + x / FOG_CELLS_PER_WORD] >> (x % FOG_CELLS_PER_WORD)) & 1;
+}
+
+/* Set the bit of a cell in a bitset */
+static void setCellBit(const FogOfWar* fog, unsigned int* bits, int x, int y) {
+    bits[(size_t)y * fog->rowWords + x / FOG_CELLS_PER_WORD] |= 1u << (x % FOG_CELLS_PER_WORD);
+}
+
+/* Allocate the bitsets of a world with nothing seen or blocking from an arena or the heap, returns 0 if out of memory */
+int initFogOfWar(FogOfWar* fog, Arena* arena, int width, int height) {
+    memset(fog, 0, sizeof(*fog));
+    fog->arena = arena;
+    fog->width = width;
+    fog->height = height;
+    fog->rowWords = (width + FOG_CELLS_PER_WORD - 1) / FOG_CELLS_PER_WORD;
+    fog->originX = -1;
+    size_t words = (size_t)fog->rowWords * height;
+    fog->blocked = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    fog->visible = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    fog->explored = (unsigned int*)arenaAlloc(arena, words * sizeof(unsigned int));
+    if (fog->blocked == NULL || fog->visible == NULL || fog->explored == NULL) {
+        freeFogOfWar(fog);
+        return 0;
+    }
+    return 1;
+}
+
+/* Free the bitsets of a fog of war, the ones from an arena go with the arena */
+void freeFogOfWar(FogOfWar* fog) {
+    arenaRelease(fog->arena, fog->blocked);
+    arenaRelease(fog->arena, fog->visible);
+    arenaRelease(fog->arena, fog->explored);
+    memset(fog, 0, sizeof(*fog));
+}
+
+/* Forget every cell seen and blocking, as if the fog was just allocated */
+void clearFogOfWar(FogOfWar* fog) {
+    size_t bytes = (size_t)fog->rowWords * fog->height * sizeof(unsigned int);
+    if (fog->blocked == NULL) {
+        return;
+    }
+    memset(fog->blocked, 0, bytes);
+    memset(fog->visible, 0, bytes);
+    memset(fog->explored, 0, bytes);
+    fog->originX = -1;
+}
+
+/* Mark a cell as blocking the line of sight */
+void markFogBlocker(FogOfWar* fog, int x, int y) {
+    setCellBit(fog, fog->blocked, x, y);
+}
+
+/* Clear the visible bits of the square a cast from the given cell could have reached */
+static void clearSight(FogOfWar* fog, int x, int y, int radius) {
+    int top = y - radius < 0 ? 0 : y - radius;
+    int bottom = y + radius >= fog->height ? fog->height - 1 : y + radius;
+    int left = (x - radius < 0 ? 0 : x - radius) / FOG_CELLS_PER_WORD;
+    int right = (x + radius >= fog->width ? fog->width - 1 : x + radius) / FOG_CELLS_PER_WORD;
+
+    /* Only the square's cells are ever set, so its words can be cleared whole */
+    for (int row = top; row <= bottom; row++) {
+        memset(&fog->visible[(size_t)row * fog->rowWords + left], 0, (size_t)(right - left + 1) * sizeof(unsigned int));
+    }
+}
+
+/* Make a cell visible and explored */
+static void revealCell(FogOfWar* fog, int x, int y) {
+    setCellBit(fog, fog->visible, x, y);
+    setCellBit(fog, fog->explored, x, y);
+}
+
+/*
+ * Scan the rows of one octant from the given distance outwards, lighting
+ * the cells whose centre lies between the start and end slopes. Each run
+ * of blocking cells narrows the light of the rows behind it, and the part
+ * of a row before a run is cast on by a recursive scan of its own.
+ */
+static void castOctant(FogOfWar* fog, int originX, int originY, int radius, int distance,
+                       double start, double end, const int* transform) {
+    if (start < end) {
+        return;
+    }
+    double nextStart = start;
+    for (int row = distance; row <= radius; row++) {
+        int blocked = 0;
+        for (int column = -row; column <= 0; column++) {
+            /* Slopes of the cell's corners, seen from the ship */
+            double leftSlope = (column - 0.5) / (-row + 0.5);
+            double rightSlope = (column + 0.5) / (-row - 0.5);
+            if (start < rightSlope) {
+                continue;
+            }
+            if (end > leftSlope) {
+                break;
+            }
+
+            /* Cells beyond the world edges block like obstacles */
+            int x = originX + column * transform[0] - row * transform[1];
+            int y = originY + column * transform[2] - row * transform[3];
+            int outside = x < 0 || x >= fog->width || y < 0 || y >= fog->height;
+            int opaque = outside || cellBit(fog, fog->blocked, x, y);
+            if (!outside && column * column + row * row <= radius * radius) {
+                revealCell(fog, x, y);
+            }
+
+            if (blocked) {
+                /* Still in a run of blocking cells, the light resumes after it */
+                if (opaque) {
+                    nextStart = rightSlope;
+                } else {
+                    blocked = 0;
+                    start = nextStart;
+                }
+            } else if (opaque && row < radius) {
+                /* A run starts, the cells before it are lit by a scan of their own */
+                blocked = 1;
+                castOctant(fog, originX, originY, radius, row + 1, start, leftSlope, transform);
+                nextStart = rightSlope;
+            }
+        }
+        if (blocked) {
+            break;
+        }
+    }
+}
+
+/* Cast visibility from the ship's cell within the sight radius, adding what it sees to the explored cells */
+void updateFogOfWar(FogOfWar* fog, int x, int y, int radius) {
+    /* Everything the last cast set lies in the square around where it was cast from */
+    if (fog->originX >= 0) {
+        clearSight(fog, fog->originX, fog->originY, fog->radius);
+    }
+    fog->originX = x;
+    fog->originY = y;
+    fog->radius = radius;
+
+    revealCell(fog, x, y);
+    for (int octant = 0; octant < 8; octant++) {
+        castOctant(fog, x, y, radius, 1, 1.0, 0.0, OCTANTS[octant]);
+    }
+}
+
+/* Return 1 if the cell is visible from the ship */
+int fogCellVisible(const FogOfWar* fog, int x, int y) {
+    return cellBit(fog, fog->visible, x, y);
+}
+
+/* Hide a drawn row of the map, unexplored cells become blank and asteroids out of sight are not shown */
+void maskFogRow(const FogOfWar* fog, int y, char* row) {
+    const unsigned int* visible = &fog->visible[(size_t)y * fog->rowWords];
+    const unsigned int* explored = &fog->explored[(size_t)y * fog->rowWords];
+    for (int word = 0; word < fog->rowWords; word++) {
+        /* Words fully in sight are drawn as they are */
+        if (visible[word] == ~0u) {
+            continue;
+        }
+        int first = word * FOG_CELLS_PER_WORD;
+        int last = first + FOG_CELLS_PER_WORD < fog->width ? first + FOG_CELLS_PER_WORD : fog->width;
+        for (int x = first; x < last; x++) {
+            unsigned int bit = 1u << (x - first);
+            if (!(explored[word] & bit)) {
+                row[x] = ' ';
+            } else if (!(visible[word] & bit) && row[x] == 'A') {
+                row[x] = '.';
+            }
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * SpaceXplorer Fog of War Header
+ *
+ * This header defines what the ship can see of the world. Visibility is
+ * found by shadowcasting from the ship over the eight octants around it,
+ * with obstacles blocking the line of sight. The visible and explored
+ * cells and the blocking cells are each stored as one bit per cell, a
+ * row of the world at a time. A move only clears and casts the square
+ * of the sight radius around the old and new positions, so its cost
+ * depends on the radius and not on the size of the world.
+ */
+
+#ifndef SPACEXPLORER_FOG_OF_WAR_H
+#define SPACEXPLORER_FOG_OF_WAR_H
+
+/* Arena the bitsets are allocated from */
+#include "arena.h"
+
+/**
+ * Fog of war
+ * Cell (x, y) is bit x % 32 of word y * rowWords + x / 32 of each bitset
+ */
+typedef struct {
+    int width;                  /* Width of the world */
+    int height;                 /* Height of the world */
+    int rowWords;               /* Words of each row of a bitset */
+    unsigned int* blocked;      /* Cells blocking the line of sight */
+    unsigned int* visible;      /* Cells the ship sees from where it is */
+    unsigned int* explored;     /* Cells the ship has ever seen */
+    int originX;                /* X-coordinate visibility was last cast from, -1 before the first cast */
+    int originY;                /* Y-coordinate visibility was last cast from */
+    int radius;                 /* Sight radius of the last cast */
+    Arena* arena;               /* Arena the bitsets come from, NULL for the heap */
+} FogOfWar;
+
+/* Allocate the bitsets of a world with nothing seen or blocking from an arena or the heap, returns 0 if out of memory */
+int initFogOfWar(FogOfWar* fog, Arena* arena, int width, int height);
+/* Free the bitsets of a fog of war, the ones from an arena go with the arena */
+void freeFogOfWar(FogOfWar* fog);
+/* Forget every cell seen and blocking, as if the fog was just allocated */
+void clearFogOfWar(FogOfWar* fog);
+/* Mark a cell as blocking the line of sight */
+void markFogBlocker(FogOfWar* fog, int x, int y);
+/* Cast visibility from the ship's cell within the sight radius, adding what it sees to the explored cells */
+void updateFogOfWar(FogOfWar* fog, int x, int y, int radius);
+/* Return 1 if the cell is visible from the ship */
+int fogCellVisible(const FogOfWar* fog, int x, int y);
+/* Hide a drawn row of the map, unexplored cells become blank and asteroids out of sight are not shown */
+void maskFogRow(const FogOfWar* fog, int y, char* row);
+
+#endif /* SPACEXPLORER_FOG_OF_WAR_H */
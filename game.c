@@ -10,30 +10,79 @@
 #include <ctype.h>
 /* Game-specific declarations and structures */
 #include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Default assets embedded at build time */
+#include "assets.h"
+/* Optional timing instrumentation */
+#include "stats.h"
+/* Record of the last turns for post-mortems */
+#include "flight_recorder.h"
+/* Procedural placement of obstacles and junk */
+#include "worldgen.h"
+/* Cells the ship can reach from where it starts */
+#include "reachability.h"
+/* Connectivity of the free cells while obstacles are placed */
+#include "obstacle_sets.h"
+/* Worlds read from level files */
+#include "level.h"
+/* Worker threads the asteroid field is moved on */
+#include "thread_pool.h"
 
-/* Fuel levels for each difficulty (Easy, Medium, Hard) */
-const int FUEL_LEVELS[] = {500, 350, 200};
-/* Fuel consumption rates for each move based on difficulty */
-const int FUEL_CONSUMPTION[] = {1, 2, 3};
-/* Number of collectible junk items for each difficulty level */
-const int JUNK_COUNTS[] = {40, 30, 20};
-/* Asteroid movement speeds for each difficulty level */
-const int ASTEROID_SPEEDS[] = {1, 2, 3};
-/* Score required to win at each difficulty level */
-const int WIN_SCORES[] = {500, 750, 1000};
-
-/* File path for game configuration settings */
+/* Random cells tried when placing respawned junk or a new asteroid before giving up for the turn */
+#define TIMED_EVENT_PLACEMENT_ATTEMPTS 16
+/* Smallest number of asteroids moved with the vector kernel */
+#define FIELD_VECTOR_MIN_ASTEROIDS 32
+/* Most cells per asteroid for the vector kernel, which copies the whole occupancy index every step */
+#define FIELD_VECTOR_MAX_CELLS_PER_ASTEROID 1024
+/* Random cells tried for an obstacle before the world is taken to be full and no more are placed */
+#define OBSTACLE_PLACEMENT_ATTEMPTS 4096
+/* Worlds generated for a new game before one that fails the reachability filter is kept anyway */
+#define WORLD_GENERATION_ATTEMPTS 8
+/* Random edge cells tried for an asteroid the map of a streamed world moved away from before it is dropped */
+#define STREAMED_ASTEROID_ATTEMPTS 16
+/* Bytes of a game's arena per cell, more than the rows, the obstacle map, the junk handles, the asteroid index and the fog take */
+#define ARENA_BYTES_PER_CELL 12
+/* Bytes of a game's arena per configured asteroid, obstacle and junk item */
+#define ARENA_BYTES_PER_OBJECT 64
+/* Bytes of a game's arena on top, for the objects and events added while it is played */
+#define ARENA_HEADROOM ((size_t)16 << 20)
+/* Components of the obstacles */
+#define OBSTACLE_COMPONENTS (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_SYMBOL) | COMPONENT_BIT(COMPONENT_BLOCKING))
+/* Components of the junk items */
+#define JUNK_COMPONENTS (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_SYMBOL) | COMPONENT_BIT(COMPONENT_COLLECTIBLE))
+
+/* File path for optional game configuration overrides */
 const char* CONFIG_FILE = "config.txt";
 /* File path for storing player high scores */
 const char* LEADERBOARD_FILE = "leaderboard.txt";
-/* File path for game introduction text */
+/* File path for an optional game introduction text override */
 const char* INTRO_FILE = "intro.txt";
+/* File path of the level to play, NULL for random worlds */
+const char* LEVEL_FILE = NULL;
+/* Nanoseconds spent waiting for the player at the welcome and setup prompts */
+long long promptWaitNanos = 0;
+
+/* Show a prompt and wait for the player to press Enter, only when playing on the console */
+static void waitForEnter(Game* game, const char* prompt) {
+    if (game->output == NULL) {
+        /* Time the wait so stalls on the player show up in the trace */
+        long long waitStart = STATS_START();
+        printf("%s", prompt);
+        while (getchar() != '\n');
+        getchar();
+        STATS_STOP(STATS_WAIT, waitStart);
+    }
+}
 
 /* Initialize the game with player info, difficulty settings, and game objects */
 void initGame(Game* game) {
     /* Variable to store user's difficulty choice */
     char difficultyChar;
     
+    /* The prompts are timed so the startup profile can leave the player's time out */
+    long long waitStart = currentTimeNanos();
+    
     /* Prompt user for player name and store it */
     printf("Enter your name (max %d characters): ", MAX_NAME_LENGTH - 1);
     fgets(game->playerName, MAX_NAME_LENGTH, stdin);
@@ -58,25 +107,23 @@ void initGame(Game* game) {
     
     /* Clear input buffer */
     while (getchar() != '\n');
+    promptWaitNanos += currentTimeNanos() - waitStart;
     
-    /* Load world dimensions from config file */
-    loadConfig(game);
+    /* Load world dimensions and balance settings from config file */
+    loadConfig();
     
-    /* Allocate memory for game world */
-    createWorld(game);
+    /* Interactive games write straight to the console */
+    game->output = NULL;
     
-    /* Initialize player's spaceship position and stats */
-    game->ship.position.x = game->worldWidth / 2;
-    game->ship.position.y = game->worldHeight / 2;
-    game->ship.fuel = FUEL_LEVELS[game->difficulty];
-    game->ship.maxFuel = FUEL_LEVELS[game->difficulty];
-    game->ship.health = 100;
-    game->ship.maxHealth = 100;
-    game->ship.metal = 0;
-    game->ship.plastic = 0;
-    game->ship.electronics = 0;
-    game->ship.fuelCells = 0;
+    /* Create the world and place all game objects */
+    setupGame(game);
     
+    /* Keep a record of the last turns in case the game is lost or crashes */
+    startFlightRecorder(game);
+}
+
+/* Place an asteroid on a random edge of the world, moving away from it */
+static void placeAtEdge(Game* game, Asteroid* asteroid) {
     /* Randomly choose which edge the asteroid will start from (0=top, 1=right, 2=bottom, 3=left) */
     int edge = rand() % 4;
     
@@ -84,205 +131,663 @@ void initGame(Game* game) {
     switch (edge) {
         case 0:
             /* Top edge */
-            game->asteroid.position.x = rand() % game->worldWidth;
-            game->asteroid.position.y = 0;
-            game->asteroid.direction.x = (rand() % 3) - 1; /* -1, 0, or 1 */
-            game->asteroid.direction.y = 1; /* Moving down */
+            asteroid->position.x = rand() % game->worldWidth;
+            asteroid->position.y = 0;
+            asteroid->direction.x = (rand() % 3) - 1; /* -1, 0, or 1 */
+            asteroid->direction.y = 1; /* Moving down */
             break;
         case 1:
             /* Right edge */
-            game->asteroid.position.x = game->worldWidth - 1;
-            game->asteroid.position.y = rand() % game->worldHeight;
-            game->asteroid.direction.x = -1; /* Moving left */
-            game->asteroid.direction.y = (rand() % 3) - 1; /* -1, 0, or 1 */
+            asteroid->position.x = game->worldWidth - 1;
+            asteroid->position.y = rand() % game->worldHeight;
+            asteroid->direction.x = -1; /* Moving left */
+            asteroid->direction.y = (rand() % 3) - 1; /* -1, 0, or 1 */
             break;
         case 2:
             /* Bottom edge */
-            game->asteroid.position.x = rand() % game->worldWidth;
-            game->asteroid.position.y = game->worldHeight - 1;
-            game->asteroid.direction.x = (rand() % 3) - 1; /* -1, 0, or 1 */
-            game->asteroid.direction.y = -1; /* Moving up */
+            asteroid->position.x = rand() % game->worldWidth;
+            asteroid->position.y = game->worldHeight - 1;
+            asteroid->direction.x = (rand() % 3) - 1; /* -1, 0, or 1 */
+            asteroid->direction.y = -1; /* Moving up */
             break;
-        case 3:
+        default:
             /* Left edge */
-            game->asteroid.position.x = 0;
-            game->asteroid.position.y = rand() % game->worldHeight;
-            game->asteroid.direction.x = 1; /* Moving right */
-            game->asteroid.direction.y = (rand() % 3) - 1; /* -1, 0, or 1 */
+            asteroid->position.x = 0;
+            asteroid->position.y = rand() % game->worldHeight;
+            asteroid->direction.x = 1; /* Moving right */
+            asteroid->direction.y = (rand() % 3) - 1; /* -1, 0, or 1 */
             break;
     }
     
     /* Ensure asteroid is moving (not stationary) */
-    if (game->asteroid.direction.x == 0 && game->asteroid.direction.y == 0) {
-        game->asteroid.direction.x = 1;
+    if (asteroid->direction.x == 0 && asteroid->direction.y == 0) {
+        asteroid->direction.x = 1;
     }
+    asteroid->symbol = 'A';
+}
+
+/* Schedule the repeating events for the current settings, replacing the ones already pending */
+void scheduleRepeatingEvents(Game* game) {
+    cancelEvent(&game->events, game->fuelLeak);
+    cancelEvent(&game->events, game->asteroidSpawn);
+    memset(&game->fuelLeak, 0, sizeof(game->fuelLeak));
+    memset(&game->asteroidSpawn, 0, sizeof(game->asteroidSpawn));
     
-    /* Set asteroid symbol for display */
-    game->asteroid.symbol = 'A';
+    /* A period of 0 turns the event off */
+    if (gameConfig.fuelLeakTurns[game->difficulty] > 0) {
+        game->fuelLeak = scheduleEvent(&game->events, gameConfig.fuelLeakTurns[game->difficulty], EVENT_FUEL_LEAK, 0);
+    }
+    if (gameConfig.asteroidSpawnTurns[game->difficulty] > 0) {
+        game->asteroidSpawn = scheduleEvent(&game->events, gameConfig.asteroidSpawnTurns[game->difficulty], EVENT_ASTEROID_SPAWN, 0);
+    }
+}
+
+/* Set the entity counts of a game to the number of entities in each archetype */
+static void syncEntityCounts(Game* game) {
+    game->impassableCount = game->entities[ENTITY_OBSTACLES].pool.count;
+    game->junkCount = game->entities[ENTITY_JUNK].pool.count;
+}
+
+/* Spawn an entity of a kind on a free cell shown as a symbol, returns its index or -1 if out of memory */
+static int spawnOnCell(Game* game, EntityKind kind, int x, int y, char symbol) {
+    Archetype* archetype = &game->entities[kind];
+    int index = spawnArchetypeEntity(archetype);
+    if (index < 0) {
+        return -1;
+    }
+    ARCHETYPE_COLUMN(archetype, COMPONENT_POSITION, Position)[index].x = x;
+    ARCHETYPE_COLUMN(archetype, COMPONENT_POSITION, Position)[index].y = y;
+    ARCHETYPE_COLUMN(archetype, COMPONENT_SYMBOL, char)[index] = symbol;
     
-    /* Place impassable cells (obstacles) randomly in the world */
-    for (int i = 0; i < IMPASSABLE_CELLS; i++) {
-        int valid = 0;
-        while (!valid) {
-            int x = rand() % game->worldWidth;
-            int y = rand() % game->worldHeight;
-            
-            /* Ensure obstacle doesn't overlap with ship or asteroid */
-            if ((x != game->ship.position.x || y != game->ship.position.y) &&
-                (x != game->asteroid.position.x || y != game->asteroid.position.y)) {
-                
-                int overlap = 0;
-                /* Check if position overlaps with previously placed obstacles */
-                for (int j = 0; j < i; j++) {
-                    if (game->impassableCells[j].position.x == x && 
-                        game->impassableCells[j].position.y == y) {
-                        overlap = 1;
-                        break;
-                    }
-                }
-                
-                /* If no overlap, place the obstacle */
-                if (!overlap) {
-                    game->impassableCells[i].position.x = x;
-                    game->impassableCells[i].position.y = y;
-                    game->impassableCells[i].symbol = '#';
-                    valid = 1;
-                }
+    /* Blocking entities stop the ship, bounce asteroids and hide what is behind them */
+    if (archetype->components & COMPONENT_BIT(COMPONENT_BLOCKING)) {
+        game->obstacleMap[y * game->worldWidth + x] = 1;
+        markFieldObstacle(&game->asteroids, x, y);
+        markFogBlocker(&game->fog, x, y);
+    }
+    game->world[y][x] = symbol;
+    syncEntityCounts(game);
+    return index;
+}
+
+/* Turn a free cell into an obstacle, returns its index or -1 if out of memory */
+int placeObstacle(Game* game, int x, int y) {
+    return spawnOnCell(game, ENTITY_OBSTACLES, x, y, '#');
+}
+
+/* Spawn a junk item of a type on a free cell, returns its index or -1 if out of memory */
+int placeJunk(Game* game, int x, int y, JunkType type) {
+    /* The item goes after the last one, its slot in the archetype's pool keeps track of it when others are removed */
+    int index = spawnOnCell(game, ENTITY_JUNK, x, y, junkSymbol(type));
+    if (index < 0) {
+        return -1;
+    }
+    
+    /* The cell keeps the item's handle, which still finds it after swap-removes move it to another index */
+    game->junkCells[y * game->worldWidth + x] = entityHandle(&game->entities[ENTITY_JUNK].pool, index);
+    
+    /* Score value comes from the settings for this junk type */
+    Collectible* collectible = &ARCHETYPE_COLUMN(&game->entities[ENTITY_JUNK], COMPONENT_COLLECTIBLE, Collectible)[index];
+    collectible->type = type;
+    collectible->value = gameConfig.junkValues[type];
+    return index;
+}
+
+/* Return the index of the junk item on a cell, -1 if there is none */
+static int junkAt(const Game* game, int x, int y) {
+    /* Handles of removed items are stale, so the cells need no clearing when junk is collected or the archetype cleared */
+    return entityIndex(&game->entities[ENTITY_JUNK].pool, game->junkCells[y * game->worldWidth + x]);
+}
+
+/* Despawn a junk item, the last one moves into its index */
+void removeJunk(Game* game, int index) {
+    despawnArchetypeEntity(&game->entities[ENTITY_JUNK], index);
+    syncEntityCounts(game);
+}
+
+/* Place noise-shaped belts of about the given numbers of obstacles and junk items, returns 0 if out of memory */
+static int placeProceduralWorld(Game* game, int obstacles, int junk) {
+    /* The world seed comes from the random sequence, so a configured seed gives the same world */
+    GeneratedWorld generated;
+    if (!generateWorld(&generated, game->world, game->worldWidth, game->worldHeight, (unsigned int)rand(),
+                       obstacles, junk)) {
+        return 0;
+    }
+    
+    /* The counts only come close to the configured ones, the archetypes grow if more were placed */
+    if (!reserveEntities(game, generated.obstacleCount, generated.junkCount)) {
+        freeGeneratedWorld(&generated);
+        return 0;
+    }
+    
+    /* Obstacles that would cut the free cells apart are left out, there is no other cell to move them to on a belt */
+    ObstacleSets sets;
+    int connected = initObstacleSets(&sets, game->worldWidth, game->worldHeight, generated.obstacleCount);
+    for (int i = 0; i < generated.obstacleCount; i++) {
+        int x = generated.obstacles[i].x;
+        int y = generated.obstacles[i].y;
+        if (!connected || obstacleKeepsConnected(&sets, x, y)) {
+            placeObstacle(game, x, y);
+            if (connected) {
+                addObstacleToSets(&sets, x, y);
             }
         }
     }
+    if (connected) {
+        freeObstacleSets(&sets);
+    }
+    for (int i = 0; i < generated.junkCount; i++) {
+        placeJunk(game, generated.junk[i].x, generated.junk[i].y, (JunkType)generated.junk[i].type);
+    }
+    freeGeneratedWorld(&generated);
+    return 1;
+}
+
+/* Create the world and place the ship, the asteroids, the obstacles and the junk */
+static void placeWorld(Game* game) {
+    /* Set entity counts from the settings for the chosen difficulty, createWorld makes room for them */
+    int obstacles = gameConfig.obstacleCount;
+    int junk = gameConfig.junkCounts[game->difficulty];
+    game->impassableCount = obstacles;
+    game->junkCount = junk;
     
-    /* Set junk count based on difficulty level */
-    game->junkCount = JUNK_COUNTS[game->difficulty];
+    /* Allocate memory for game world */
+    createWorld(game);
     
-    /* Place junk items randomly in the world */
-    for (int i = 0; i < game->junkCount; i++) {
-        int valid = 0;
-        while (!valid) {
-            int x = rand() % game->worldWidth;
-            int y = rand() % game->worldHeight;
-            
-            /* Ensure junk doesn't overlap with ship or asteroid */
-            if ((x != game->ship.position.x || y != game->ship.position.y) &&
-                (x != game->asteroid.position.x || y != game->asteroid.position.y)) {
-                
-                int overlap = 0;
-                
-                /* Check if position overlaps with obstacles */
-                for (int j = 0; j < IMPASSABLE_CELLS; j++) {
-                    if (game->impassableCells[j].position.x == x && 
-                        game->impassableCells[j].position.y == y) {
-                        overlap = 1;
-                        break;
-                    }
-                }
+    /* Mark every cell as free, placed objects claim their cells below */
+    for (int y = 0; y < game->worldHeight; y++) {
+        for (int x = 0; x < game->worldWidth; x++) {
+            game->world[y][x] = '.';
+        }
+    }
+    
+    /* Start the ship in the middle of the world */
+    game->ship.position.x = game->worldWidth / 2;
+    game->ship.position.y = game->worldHeight / 2;
+    game->world[game->ship.position.y][game->ship.position.x] = 'S';
+    
+    AsteroidField* field = &game->asteroids;
+    for (int i = 0; i < field->count; i++) {
+        Asteroid asteroid;
+        placeAtEdge(game, &asteroid);
+        
+        /* Store the asteroid in the field's arrays and show it on the map */
+        field->x[i] = asteroid.position.x;
+        field->y[i] = asteroid.position.y;
+        field->dx[i] = asteroid.direction.x;
+        field->dy[i] = asteroid.direction.y;
+        field->id[i] = i;
+        game->world[asteroid.position.y][asteroid.position.x] = 'A';
+    }
+    sortAsteroidField(field);
+    
+    /* Shape the world from noise when procedural worlds are on, otherwise scatter everything evenly */
+    if (!gameConfig.proceduralWorld || !placeProceduralWorld(game, obstacles, junk)) {
+        /* Obstacles that would cut the free cells apart are moved to another cell, so all junk stays reachable */
+        ObstacleSets sets;
+        int connected = initObstacleSets(&sets, game->worldWidth, game->worldHeight, obstacles);
+        
+        /* Place impassable cells (obstacles) randomly in the world */
+        for (int i = 0; i < obstacles; i++) {
+            int valid = 0;
+            for (int attempt = 0; !valid && attempt < OBSTACLE_PLACEMENT_ATTEMPTS; attempt++) {
+                int x = rand() % game->worldWidth;
+                int y = rand() % game->worldHeight;
                 
-                /* Check if position overlaps with other junk items */
-                if (!overlap) {
-                    for (int j = 0; j < i; j++) {
-                        if (game->junkItems[j].position.x == x && 
-                            game->junkItems[j].position.y == y) {
-                            overlap = 1;
-                            break;
-                        }
+                /* Ensure obstacle doesn't overlap with the ship, asteroids or other obstacles */
+                if (game->world[y][x] == '.' && (!connected || obstacleKeepsConnected(&sets, x, y))) {
+                    placeObstacle(game, x, y);
+                    if (connected) {
+                        addObstacleToSets(&sets, x, y);
                     }
+                    valid = 1;
                 }
+            }
+            
+            /* Hardly any cell is left that would not cut the world apart, so the rest are not placed */
+            if (!valid) {
+                break;
+            }
+        }
+        if (connected) {
+            freeObstacleSets(&sets);
+        }
+        
+        /* Place junk items randomly in the world */
+        for (int i = 0; i < junk; i++) {
+            int valid = 0;
+            while (!valid) {
+                int x = rand() % game->worldWidth;
+                int y = rand() % game->worldHeight;
                 
-                /* If no overlap, place the junk item */
-                if (!overlap) {
-                    game->junkItems[i].position.x = x;
-                    game->junkItems[i].position.y = y;
+                /* Ensure junk doesn't overlap with the ship, asteroids, obstacles or other junk */
+                if (game->world[y][x] == '.') {
                     /* Randomly determine junk type (0-3) */
-                    game->junkItems[i].type = rand() % 4;
-                    game->junkItems[i].collected = 0;
-                    
-                    /* Set junk properties based on type */
-                    switch (game->junkItems[i].type) {
-                        case METAL:
-                            game->junkItems[i].value = 10;
-                            game->junkItems[i].symbol = 'M';
-                            break;
-                        case PLASTIC:
-                            game->junkItems[i].value = 5;
-                            game->junkItems[i].symbol = 'P';
-                            break;
-                        case ELECTRONICS:
-                            game->junkItems[i].value = 15;
-                            game->junkItems[i].symbol = 'E';
-                            break;
-                        case FUEL_CELL:
-                            game->junkItems[i].value = 20;
-                            game->junkItems[i].symbol = 'F';
-                            break;
-                    }
-                    
+                    placeJunk(game, x, y, (JunkType)(rand() % 4));
                     valid = 1;
                 }
             }
         }
     }
+}
+
+/*
+ * Reachability filter for new worlds, not a proof that they can be won.
+ * The obstacles must not cut the ship off from junk it could fly to in
+ * open space: the junk it can reach on a full tank must be worth as much
+ * as the junk within that many moves with no obstacles in the way, up to
+ * the win score. Each item is checked on its own, so junk the ship can
+ * reach one at a time still passes when one tank cannot collect it all,
+ * and a world whose junk is worth less than the win score passes when it
+ * is all reachable, leaving the rest of the score to respawned junk.
+ */
+static int junkReachable(Game* game) {
+    /* The move that empties the tank ends the game before the junk on its cell is collected */
+    int consumption = gameConfig.fuelConsumption[game->difficulty];
+    int moves = consumption > 0 ? (game->ship.fuel - 1) / consumption : -1;
+    
+    /* A world that cannot be checked is played as it is */
+    ReachMap map;
+    if (!initReachMap(&map, game->worldWidth, game->worldHeight)) {
+        return 1;
+    }
+    floodFillReach(&map, game->obstacleMap, game->ship.position.x, game->ship.position.y, moves);
+    
+    /* Junk is in range when the ship could fly to it with no obstacles in the way */
+    const Archetype* junk = &game->entities[ENTITY_JUNK];
+    const Position* positions = ARCHETYPE_COLUMN(junk, COMPONENT_POSITION, Position);
+    const Collectible* collectibles = ARCHETYPE_COLUMN(junk, COMPONENT_COLLECTIBLE, Collectible);
+    long long inRange = 0;
+    long long reachable = 0;
+    for (int i = 0; i < junk->pool.count; i++) {
+        int distance = abs(positions[i].x - game->ship.position.x) + abs(positions[i].y - game->ship.position.y);
+        if (moves < 0 || distance <= moves) {
+            inRange += collectibles[i].value;
+        }
+        if (cellReached(&map, positions[i].x, positions[i].y)) {
+            reachable += collectibles[i].value;
+        }
+    }
+    freeReachMap(&map);
+    
+    long long needed = inRange < gameConfig.winScores[game->difficulty] ? inRange : gameConfig.winScores[game->difficulty];
+    return reachable >= needed;
+}
+
+/* Create the world with the objects of the level file, returns 0 if the file cannot be used */
+static int loadLevelWorld(Game* game) {
+    /* The level's objects are added to an empty world as they are read */
+    game->impassableCount = 0;
+    game->junkCount = 0;
+    createWorld(game);
+    if (!loadLevel(game, LEVEL_FILE)) {
+        cleanupGame(game);
+        return 0;
+    }
+    return 1;
+}
+
+/* Read the obstacles and junk of the map from the streamed world after the map moved */
+static void loadStreamedMap(Game* game) {
+    int width = game->worldWidth;
+    int height = game->worldHeight;
+    
+    /* The map's sectors were asked for when it last moved, so they are rarely still loading */
+    int waited = requireSectors(game->sectors, game->originX, game->originY, width, height);
+    STATS_COUNT(STATS_SECTOR_WAITS, waited);
+    /* The next move of the map goes at most half a map further, its sectors load in the background meanwhile */
+    prefetchSectors(game->sectors, game->originX - width / 2 - 1, game->originY - height / 2 - 1,
+                    width * 2 + 2, height * 2 + 2);
+    
+    /* The obstacles of the old map are cleared from everything they were marked in */
+    memset(game->obstacleMap, 0, (size_t)width * height);
+    clearFieldObstacles(&game->asteroids);
+    clearFogOfWar(&game->fog);
+    
+    /* Copy the cells into the map's rows, then make room in the archetypes for what they hold */
+    int obstacles = 0;
+    int junk = 0;
+    for (int y = 0; y < height; y++) {
+        readSectorRow(game->sectors, game->originX, game->originY + y, width, game->world[y]);
+        for (int x = 0; x < width; x++) {
+            obstacles += game->world[y][x] == '#';
+            junk += game->world[y][x] != '#' && game->world[y][x] != '.';
+        }
+    }
+    reserveEntities(game, obstacles, junk);
+    
+    /* Objects there is no room for are left off the map */
+    for (int kind = 0; kind < ENTITY_KINDS; kind++) {
+        clearArchetype(&game->entities[kind]);
+    }
+    syncEntityCounts(game);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            char symbol = game->world[y][x];
+            if (symbol == '#' && game->impassableCount < game->entities[ENTITY_OBSTACLES].capacity) {
+                placeObstacle(game, x, y);
+            } else if (symbol != '#' && symbol != '.' && game->junkCount < game->entities[ENTITY_JUNK].capacity) {
+                placeJunk(game, x, y,
+                          symbol == 'M' ? METAL : symbol == 'P' ? PLASTIC : symbol == 'E' ? ELECTRONICS : FUEL_CELL);
+            }
+        }
+    }
+    
+    /* Asteroids left off the map or on an obstacle come in again from an edge */
+    AsteroidField* field = &game->asteroids;
+    for (int i = 0; i < field->count; i++) {
+        int x = field->x[i];
+        int y = field->y[i];
+        int placed = x >= 0 && x < width && y >= 0 && y < height && !game->obstacleMap[y * width + x];
+        for (int attempt = 0; !placed && attempt < STREAMED_ASTEROID_ATTEMPTS; attempt++) {
+            Asteroid asteroid;
+            placeAtEdge(game, &asteroid);
+            x = asteroid.position.x;
+            y = asteroid.position.y;
+            if (!game->obstacleMap[y * width + x] && (x != game->ship.position.x || y != game->ship.position.y)) {
+                field->x[i] = x;
+                field->y[i] = y;
+                field->dx[i] = asteroid.direction.x;
+                field->dy[i] = asteroid.direction.y;
+                placed = 1;
+            }
+        }
+        
+        /* An asteroid with nowhere to go is dropped, the last one takes its place */
+        if (!placed) {
+            field->count--;
+            field->x[i] = field->x[field->count];
+            field->y[i] = field->y[field->count];
+            field->dx[i] = field->dx[field->count];
+            field->dy[i] = field->dy[field->count];
+            field->id[i] = field->id[field->count];
+            i--;
+        }
+    }
+    sortAsteroidField(field);
+    
+    /* Look around again on the new map */
+    updateSight(game);
+}
+
+/* Start a streamed world with the ship in the middle of the map, returns 0 if out of memory */
+static int placeStreamedWorld(Game* game) {
+    /* The archetypes are sized for each map as it is read */
+    game->impassableCount = 0;
+    game->junkCount = 0;
+    createWorld(game);
+    
+    /* The sectors are generated from the random sequence, so a configured seed gives the same world */
+    game->sectors = openSectorWorld((unsigned int)rand(), gameConfig.obstacleCount, gameConfig.junkCounts[game->difficulty],
+                                    (long long)game->worldWidth * game->worldHeight, (size_t)gameConfig.sectorCacheKb * 1024);
+    if (game->sectors == NULL) {
+        cleanupGame(game);
+        return 0;
+    }
+    
+    /* The ship starts on cell (0, 0) of the streamed world, which is kept clear, in the middle of the map */
+    game->ship.position.x = game->worldWidth / 2;
+    game->ship.position.y = game->worldHeight / 2;
+    game->originX = -game->ship.position.x;
+    game->originY = -game->ship.position.y;
+    
+    /* Asteroids start on the edges as in other worlds, the ones on an obstacle move when the map is read */
+    AsteroidField* field = &game->asteroids;
+    for (int i = 0; i < field->count; i++) {
+        Asteroid asteroid;
+        placeAtEdge(game, &asteroid);
+        field->x[i] = asteroid.position.x;
+        field->y[i] = asteroid.position.y;
+        field->dx[i] = asteroid.direction.x;
+        field->dy[i] = asteroid.direction.y;
+        field->id[i] = i;
+    }
+    loadStreamedMap(game);
+    return 1;
+}
+
+/* Move the map over a streamed world to bring the ship back to its middle when it nears an edge */
+static void followShip(Game* game) {
+    int marginX = game->worldWidth / 4;
+    int marginY = game->worldHeight / 4;
+    int dx = 0;
+    int dy = 0;
+    if (game->ship.position.x < marginX || game->ship.position.x >= game->worldWidth - marginX) {
+        dx = game->ship.position.x - game->worldWidth / 2;
+    }
+    if (game->ship.position.y < marginY || game->ship.position.y >= game->worldHeight - marginY) {
+        dy = game->ship.position.y - game->worldHeight / 2;
+    }
+    if (dx == 0 && dy == 0) {
+        /* Take in the sectors loaded since the last move without waiting for any */
+        pollSectors(game->sectors);
+        return;
+    }
+    
+    /* Everything on the map keeps its place in the streamed world */
+    game->originX += dx;
+    game->originY += dy;
+    game->ship.position.x -= dx;
+    game->ship.position.y -= dy;
+    for (int i = 0; i < game->asteroids.count; i++) {
+        game->asteroids.x[i] -= dx;
+        game->asteroids.y[i] -= dy;
+    }
+    loadStreamedMap(game);
+}
+
+/* Set up a new game for the player name and difficulty already stored in the game */
+void setupGame(Game* game) {
+    /* Use the configured seed when one is set, so worlds can be reproduced */
+    if (gameConfig.seed != 0) {
+        srand((unsigned int)gameConfig.seed);
+    }
+    
+    /* Set world size from the settings */
+    game->worldWidth = gameConfig.worldWidth;
+    game->worldHeight = gameConfig.worldHeight;
+    
+    /* Initialize player's spaceship stats */
+    game->ship.fuel = gameConfig.fuelLevels[game->difficulty];
+    game->ship.maxFuel = gameConfig.fuelLevels[game->difficulty];
+    game->ship.health = gameConfig.maxHealth;
+    game->ship.maxHealth = gameConfig.maxHealth;
+    game->ship.metal = 0;
+    game->ship.plastic = 0;
+    game->ship.electronics = 0;
+    game->ship.fuelCells = 0;
+    
+    /* Only a streamed world has sectors */
+    game->sectors = NULL;
+    
+    /* Play the level file as it is drawn when one is set, then a streamed world when those are on, otherwise a random world */
+    int placed = LEVEL_FILE != NULL && loadLevelWorld(game);
+    if (!placed && gameConfig.streamingWorld) {
+        placed = placeStreamedWorld(game);
+    }
+    if (!placed) {
+        placeWorld(game);
+        
+        /* Generate the world again while obstacles wall the ship in or cut it off from junk in range of its fuel */
+        for (int attempt = 1; gameConfig.winnableWorlds && attempt < WORLD_GENERATION_ATTEMPTS && !junkReachable(game); attempt++) {
+            cleanupGame(game);
+            placeWorld(game);
+        }
+    }
     
     /* Initialize game score and state */
     game->score = 0;
     game->isGameOver = 0;
     game->hasWon = 0;
+    
+    /* Start with the shield down and the repeating events on the new wheel */
+    game->shielded = 0;
+    memset(&game->shieldExpiry, 0, sizeof(game->shieldExpiry));
+    memset(&game->fuelLeak, 0, sizeof(game->fuelLeak));
+    memset(&game->asteroidSpawn, 0, sizeof(game->asteroidSpawn));
+    scheduleRepeatingEvents(game);
+    
+    /* Look around from where the ship starts */
+    updateSight(game);
+    
+    /* Pick the step kernels for this difficulty's settings */
+    selectKernels(game);
+    
+    /* Start the worker threads now rather than in whichever turn first moves the field on them */
+    workerThreads();
 }
 
-/* Load game configuration from file or create with default values if file doesn't exist */
-void loadConfig(Game* game) {
-    /* Try to open config file for reading */
-    FILE* file = fopen(CONFIG_FILE, "r");
+/* Return the map symbol for a junk type */
+char junkSymbol(JunkType type) {
+    switch (type) {
+        case METAL: return 'M';
+        case PLASTIC: return 'P';
+        case ELECTRONICS: return 'E';
+        case FUEL_CELL: return 'F';
+    }
+    return '?';
+}
+
+/* Load game configuration, using the built-in defaults unless a config file overrides them */
+void loadConfig(void) {
+    /* Start from the built-in defaults so keys missing from the file keep their values */
+    setDefaultConfig(&gameConfig);
     
-    /* Set default minimum values for world dimensions */
-    game->worldWidth = WORLD_MIN_SIZE;
-    game->worldHeight = WORLD_MIN_SIZE;
+    /* Apply the config file on top of the defaults if one exists */
+    loadConfigFile(&gameConfig, CONFIG_FILE);
     
-    if (file != NULL) {
-        /* Read world width and height from config file */
-        fscanf(file, "width=%d\n", &game->worldWidth);
-        fscanf(file, "height=%d\n", &game->worldHeight);
-        
-        /* Close the file after reading */
-        fclose(file);
-        
-        /* Ensure values are not below the minimum allowed size */
-        if (game->worldWidth < WORLD_MIN_SIZE) game->worldWidth = WORLD_MIN_SIZE;
-        if (game->worldHeight < WORLD_MIN_SIZE) game->worldHeight = WORLD_MIN_SIZE;
-    } else {
-        /* If config file doesn't exist, create it with default values */
-        file = fopen(CONFIG_FILE, "w");
-        if (file != NULL) {
-            fprintf(file, "width=%d\n", game->worldWidth);
-            fprintf(file, "height=%d\n", game->worldHeight);
-            fclose(file);
-        }
+    /* A level file has the world size it is drawn with, one that cannot be played is dropped for a generated world */
+    int levelWidth, levelHeight;
+    if (LEVEL_FILE != NULL && readLevelSize(LEVEL_FILE, &levelWidth, &levelHeight)) {
+        gameConfig.worldWidth = levelWidth;
+        gameConfig.worldHeight = levelHeight;
+    } else if (LEVEL_FILE != NULL) {
+        fprintf(stderr, "Level %s: playing a generated world instead\n", LEVEL_FILE);
+        LEVEL_FILE = NULL;
+    }
+    
+    /* Ensure values are within the limits the game supports */
+    validateConfig(&gameConfig);
+    
+    /* Watch the file so balance changes can be picked up during the game */
+    startConfigWatch(CONFIG_FILE);
+}
+
+/* Re-read the config file, keeping the settings that cannot change during a game */
+int reloadConfig(void) {
+    GameConfig config;
+    setDefaultConfig(&config);
+    if (!loadConfigFile(&config, CONFIG_FILE)) {
+        return 0;
+    }
+    validateConfig(&config);
+    
+    /* Entity counts take effect in the next game, a new world size needs a restart */
+    config.worldWidth = gameConfig.worldWidth;
+    config.worldHeight = gameConfig.worldHeight;
+    gameConfig = config;
+    return 1;
+}
+
+/* Apply reloaded settings to a game that is already running */
+void applyConfig(Game* game) {
+    /* Update the value of junk that is still waiting to be collected */
+    Collectible* collectibles = ARCHETYPE_COLUMN(&game->entities[ENTITY_JUNK], COMPONENT_COLLECTIBLE, Collectible);
+    for (int i = 0; i < game->junkCount; i++) {
+        collectibles[i].value = gameConfig.junkValues[collectibles[i].type];
     }
+    
+    /* Restart the repeating events with the reloaded periods */
+    scheduleRepeatingEvents(game);
+    
+    /* Look around again in case the sight radius changed, or cast the whole sight if the reload turned fog of war on */
+    updateSight(game);
+    
+    /* Pick the kernels again for the reloaded settings */
+    selectKernels(game);
 }
 
-/* Allocate memory for the 2D game world */
+/* Return the arena of a game, NULL if none could be reserved and its memory comes from the heap */
+static Arena* gameArena(Game* game) {
+    return game->arena.base != NULL ? &game->arena : NULL;
+}
+
+/* Reserve the game's arena and allocate the 2D game world and the entity archetypes in it */
 void createWorld(Game* game) {
-    /* Allocate memory for the rows (y-dimension) */
-    game->world = (char**)malloc(game->worldHeight * sizeof(char*));
-    /* Allocate memory for each column (x-dimension) in each row */
+    /* Reserve twice what the world takes at the start, its pages only take memory once they are used */
+    size_t cells = (size_t)game->worldWidth * game->worldHeight;
+    size_t objects = (size_t)gameConfig.asteroidCount + game->impassableCount + game->junkCount + 3;
+    size_t bytes = cells * ARENA_BYTES_PER_CELL + (size_t)game->worldHeight * sizeof(char*) + objects * ARENA_BYTES_PER_OBJECT;
+    if (!initArena(&game->arena, bytes * 2 + ARENA_HEADROOM)) {
+        fprintf(stderr, "Could not reserve %zu bytes for the world, allocating it from the heap\n", bytes * 2 + ARENA_HEADROOM);
+    }
+    Arena* arena = gameArena(game);
+    
+    /* Allocate the row pointers and one block of cells the rows (y-dimension) point into */
+    game->world = (char**)arenaAlloc(arena, game->worldHeight * sizeof(char*));
+    char* rows = (char*)arenaAlloc(arena, cells);
     for (int y = 0; y < game->worldHeight; y++) {
-        game->world[y] = (char*)malloc(game->worldWidth * sizeof(char));
+        game->world[y] = rows + (size_t)y * game->worldWidth;
     }
+    
+    /* Allocate the obstacle lookup map with every cell passable */
+    game->obstacleMap = (unsigned char*)arenaAlloc(arena, cells);
+    
+    /* Allocate the junk lookup map with zeroed handles, which refer to no item */
+    game->junkCells = (EntityHandle*)arenaAlloc(arena, cells * sizeof(EntityHandle));
+    
+    /* Allocate the asteroid field and the entity archetypes sized by the configured counts, which then count what is placed */
+    initAsteroidField(&game->asteroids, arena, gameConfig.asteroidCount, game->worldWidth, game->worldHeight);
+    initArchetype(&game->entities[ENTITY_OBSTACLES], arena, OBSTACLE_COMPONENTS, game->impassableCount + 1);
+    initArchetype(&game->entities[ENTITY_JUNK], arena, JUNK_COMPONENTS, game->junkCount + 1);
+    syncEntityCounts(game);
+    
+    /* Start the timed events at turn 0, handles into a wheel the game had before refer to nothing on this one */
+    initEventWheel(&game->events, arena);
+    memset(&game->shieldExpiry, 0, sizeof(game->shieldExpiry));
+    memset(&game->fuelLeak, 0, sizeof(game->fuelLeak));
+    memset(&game->asteroidSpawn, 0, sizeof(game->asteroidSpawn));
+    
+    /* Start with nothing seen and nothing blocking the view */
+    initFogOfWar(&game->fog, arena, game->worldWidth, game->worldHeight);
+}
+
+/* Make room in the archetypes for at least the given numbers of obstacles and junk items, returns 0 if out of memory */
+int reserveEntities(Game* game, int obstacles, int junk) {
+    int ok = reserveArchetype(&game->entities[ENTITY_OBSTACLES], obstacles);
+    return reserveArchetype(&game->entities[ENTITY_JUNK], junk) && ok;
 }
 
 /* Free all dynamically allocated memory used by the game */
 void cleanupGame(Game* game) {
-    /* Free each row of the world grid */
-    for (int y = 0; y < game->worldHeight; y++) {
-        free(game->world[y]);
+    /* Memory from the heap is freed piece by piece, giving it back to an arena does nothing */
+    Arena* arena = gameArena(game);
+    if (game->world != NULL) {
+        arenaRelease(arena, game->world[0]);
     }
-    /* Free the array of row pointers */
-    free(game->world);
+    arenaRelease(arena, game->world);
+    arenaRelease(arena, game->obstacleMap);
+    arenaRelease(arena, game->junkCells);
+    freeAsteroidField(&game->asteroids);
+    for (int kind = 0; kind < ENTITY_KINDS; kind++) {
+        freeArchetype(&game->entities[kind]);
+    }
+    freeEventWheel(&game->events);
+    freeFogOfWar(&game->fog);
+    closeSectorWorld(game->sectors);
+    game->sectors = NULL;
+    
+    /* Release everything allocated in the arena at once */
+    freeArena(&game->arena);
+    game->world = NULL;
 }
 
 /* Draw the game world and display status information */
 void renderWorld(Game* game) {
-    /* Clear the console screen */
-    system("cls");
+    /* Clear the console screen when playing on the console */
+    if (game->output == NULL) {
+        system("cls");
+    }
     
     /* Initialize all world cells to empty space ('.') */
     for (int y = 0; y < game->worldHeight; y++) {
@@ -294,62 +799,90 @@ void renderWorld(Game* game) {
     /* Place the ship on the world */
     game->world[game->ship.position.y][game->ship.position.x] = 'S';
     
-    /* Place the asteroid on the world */
-    game->world[game->asteroid.position.y][game->asteroid.position.x] = game->asteroid.symbol;
-    
-    /* Place impassable cells (obstacles) on the world */
-    for (int i = 0; i < IMPASSABLE_CELLS; i++) {
-        int x = game->impassableCells[i].position.x;
-        int y = game->impassableCells[i].position.y;
-        game->world[y][x] = game->impassableCells[i].symbol;
+    /* Place the asteroids on the world */
+    for (int i = 0; i < game->asteroids.count; i++) {
+        game->world[game->asteroids.y[i]][game->asteroids.x[i]] = 'A';
     }
     
-    /* Place uncollected junk items on the world */
-    for (int i = 0; i < game->junkCount; i++) {
-        if (!game->junkItems[i].collected) {
-            int x = game->junkItems[i].position.x;
-            int y = game->junkItems[i].position.y;
-            game->world[y][x] = game->junkItems[i].symbol;
+    /* Place the obstacles and the junk items still in the world, each kind from its columns */
+    for (int kind = 0; kind < ENTITY_KINDS; kind++) {
+        const Archetype* archetype = &game->entities[kind];
+        const Position* positions = ARCHETYPE_COLUMN(archetype, COMPONENT_POSITION, Position);
+        const char* symbols = ARCHETYPE_COLUMN(archetype, COMPONENT_SYMBOL, char);
+        for (int i = 0; i < archetype->pool.count; i++) {
+            game->world[positions[i].y][positions[i].x] = symbols[i];
         }
     }
     
     /* Print the x-axis coordinates at the top */
-    printf("\n   ");
+    writeOutput(game->output, "\n   ");
     for (int x = 0; x < game->worldWidth; x++) {
-        printf("%d", x % 10);
+        writeOutputBytes(game->output, &"0123456789"[x % 10], 1);
     }
-    printf("\n");
+    writeOutput(game->output, "\n");
     
-    /* Print the world with y-axis coordinates */
+    /* Print the world with y-axis coordinates, hiding what the ship cannot see in fog of war */
     for (int y = 0; y < game->worldHeight; y++) {
-        printf("%2d ", y % 100);
-        for (int x = 0; x < game->worldWidth; x++) {
-            printf("%c", game->world[y][x]);
+        if (gameConfig.fogOfWar) {
+            maskFogRow(&game->fog, y, game->world[y]);
         }
-        printf("\n");
+        writeOutput(game->output, "%2d ", y % 100);
+        writeOutputBytes(game->output, game->world[y], (size_t)game->worldWidth);
+        writeOutput(game->output, "\n");
     }
     
     /* Display game status information */
-    printf("\nFuel: %d/%d | Health: %d/%d | Score: %d\n", 
+    writeOutput(game->output, "\nFuel: %d/%d | Health: %d/%d | Score: %d%s\n", 
            game->ship.fuel, game->ship.maxFuel, 
            game->ship.health, game->ship.maxHealth, 
-           game->score);
+           game->score, game->shielded ? " | Shield up" : "");
+    
+    /* A streamed world has no edges, so show where the ship is in it */
+    if (game->sectors != NULL) {
+        writeOutput(game->output, "Position: %d,%d\n", game->originX + game->ship.position.x, game->originY + game->ship.position.y);
+    }
            
     /* Display available game controls */
-    printf("\nControls: (W)Up (S)Down (A)Left (D)Right (Q)Quit (I)Inventory (U)Use items\n");
+    writeOutput(game->output, "\nControls: (W)Up (S)Down (A)Left (D)Right (Q)Quit (I)Inventory (U)Use items\n");
 }
 
 /* Process user input and execute corresponding game actions */
 void handleInput(Game* game) {
     /* Variable to store the user's input command */
     char input;
+    /* Item choice for the (U)se command */
+    int choice = 0;
+    /* Time spent waiting for the player is measured apart from the simulation */
+    long long inputStart = STATS_START();
     printf("\nEnter command: ");
     scanf(" %c", &input);
     /* Convert input to uppercase for case-insensitive comparison */
     input = toupper(input);
     
-    /* Execute action based on user's input */
-    switch (input) {
+    if (input == 'U') {
+        /* Display options for using inventory items */
+        printf("Choose item to use:\n");
+        printf("1. Metal (Repair ship)\n");
+        printf("2. Fuel Cell (Refuel ship)\n");
+        printf("3. Cancel\n");
+        
+        /* Get user's item choice */
+        scanf("%d", &choice);
+    }
+    STATS_STOP(STATS_INPUT, inputStart);
+    
+    long long simulateStart = STATS_START();
+    applyCommand(game, input, choice);
+    STATS_STOP(STATS_SIMULATE, simulateStart);
+    
+    /* Add the turn to the flight recorder */
+    recordTurn(game, input, choice);
+}
+
+/* Execute a single player command, option selects the item for the (U)se command */
+void applyCommand(Game* game, char command, int option) {
+    /* Execute action based on the command */
+    switch (toupper(command)) {
         case 'W':
             /* Move ship up */
             moveSpaceship(game, 0, -1);
@@ -371,17 +904,9 @@ void handleInput(Game* game) {
             displayShipStatus(game);
             break;
         case 'U':
-            /* Display options for using inventory items */
-            printf("Choose item to use:\n");
-            printf("1. Metal (Repair ship)\n");
-            printf("2. Fuel Cell (Refuel ship)\n");
-            printf("3. Cancel\n");
-            
-            /* Get user's item choice */
-            int choice;
-            scanf("%d", &choice);
-            if (choice >= 1 && choice <= 2) {
-                useJunk(game, choice);
+            /* Use the chosen inventory item */
+            if (option >= 1 && option <= 2) {
+                useJunk(game, option);
             }
             break;
         case 'Q':
@@ -393,6 +918,8 @@ void handleInput(Game* game) {
 
 /* Move the player's spaceship in the specified direction */
 void moveSpaceship(Game* game, int dx, int dy) {
+    /* Time the whole move, the asteroid and collision phases are timed inside it */
+    long long moveStart = STATS_START();
     /* Calculate new position after movement */
     int newX = game->ship.position.x + dx;
     int newY = game->ship.position.y + dy;
@@ -402,13 +929,9 @@ void moveSpaceship(Game* game, int dx, int dy) {
         /* Flag to determine if movement is allowed */
         int canMove = 1;
         
-        /* Check if new position overlaps with any impassable cell */
-        for (int i = 0; i < IMPASSABLE_CELLS; i++) {
-            if (newX == game->impassableCells[i].position.x && 
-                newY == game->impassableCells[i].position.y) {
-                canMove = 0;
-                break;
-            }
+        /* Check if new position is an impassable cell */
+        if (game->obstacleMap[newY * game->worldWidth + newX]) {
+            canMove = 0;
         }
         
         /* If movement is allowed, update ship position and process turn consequences */
@@ -417,101 +940,324 @@ void moveSpaceship(Game* game, int dx, int dy) {
             game->ship.position.x = newX;
             game->ship.position.y = newY;
             
+            /* The map of a streamed world moves along when the ship nears its edges */
+            if (game->sectors != NULL) {
+                followShip(game);
+            }
+            
+            /* In fog of war only the sight around the old and new cells is cast again */
+            updateSight(game);
+            
             /* Consume fuel based on difficulty level */
-            game->ship.fuel -= FUEL_CONSUMPTION[game->difficulty];
+            game->ship.fuel -= gameConfig.fuelConsumption[game->difficulty];
             
             /* Check if out of fuel - game over condition */
             if (game->ship.fuel <= 0) {
                 game->isGameOver = 1;
                 game->hasWon = 0;
+                STATS_STOP(STATS_MOVE, moveStart);
                 return;
             }
             
-            /* Move asteroid and check for collisions after player's move */
-            moveAsteroid(game);
+            /* Move asteroids and check for collisions after player's move,
+               timed here so the probes stay out of the simulation loops */
+            long long asteroidStart = STATS_START();
+            game->moveAsteroids(game);
+            STATS_STOP(STATS_MOVE_ASTEROID, asteroidStart);
+            STATS_COUNT(STATS_ASTEROID_STEPS, (long long)game->asteroids.count * gameConfig.asteroidSpeeds[game->difficulty]);
             
             /* Check if player collected any junk or reached win condition */
+            long long collisionStart = STATS_START();
             checkCollisions(game);
+            STATS_STOP(STATS_CHECK_COLLISIONS, collisionStart);
+            STATS_COUNT(STATS_COLLISION_CHECKS, game->junkCount);
         }
     }
+    STATS_STOP(STATS_MOVE, moveStart);
 }
 
-/* Move the asteroid based on its current direction and check for collisions */
-void moveAsteroid(Game* game) {
-    /* Asteroid moves faster at higher difficulties */
-    int speed = ASTEROID_SPEEDS[game->difficulty];
+/* Advance an asteroid by one cell, bouncing off the world edges and off blocked cells */
+void stepAsteroid(Asteroid* asteroid, int worldWidth, int worldHeight, const unsigned char* blocked) {
+    /* Calculate new asteroid position */
+    int newX = asteroid->position.x + asteroid->direction.x;
+    int newY = asteroid->position.y + asteroid->direction.y;
     
-    /* Move the asteroid multiple times based on its speed */
-    for (int i = 0; i < speed; i++) {
-        /* Calculate new asteroid position */
-        int newX = game->asteroid.position.x + game->asteroid.direction.x;
-        int newY = game->asteroid.position.y + game->asteroid.direction.y;
+    /* If asteroid hits horizontal world boundary, reverse horizontal direction */
+    if (newX < 0 || newX >= worldWidth) {
+        asteroid->direction.x *= -1;
+        newX = asteroid->position.x + asteroid->direction.x;
+    }
+    
+    /* If asteroid hits vertical world boundary, reverse vertical direction */
+    if (newY < 0 || newY >= worldHeight) {
+        asteroid->direction.y *= -1;
+        newY = asteroid->position.y + asteroid->direction.y;
+    }
+    
+    /* If asteroid would hit an obstacle, reverse its direction */
+    if (blocked[newY * worldWidth + newX]) {
+        asteroid->direction.x *= -1;
+        asteroid->direction.y *= -1;
         
-        /* If asteroid hits horizontal world boundary, reverse horizontal direction */
-        if (newX < 0 || newX >= game->worldWidth) {
-            game->asteroid.direction.x *= -1;
-            newX = game->asteroid.position.x + game->asteroid.direction.x;
+        /* Ensure asteroid is not stationary after collision */
+        if (asteroid->direction.x == 0 && asteroid->direction.y == 0) {
+            asteroid->direction.x = 1;
         }
         
-        /* If asteroid hits vertical world boundary, reverse vertical direction */
-        if (newY < 0 || newY >= game->worldHeight) {
-            game->asteroid.direction.y *= -1;
-            newY = game->asteroid.position.y + game->asteroid.direction.y;
-        }
+        /* Recalculate new position with reversed direction */
+        newX = asteroid->position.x + asteroid->direction.x;
+        newY = asteroid->position.y + asteroid->direction.y;
         
-        /* Check if asteroid would hit an impassable cell */
-        int blocked = 0;
-        for (int j = 0; j < IMPASSABLE_CELLS; j++) {
-            if (newX == game->impassableCells[j].position.x && 
-                newY == game->impassableCells[j].position.y) {
-                blocked = 1;
-                break;
-            }
+        /* Stay in place if the way back leaves the world or is blocked too */
+        if (newX < 0 || newX >= worldWidth || newY < 0 || newY >= worldHeight ||
+            blocked[newY * worldWidth + newX]) {
+            newX = asteroid->position.x;
+            newY = asteroid->position.y;
+        }
+    }
+    
+    /* Update asteroid position */
+    asteroid->position.x = newX;
+    asteroid->position.y = newY;
+}
+
+/* An asteroid reached the ship, which ends the game unless the shield is up */
+static void asteroidHitShip(Game* game) {
+    if (game->shielded) {
+        writeOutput(game->output, "The shield deflected an asteroid!\n");
+    } else {
+        game->isGameOver = 1;
+        game->hasWon = 0;
+    }
+}
+
+/* Move the asteroids one at a time based on their current direction and check for collisions */
+void moveAsteroid(Game* game) {
+    /* Asteroids move faster at higher difficulties */
+    int speed = gameConfig.asteroidSpeeds[game->difficulty];
+    AsteroidField* field = &game->asteroids;
+    /* The field's spare arrays are free between its handoffs, they keep where the asteroids were */
+    int* startX = field->spare[0];
+    int* startY = field->spare[1];
+    /* Flag set if any asteroid reached the ship during the turn */
+    int hit = 0;
+    
+    /* Every asteroid takes a step before any takes the next, bouncing off where the others were before it */
+    for (int i = 0; i < speed; i++) {
+        /* Block the asteroids' cells for the step, asteroids are never on an obstacle so the marks can be cleared after */
+        for (int a = 0; a < field->count; a++) {
+            startX[a] = field->x[a];
+            startY[a] = field->y[a];
+            game->obstacleMap[field->y[a] * game->worldWidth + field->x[a]] = 2;
         }
         
-        /* If asteroid would hit an obstacle, reverse its direction */
-        if (blocked) {
-            game->asteroid.direction.x *= -1;
-            game->asteroid.direction.y *= -1;
-            
-            /* Ensure asteroid is not stationary after collision */
-            if (game->asteroid.direction.x == 0 && game->asteroid.direction.y == 0) {
-                game->asteroid.direction.x = 1;
+        for (int a = 0; a < field->count; a++) {
+            /* An asteroid that hit the ship earlier in the turn stays on it */
+            if (i > 0 && field->x[a] == game->ship.position.x && field->y[a] == game->ship.position.y) {
+                continue;
             }
             
-            /* Recalculate new position with reversed direction */
-            newX = game->asteroid.position.x + game->asteroid.direction.x;
-            newY = game->asteroid.position.y + game->asteroid.direction.y;
+            Asteroid asteroid = {{field->x[a], field->y[a]}, {field->dx[a], field->dy[a]}, 'A'};
+            stepAsteroid(&asteroid, game->worldWidth, game->worldHeight, game->obstacleMap);
+            field->x[a] = asteroid.position.x;
+            field->y[a] = asteroid.position.y;
+            field->dx[a] = asteroid.direction.x;
+            field->dy[a] = asteroid.direction.y;
+            
+            /* Check if asteroid hit the player */
+            if (asteroid.position.x == game->ship.position.x && 
+                asteroid.position.y == game->ship.position.y) {
+                hit = 1;
+            }
         }
         
-        /* Update asteroid position */
-        game->asteroid.position.x = newX;
-        game->asteroid.position.y = newY;
+        for (int a = 0; a < field->count; a++) {
+            game->obstacleMap[startY[a] * game->worldWidth + startX[a]] = 0;
+        }
+    }
+    
+    if (hit) {
+        asteroidHitShip(game);
+    }
+}
+
+/* Step helpers of the kernels must be inlined so the unrolled steps share registers */
+#if defined(__GNUC__)
+#define KERNEL_INLINE static inline __attribute__((always_inline))
+#else
+#define KERNEL_INLINE static inline
+#endif
+
+/* Advance an asteroid that cannot reach a world edge this step, so only obstacles and other asteroids can turn it */
+KERNEL_INLINE void stepInteriorAsteroid(Asteroid* asteroid, int worldWidth, const unsigned char* blocked) {
+    /* Calculate new asteroid position */
+    int newX = asteroid->position.x + asteroid->direction.x;
+    int newY = asteroid->position.y + asteroid->direction.y;
+    
+    /* Same bounce as stepAsteroid, the way back is always inside the world here */
+    if (blocked[newY * worldWidth + newX]) {
+        asteroid->direction.x *= -1;
+        asteroid->direction.y *= -1;
+        if (asteroid->direction.x == 0 && asteroid->direction.y == 0) {
+            asteroid->direction.x = 1;
+        }
+        newX = asteroid->position.x + asteroid->direction.x;
+        newY = asteroid->position.y + asteroid->direction.y;
+        if (blocked[newY * worldWidth + newX]) {
+            newX = asteroid->position.x;
+            newY = asteroid->position.y;
+        }
+    }
+    
+    /* Update asteroid position */
+    asteroid->position.x = newX;
+    asteroid->position.y = newY;
+}
+
+/* Take one step of a turn for every asteroid as moveAsteroid does, returns 1 if one reached the ship */
+KERNEL_INLINE int stepSmallField(Game* game, int firstStep) {
+    AsteroidField* field = &game->asteroids;
+    const int worldWidth = game->worldWidth;
+    const int worldHeight = game->worldHeight;
+    unsigned char* blocked = game->obstacleMap;
+    const Position ship = game->ship.position;
+    int* startX = field->spare[0];
+    int* startY = field->spare[1];
+    int hit = 0;
+    
+    for (int a = 0; a < field->count; a++) {
+        startX[a] = field->x[a];
+        startY[a] = field->y[a];
+        blocked[field->y[a] * worldWidth + field->x[a]] = 2;
+    }
+    
+    for (int a = 0; a < field->count; a++) {
+        /* An asteroid that hit the ship earlier in the turn stays on it, none can have on the first step */
+        if (!firstStep && field->x[a] == ship.x && field->y[a] == ship.y) {
+            continue;
+        }
         
-        /* Check if asteroid hit the player - game over condition */
-        if (game->asteroid.position.x == game->ship.position.x && 
-            game->asteroid.position.y == game->ship.position.y) {
-            game->isGameOver = 1;
-            game->hasWon = 0;
-            break;
+        /* An asteroid at least a cell from every edge cannot reach one in a step */
+        Asteroid asteroid = {{field->x[a], field->y[a]}, {field->dx[a], field->dy[a]}, 'A'};
+        if (asteroid.position.x >= 1 && asteroid.position.x < worldWidth - 1 &&
+            asteroid.position.y >= 1 && asteroid.position.y < worldHeight - 1) {
+            stepInteriorAsteroid(&asteroid, worldWidth, blocked);
+        } else {
+            stepAsteroid(&asteroid, worldWidth, worldHeight, blocked);
         }
+        field->x[a] = asteroid.position.x;
+        field->y[a] = asteroid.position.y;
+        field->dx[a] = asteroid.direction.x;
+        field->dy[a] = asteroid.direction.y;
+        hit |= asteroid.position.x == ship.x && asteroid.position.y == ship.y;
+    }
+    
+    for (int a = 0; a < field->count; a++) {
+        blocked[startY[a] * worldWidth + startX[a]] = 0;
+    }
+    return hit;
+}
+
+/* Repeat a statement once for every step of a turn after the first, unrolling the step loop */
+#define REPEAT_0(statement)
+#define REPEAT_1(statement) statement
+#define REPEAT_2(statement) REPEAT_1(statement) statement
+#define REPEAT_3(statement) REPEAT_2(statement) statement
+
+/*
+ * Define moveAsteroid specialized for one asteroid speed, given with the
+ * number of steps after the first. The steps are unrolled and interior
+ * asteroids skip the edge checks. The field is left unsorted, selectKernels
+ * marks it to be sorted when the vector kernel takes over. Results are the same as
+ * moveAsteroid.
+ */
+#define DEFINE_ASTEROID_KERNEL(SPEED, LATER_STEPS) \
+static void moveAsteroidSpeed##SPEED(Game* game) { \
+    int hit = stepSmallField(game, 1); \
+    REPEAT_##LATER_STEPS(hit |= stepSmallField(game, 0);) \
+    if (hit) { \
+        asteroidHitShip(game); \
+    } \
+}
+
+/* Kernels for the asteroid speeds of the default settings and one above */
+DEFINE_ASTEROID_KERNEL(1, 0)
+DEFINE_ASTEROID_KERNEL(2, 1)
+DEFINE_ASTEROID_KERNEL(3, 2)
+DEFINE_ASTEROID_KERNEL(4, 3)
+
+/* Specialized kernels indexed by asteroid speed */
+static void (*const asteroidKernels[])(Game* game) = {
+    NULL, moveAsteroidSpeed1, moveAsteroidSpeed2, moveAsteroidSpeed3, moveAsteroidSpeed4
+};
+
+/* Move the asteroids with the vector kernel of the asteroid field, same results as moveAsteroid */
+static void moveAsteroidField(Game* game) {
+    int speed = gameConfig.asteroidSpeeds[game->difficulty];
+    if (stepAsteroidField(&game->asteroids, speed, game->ship.position.x, game->ship.position.y)) {
+        asteroidHitShip(game);
+    }
+}
+
+/* Cast the ship's sight from where it is, skipped while fog of war is off as nothing reads it then */
+void updateSight(Game* game) {
+    if (gameConfig.fogOfWar) {
+        updateFogOfWar(&game->fog, game->ship.position.x, game->ship.position.y, gameConfig.sightRadius);
+    }
+}
+
+/* Choose the step kernels for the game's current settings */
+void selectKernels(Game* game) {
+    int speed = gameConfig.asteroidSpeeds[game->difficulty];
+    
+    /* A few asteroids, or a sparse field in a large world, are moved faster one at a time than by the vector kernel */
+    long long cells = (long long)game->worldWidth * game->worldHeight;
+    if (game->asteroids.count >= FIELD_VECTOR_MIN_ASTEROIDS &&
+        (long long)game->asteroids.count * FIELD_VECTOR_MAX_CELLS_PER_ASTEROID >= cells) {
+        /* The one-at-a-time kernels leave the field unsorted, the vector kernel sorts it before its first step */
+        if (game->moveAsteroids != moveAsteroidField) {
+            game->asteroids.unsorted = 1;
+        }
+        game->moveAsteroids = moveAsteroidField;
+    } else if (speed >= 1 && speed < (int)(sizeof(asteroidKernels) / sizeof(asteroidKernels[0]))) {
+        game->moveAsteroids = asteroidKernels[speed];
+    } else {
+        /* Speeds without a kernel of their own use the generic loop */
+        game->moveAsteroids = moveAsteroid;
+    }
+}
+
+/* Collect the collectible entity of a kind at an index */
+static void collectEntity(Game* game, EntityKind kind, int index) {
+    switch (kind) {
+        case ENTITY_JUNK:
+            collectJunk(game, index);
+            break;
+        default:
+            break;
     }
 }
 
 /* Check for item collection and win condition after player moves */
 void checkCollisions(Game* game) {
-    /* Check if player has moved onto any uncollected junk items */
-    for (int i = 0; i < game->junkCount; i++) {
-        if (!game->junkItems[i].collected &&
-            game->ship.position.x == game->junkItems[i].position.x && 
-            game->ship.position.y == game->junkItems[i].position.y) {
-            /* Process junk collection */
-            collectJunk(game, i);
+    /* Check if player has moved onto any collectible entity */
+    for (int kind = 0; kind < ENTITY_KINDS; kind++) {
+        const Archetype* archetype = &game->entities[kind];
+        if (!(archetype->components & COMPONENT_BIT(COMPONENT_COLLECTIBLE))) {
+            continue;
+        }
+        const Position* positions = ARCHETYPE_COLUMN(archetype, COMPONENT_POSITION, Position);
+        for (int i = 0; i < archetype->pool.count; i++) {
+            if (game->ship.position.x == positions[i].x && game->ship.position.y == positions[i].y) {
+                /* Process the collection, the last entity moves into this index so it is checked again */
+                collectEntity(game, (EntityKind)kind, i);
+                i--;
+            }
         }
     }
     
     /* Check if player has reached the winning score */
-    if (game->score >= WIN_SCORES[game->difficulty]) {
+    if (game->score >= gameConfig.winScores[game->difficulty]) {
         game->isGameOver = 1;
         game->hasWon = 1;
     }
@@ -519,40 +1265,61 @@ void checkCollisions(Game* game) {
 
 /* Process the collection of a junk item by the player */
 void collectJunk(Game* game, int index) {
-    /* Mark the junk item as collected so it disappears from the world */
-    game->junkItems[index].collected = 1;
+    /* Time the collection, most of which is usually the wait for Enter */
+    long long collectStart = STATS_START();
+    /* Remove the junk item so it disappears from the world, the last item takes its index */
+    Archetype* archetype = &game->entities[ENTITY_JUNK];
+    Position position = ARCHETYPE_COLUMN(archetype, COMPONENT_POSITION, Position)[index];
+    Collectible junk = ARCHETYPE_COLUMN(archetype, COMPONENT_COLLECTIBLE, Collectible)[index];
+    removeJunk(game, index);
+    
+    /* Keep it collected when the map moves on and its sector is evicted */
+    if (game->sectors != NULL) {
+        clearSectorCell(game->sectors, game->originX + position.x, game->originY + position.y);
+    }
+    
+    /* New junk drifts in somewhere else after a while, streamed worlds bring new junk with new sectors instead */
+    if (gameConfig.junkRespawnTurns > 0 && game->sectors == NULL) {
+        scheduleEvent(&game->events, gameConfig.junkRespawnTurns, EVENT_JUNK_RESPAWN, 0);
+    }
     
     /* Add the junk's value to the player's score */
-    game->score += game->junkItems[index].value;
+    game->score += junk.value;
     
     /* Process specific junk type collection */
-    switch (game->junkItems[index].type) {
+    switch (junk.type) {
         case METAL:
             /* Increment metal count in inventory */
             game->ship.metal++;
-            printf("Collected metal!\n");
+            writeOutput(game->output, "Collected metal!\n");
             break;
         case PLASTIC:
             /* Increment plastic count in inventory */
             game->ship.plastic++;
-            printf("Collected plastic!\n");
+            writeOutput(game->output, "Collected plastic!\n");
             break;
         case ELECTRONICS:
             /* Increment electronics count in inventory */
             game->ship.electronics++;
-            printf("Collected electronics!\n");
+            writeOutput(game->output, "Collected electronics!\n");
+            /* Electronics power the shield, a new one replaces the one already up */
+            if (gameConfig.shieldTurns > 0) {
+                cancelEvent(&game->events, game->shieldExpiry);
+                game->shielded = 1;
+                game->shieldExpiry = scheduleEvent(&game->events, gameConfig.shieldTurns, EVENT_SHIELD_EXPIRES, 0);
+                writeOutput(game->output, "Shield up for %d turns!\n", gameConfig.shieldTurns);
+            }
             break;
         case FUEL_CELL:
             /* Increment fuel cells count in inventory */
             game->ship.fuelCells++;
-            printf("Collected fuel cell!\n");
+            writeOutput(game->output, "Collected fuel cell!\n");
             break;
     }
     
     /* Wait for player to acknowledge collection before continuing */
-    printf("Press Enter to continue...");
-    while (getchar() != '\n');
-    getchar();
+    waitForEnter(game, "Press Enter to continue...");
+    STATS_STOP(STATS_COLLECT, collectStart);
 }
 
 /* Use items from inventory to repair ship or refuel */
@@ -561,62 +1328,58 @@ void useJunk(Game* game, int option) {
         case 1:
             /* Use metal to repair ship */
             if (game->ship.metal > 0) {
-                /* Increase health by 10 points */
-                game->ship.health += 10;
+                /* Increase health by the configured repair amount */
+                game->ship.health += gameConfig.repairAmount;
                 /* Ensure health doesn't exceed maximum */
                 if (game->ship.health > game->ship.maxHealth) {
                     game->ship.health = game->ship.maxHealth;
                 }
                 /* Consume one metal item from inventory */
                 game->ship.metal--;
-                printf("Ship repaired! Health: %d/%d\n", game->ship.health, game->ship.maxHealth);
+                writeOutput(game->output, "Ship repaired! Health: %d/%d\n", game->ship.health, game->ship.maxHealth);
             } else {
-                printf("Not enough metal!\n");
+                writeOutput(game->output, "Not enough metal!\n");
             }
             break;
         case 2:
             /* Use fuel cell to refuel ship */
             if (game->ship.fuelCells > 0) {
-                /* Increase fuel by 50 units */
-                game->ship.fuel += 50;
+                /* Increase fuel by the configured refuel amount */
+                game->ship.fuel += gameConfig.refuelAmount;
                 /* Ensure fuel doesn't exceed maximum */
                 if (game->ship.fuel > game->ship.maxFuel) {
                     game->ship.fuel = game->ship.maxFuel;
                 }
                 /* Consume one fuel cell from inventory */
                 game->ship.fuelCells--;
-                printf("Ship refueled! Fuel: %d/%d\n", game->ship.fuel, game->ship.maxFuel);
+                writeOutput(game->output, "Ship refueled! Fuel: %d/%d\n", game->ship.fuel, game->ship.maxFuel);
             } else {
-                printf("Not enough fuel cells!\n");
+                writeOutput(game->output, "Not enough fuel cells!\n");
             }
             break;
     }
     /* Wait for player to acknowledge before continuing */
-    printf("Press Enter to continue...");
-    while (getchar() != '\n');
-    getchar();
+    waitForEnter(game, "Press Enter to continue...");
 }
 
 /* Display detailed ship status and inventory information */
 void displayShipStatus(Game* game) {
     /* Show ship status (fuel, health, score) */
-    printf("\n=== SHIP STATUS ===\n");
-    printf("Fuel: %d/%d\n", game->ship.fuel, game->ship.maxFuel);
-    printf("Health: %d/%d\n", game->ship.health, game->ship.maxHealth);
-    printf("Score: %d\n", game->score);
+    writeOutput(game->output, "\n=== SHIP STATUS ===\n");
+    writeOutput(game->output, "Fuel: %d/%d\n", game->ship.fuel, game->ship.maxFuel);
+    writeOutput(game->output, "Health: %d/%d\n", game->ship.health, game->ship.maxHealth);
+    writeOutput(game->output, "Score: %d\n", game->score);
     /* Show inventory counts */
-    printf("\n=== INVENTORY ===\n");
-    printf("Metal: %d\n", game->ship.metal);
-    printf("Plastic: %d\n", game->ship.plastic);
-    printf("Electronics: %d\n", game->ship.electronics);
-    printf("Fuel Cells: %d\n", game->ship.fuelCells);
+    writeOutput(game->output, "\n=== INVENTORY ===\n");
+    writeOutput(game->output, "Metal: %d\n", game->ship.metal);
+    writeOutput(game->output, "Plastic: %d\n", game->ship.plastic);
+    writeOutput(game->output, "Electronics: %d\n", game->ship.electronics);
+    writeOutput(game->output, "Fuel Cells: %d\n", game->ship.fuelCells);
     
     /* Show score needed to win based on difficulty level */
-    printf("\nScore needed to win: %d\n", WIN_SCORES[game->difficulty]);
+    writeOutput(game->output, "\nScore needed to win: %d\n", gameConfig.winScores[game->difficulty]);
     /* Wait for player to acknowledge before continuing */
-    printf("\nPress Enter to continue...");
-    while (getchar() != '\n');
-    getchar();
+    waitForEnter(game, "\nPress Enter to continue...");
 }
 
 /* Display the welcome screen and game introduction */
@@ -626,7 +1389,7 @@ void displayWelcomeMessage() {
     printf("        WELCOME TO SPACEXPLORER        \n");
     printf("========================================\n\n");
     
-    /* Try to read introduction text from file */
+    /* Show the intro text from the override file if one exists, or the built-in text */
     FILE* file = fopen(INTRO_FILE, "r");
     if (file != NULL) {
         /* Read and display intro text line by line */
@@ -636,76 +1399,71 @@ void displayWelcomeMessage() {
         }
         fclose(file);
     } else {
-        /* If intro file doesn't exist, use default text and create the file */
-        printf("You are an intrepid space explorer lost in deep space.\n");
-        printf("Your mission is to collect space junk, avoid the dangerous asteroid,\n");
-        printf("and find your way back home.\n\n");
-        printf("Collect enough resources to win, but be careful of your fuel supply!\n");
-
-        file = fopen(INTRO_FILE, "w");
-        if (file != NULL) {
-            /* Save default intro text to file for future use */
-            fprintf(file, "You are an intrepid space explorer lost in deep space.\n");
-            fprintf(file, "Your mission is to collect space junk, avoid the dangerous asteroid,\n");
-            fprintf(file, "and find your way back home.\n\n");
-            fprintf(file, "Collect enough resources to win, but be careful of your fuel supply!\n");
-            fclose(file);
-        }
+        fputs(DEFAULT_INTRO_TEXT, stdout);
     }
     /* Wait for player to start game */
+    long long waitStart = currentTimeNanos();
     printf("\nPress Enter to start your adventure...");
     getchar();
+    promptWaitNanos += currentTimeNanos() - waitStart;
 }
 
 /* Display end game message based on win/loss condition */
 void displayEndGameMessage(Game* game) {
+    /* Show the result, save the score and show the leaderboard */
+    renderEndGameMessage(game);
+    
+    /* Save the last turns so the game can be replayed with spacexplorer_flightlog */
+    saveFlightRecorder(FLIGHT_RECORDER_FILE);
+    
+    /* Wait for player to exit */
+    printf("\nPress Enter to exit...");
+    getchar();
+}
+
+/* Write the end game message, save the score and write the updated leaderboard */
+void renderEndGameMessage(Game* game) {
     /* Show end game banner */
-    printf("\n========================================\n");
+    writeOutput(game->output, "\n========================================\n");
     
     if (game->hasWon) {
         /* Show win message */
-        printf("             YOU WIN!                 \n");
-        printf("========================================\n\n");
-        printf("Congratulations, %s!\n", game->playerName);
-        printf("You have collected enough resources and found your way home!\n");
-        printf("Final Score: %d\n", game->score);
+        writeOutput(game->output, "             YOU WIN!                 \n");
+        writeOutput(game->output, "========================================\n\n");
+        writeOutput(game->output, "Congratulations, %s!\n", game->playerName);
+        writeOutput(game->output, "You have collected enough resources and found your way home!\n");
+        writeOutput(game->output, "Final Score: %d\n", game->score);
     } else {
         /* Show game over message */
-        printf("             GAME OVER                \n");
-        printf("========================================\n\n");
+        writeOutput(game->output, "             GAME OVER                \n");
+        writeOutput(game->output, "========================================\n\n");
         
         /* Show reason for game over (fuel depletion or asteroid collision) */
         if (game->ship.fuel <= 0) {
-            printf("Your spaceship ran out of fuel and is now drifting forever in space.\n");
+            writeOutput(game->output, "Your spaceship ran out of fuel and is now drifting forever in space.\n");
         } else {
-            printf("Your spaceship was hit by the asteroid and was destroyed.\n");
+            writeOutput(game->output, "Your spaceship was hit by the asteroid and was destroyed.\n");
         }
         
-        printf("Final Score: %d\n", game->score);
+        writeOutput(game->output, "Final Score: %d\n", game->score);
     }
     
     /* Save player's score to leaderboard */
-    saveScore(game);
-    
-    /* Display the updated leaderboard */
-    displayLeaderboard();
-    
-    /* Wait for player to exit */
-    printf("\nPress Enter to exit...");
-    getchar();
-}
-
-/* Save player's score to the leaderboard if it qualifies */
-void saveScore(Game* game) {
-    /* Create array to store leaderboard entries */
     LeaderboardEntry leaderboard[MAX_LEADERBOARD_ENTRIES];
     int count = 0;
+    saveScore(game, leaderboard, &count);
     
+    /* Display the updated leaderboard without reading the file again */
+    printLeaderboard(game->output, leaderboard, count);
+}
+
+/* Save player's score to the leaderboard if it qualifies, leaving the updated entries in the array */
+void saveScore(Game* game, LeaderboardEntry leaderboard[], int* count) {
     /* Load existing leaderboard data */
-    loadLeaderboard(leaderboard, &count);
+    loadLeaderboard(leaderboard, count);
     
     /* Check if the player's score qualifies for the leaderboard */
-    if (count < MAX_LEADERBOARD_ENTRIES || game->score > leaderboard[count - 1].score) {
+    if (*count < MAX_LEADERBOARD_ENTRIES || game->score > leaderboard[*count - 1].score) {
         /* Create new entry with player's data */
         LeaderboardEntry newEntry;
         strcpy(newEntry.playerName, game->playerName);
@@ -713,15 +1471,15 @@ void saveScore(Game* game) {
         newEntry.difficulty = game->difficulty;
         
         /* Find insertion position in the sorted leaderboard */
-        int insertIndex = count;
+        int insertIndex = *count;
         
         /* Increment count if leaderboard isn't full */
-        if (count < MAX_LEADERBOARD_ENTRIES) {
-            count++;
+        if (*count < MAX_LEADERBOARD_ENTRIES) {
+            (*count)++;
         }
         
         /* Find the correct position to insert the new score (sorted by score) */
-        for (int i = 0; i < count; i++) {
+        for (int i = 0; i < *count; i++) {
             if (newEntry.score > leaderboard[i].score) {
                 insertIndex = i;
                 break;
@@ -729,7 +1487,7 @@ void saveScore(Game* game) {
         }
         
         /* Shift existing entries down to make room for new entry */
-        for (int i = count - 1; i > insertIndex; i--) {
+        for (int i = *count - 1; i > insertIndex; i--) {
             leaderboard[i] = leaderboard[i - 1];
         }
         
@@ -737,16 +1495,18 @@ void saveScore(Game* game) {
         leaderboard[insertIndex] = newEntry;
         
         /* Ensure leaderboard doesn't exceed maximum size */
-        if (count > MAX_LEADERBOARD_ENTRIES) {
-            count = MAX_LEADERBOARD_ENTRIES;
+        if (*count > MAX_LEADERBOARD_ENTRIES) {
+            *count = MAX_LEADERBOARD_ENTRIES;
         }
         /* Save updated leaderboard to file */
-        saveLeaderboard(leaderboard, count);
+        saveLeaderboard(leaderboard, *count);
     }
 }
 
 /* Load the leaderboard data from file */
 void loadLeaderboard(LeaderboardEntry leaderboard[], int* count) {
+    /* Time the file access, it can stall on a slow disk */
+    long long loadStart = STATS_START();
     /* Try to open leaderboard file */
     FILE* file = fopen(LEADERBOARD_FILE, "r");
     *count = 0;
@@ -763,10 +1523,13 @@ void loadLeaderboard(LeaderboardEntry leaderboard[], int* count) {
         
         fclose(file);
     }
+    STATS_STOP(STATS_LOAD_LEADERBOARD, loadStart);
 }
 
 /* Save the leaderboard data to file */
 void saveLeaderboard(LeaderboardEntry leaderboard[], int count) {
+    /* Time the file access, it can stall on a slow disk */
+    long long saveStart = STATS_START();
     /* Open leaderboard file for writing */
     FILE* file = fopen(LEADERBOARD_FILE, "w");
     
@@ -781,6 +1544,7 @@ void saveLeaderboard(LeaderboardEntry leaderboard[], int count) {
         
         fclose(file);
     }
+    STATS_STOP(STATS_SAVE_LEADERBOARD, saveStart);
 }
 
 /* Display the current leaderboard */
@@ -789,12 +1553,16 @@ void displayLeaderboard() {
     LeaderboardEntry leaderboard[MAX_LEADERBOARD_ENTRIES];
     int count = 0;
     loadLeaderboard(leaderboard, &count);
-    
+    printLeaderboard(NULL, leaderboard, count);
+}
+
+/* Write leaderboard entries that are already loaded to the output, NULL for the console */
+void printLeaderboard(OutputBuffer* output, const LeaderboardEntry leaderboard[], int count) {
     if (count > 0) {
         /* Display leaderboard header */
-        printf("\n============ LEADERBOARD ============\n");
-        printf("Rank | Name          | Score | Difficulty\n");
-        printf("-------------------------------------\n");
+        writeOutput(output, "\n============ LEADERBOARD ============\n");
+        writeOutput(output, "Rank | Name          | Score | Difficulty\n");
+        writeOutput(output, "-------------------------------------\n");
         
         /* Display each leaderboard entry with formatting */
         for (int i = 0; i < count; i++) {
@@ -808,7 +1576,7 @@ void displayLeaderboard() {
             }
             
             /* Print entry with formatting */
-            printf("%-4d | %-14s | %-5d | %c\n", 
+            writeOutput(output, "%-4d | %-14s | %-5d | %c\n", 
                    i + 1, 
                    leaderboard[i].playerName, 
                    leaderboard[i].score,
@@ -816,12 +1584,88 @@ void displayLeaderboard() {
         }
     } else {
         /* Display message if leaderboard is empty */
-        printf("\nNo high scores yet.\n");
+        writeOutput(output, "\nNo high scores yet.\n");
+    }
+}
+
+/* Check that a cell is free for junk to drift into, off obstacles, the ship and other junk */
+static int junkCellFree(Game* game, int x, int y) {
+    if (game->obstacleMap[y * game->worldWidth + x] ||
+        (x == game->ship.position.x && y == game->ship.position.y)) {
+        return 0;
+    }
+    return junkAt(game, x, y) < 0;
+}
+
+/* Spawn a junk item of a random type on a free cell in place of a collected one, or try again later */
+static void respawnJunk(Game* game) {
+    for (int attempt = 0; attempt < TIMED_EVENT_PLACEMENT_ATTEMPTS; attempt++) {
+        int x = rand() % game->worldWidth;
+        int y = rand() % game->worldHeight;
+        if (junkCellFree(game, x, y)) {
+            placeJunk(game, x, y, (JunkType)(rand() % 4));
+            return;
+        }
     }
+    
+    /* The world is crowded, wait for cells to clear */
+    scheduleEvent(&game->events, gameConfig.junkRespawnTurns > 0 ? gameConfig.junkRespawnTurns : 1,
+                  EVENT_JUNK_RESPAWN, 0);
 }
 
-/* Placeholder function for future game update logic */
+/* Send a new asteroid in from an edge, off obstacles and the ship, while the field is below half of the world */
+static void spawnAsteroid(Game* game) {
+    AsteroidField* field = &game->asteroids;
+    if (field->count >= game->worldWidth * game->worldHeight / 2) {
+        return;
+    }
+    for (int attempt = 0; attempt < TIMED_EVENT_PLACEMENT_ATTEMPTS; attempt++) {
+        Asteroid asteroid;
+        placeAtEdge(game, &asteroid);
+        int x = asteroid.position.x;
+        int y = asteroid.position.y;
+        if (!game->obstacleMap[y * game->worldWidth + x] &&
+            (x != game->ship.position.x || y != game->ship.position.y)) {
+            if (addFieldAsteroid(field, x, y, asteroid.direction.x, asteroid.direction.y)) {
+                writeOutput(game->output, "An asteroid entered the sector!\n");
+                /* A bigger field may be moved faster by the other kernel */
+                selectKernels(game);
+            }
+            return;
+        }
+    }
+}
+
+/* Advance the timed events by one turn and handle the ones that are due */
 void updateGame(Game* game) {
-    /* This function is currently empty but could be used
-       for periodic updates like time-based events or animations */
-} 
\ No newline at end of file
+    advanceEventWheel(&game->events);
+    
+    /* Only the events due this turn are looked at, the others wait in the wheel's higher levels */
+    int type;
+    int data;
+    while (!game->isGameOver && nextDueEvent(&game->events, &type, &data)) {
+        switch (type) {
+            case EVENT_JUNK_RESPAWN:
+                respawnJunk(game);
+                break;
+            case EVENT_FUEL_LEAK:
+                /* Lose fuel, which can end the game like running dry from moving */
+                game->ship.fuel -= gameConfig.fuelLeakAmount;
+                writeOutput(game->output, "Fuel leak! Fuel: %d/%d\n", game->ship.fuel, game->ship.maxFuel);
+                if (game->ship.fuel <= 0) {
+                    game->isGameOver = 1;
+                    game->hasWon = 0;
+                }
+                game->fuelLeak = scheduleEvent(&game->events, gameConfig.fuelLeakTurns[game->difficulty], EVENT_FUEL_LEAK, 0);
+                break;
+            case EVENT_SHIELD_EXPIRES:
+                game->shielded = 0;
+                writeOutput(game->output, "Shield down!\n");
+                break;
+            case EVENT_ASTEROID_SPAWN:
+                spawnAsteroid(game);
+                game->asteroidSpawn = scheduleEvent(&game->events, gameConfig.asteroidSpawnTurns[game->difficulty], EVENT_ASTEROID_SPAWN, 0);
+                break;
+        }
+    }
+}
@@ -8,16 +8,29 @@
 #ifndef SPACEXPLORER_GAME_H
 #define SPACEXPLORER_GAME_H
 
+/* Arena all of a game's memory comes from */
+#include "arena.h"
+/* Buffered game output */
+#include "output_buffer.h"
+/* Asteroids stored as arrays for vector stepping */
+#include "asteroid_field.h"
+/* Timed events scheduled by turn */
+#include "event_wheel.h"
+/* Cells the ship can see and has seen */
+#include "fog_of_war.h"
+/* Endless worlds streamed in sectors */
+#include "sector_world.h"
+/* Entities stored by archetype in component columns */
+#include "archetype.h"
+
 /* Minimum world size in both dimensions */
 #define WORLD_MIN_SIZE 18
+/* Maximum world size in both dimensions */
+#define WORLD_MAX_SIZE 16384
 /* Maximum player name length including null terminator */
 #define MAX_NAME_LENGTH 20
-/* Maximum number of collectible junk items in the world */
-#define MAX_JUNK_ITEMS 40
 /* Maximum number of entries in the high score leaderboard */
 #define MAX_LEADERBOARD_ENTRIES 10
-/* Number of impassable obstacle cells in the world */
-#define IMPASSABLE_CELLS 3
 
 /**
  * Game difficulty settings
@@ -31,15 +44,6 @@ typedef enum {
     HARD
 } Difficulty;
 
-/**
- * 2D Position structure for game objects
- * Used to track location of the ship, asteroid, junk, and obstacles
- */
-typedef struct {
-    int x; /* X-coordinate (horizontal position) */
-    int y; /* Y-coordinate (vertical position) */
-} Position;
-
 /**
  * Types of space junk that can be collected
  * Each type has different value and usage
@@ -51,9 +55,21 @@ typedef enum {
     FUEL_CELL     /* Used to refuel ship */
 } JunkType;
 
+/**
+ * Timed events of a game, scheduled on its event wheel
+ * The event data is unused, a junk respawn spawns a new item in place of the one collected
+ */
+typedef enum {
+    EVENT_JUNK_RESPAWN,   /* Collected junk drifts back in somewhere else */
+    EVENT_FUEL_LEAK,      /* The ship loses fuel, repeats every configured number of turns */
+    EVENT_SHIELD_EXPIRES, /* The shield raised by collecting electronics goes down */
+    EVENT_ASTEROID_SPAWN  /* A new asteroid enters from an edge, repeats every configured number of turns */
+} GameEvent;
+
 /**
  * Space junk item structure
- * Represents collectible items that appear in the world
+ * Represents collectible items that appear in a shared world, a game
+ * keeps its junk in the ENTITY_JUNK archetype
  */
 typedef struct {
     Position position;  /* Location in the world */
@@ -81,7 +97,7 @@ typedef struct {
 
 /**
  * Asteroid structure
- * Represents the dangerous moving obstacle
+ * Represents one dangerous moving obstacle, the game keeps its asteroids in an AsteroidField
  */
 typedef struct {
     Position position;   /* Current location in the world */
@@ -90,32 +106,49 @@ typedef struct {
 } Asteroid;
 
 /**
- * Impassable cell structure
- * Represents static obstacles in the world
+ * Kinds of static entities a game stores, each in an archetype
+ * - ENTITY_OBSTACLES: Impassable cells, with a position, a symbol and the blocking tag
+ * - ENTITY_JUNK: Collectible items, with a position, a symbol and a collectible
+ * Kinds are drawn in this order, later ones over earlier ones
  */
-typedef struct {
-    Position position;   /* Location in the world */
-    char symbol;         /* Character displayed on the map */
-} ImpassableCell;
+typedef enum {
+    ENTITY_OBSTACLES,
+    ENTITY_JUNK,
+    ENTITY_KINDS
+} EntityKind;
 
 /**
  * Main game structure
  * Contains all game state information
  */
-typedef struct {
+typedef struct Game {
     int worldWidth;                              /* Width of the game world */
     int worldHeight;                             /* Height of the game world */
     char** world;                                /* 2D array representing the world */
     Spaceship ship;                              /* Player's spaceship */
-    Asteroid asteroid;                           /* Moving asteroid obstacle */
-    SpaceJunk junkItems[MAX_JUNK_ITEMS];         /* Array of collectible items */
-    int junkCount;                               /* Actual number of junk items */
-    ImpassableCell impassableCells[IMPASSABLE_CELLS]; /* Array of impassable obstacles */
+    AsteroidField asteroids;                     /* Moving asteroid obstacles */
+    Archetype entities[ENTITY_KINDS];            /* Obstacles and junk still in the world, one archetype per EntityKind */
+    int junkCount;                               /* Number of junk items, the number to make room for before createWorld */
+    int impassableCount;                         /* Number of impassable obstacles, the number to make room for before createWorld */
+    unsigned char* obstacleMap;                  /* One flag per cell, set where an obstacle is */
+    EntityHandle* junkCells;                     /* Handle of the junk item last placed on each cell, stale once it is removed */
     int score;                                   /* Player's current score */
     int isGameOver;                              /* Flag indicating if game has ended */
     int hasWon;                                  /* Flag indicating if player won */
     Difficulty difficulty;                       /* Current game difficulty */
     char playerName[MAX_NAME_LENGTH];            /* Player's name */
+    OutputBuffer* output;                        /* Where game output is written, NULL for the console */
+    void (*moveAsteroids)(struct Game* game);    /* Asteroid step kernel for the game's settings, set by selectKernels */
+    EventWheel events;                           /* Timed events, advanced one turn by each updateGame */
+    int shielded;                                /* Flag set while asteroids bounce off the ship's shield */
+    EventHandle shieldExpiry;                    /* Event taking the shield down */
+    EventHandle fuelLeak;                        /* Next fuel leak */
+    EventHandle asteroidSpawn;                   /* Next asteroid spawn */
+    FogOfWar fog;                                /* Visibility from the ship, cast only while fog of war is on, a reload turning it on recasts it */
+    SectorWorld* sectors;                        /* Streamed world the map is a window into, NULL for a world of the map's size */
+    int originX;                                 /* Streamed world X-coordinate of the map's left column */
+    int originY;                                 /* Streamed world Y-coordinate of the map's top row */
+    Arena arena;                                 /* Memory of the world, the entities, the fog and the events, reserved by createWorld */
 } Game;
 
 /**
@@ -128,30 +161,63 @@ typedef struct {
     Difficulty difficulty;             /* Difficulty level achieved */
 } LeaderboardEntry;
 
+/* File path for storing player high scores */
+extern const char* LEADERBOARD_FILE;
+/* File path of the level to play, NULL for random worlds */
+extern const char* LEVEL_FILE;
+/* Nanoseconds spent waiting for the player at the welcome and setup prompts */
+extern long long promptWaitNanos;
+
 /* Function to initialize a new game with player name and difficulty settings */
 void initGame(Game* game);
-/* Load world size configuration from file */
-void loadConfig(Game* game);
-/* Save player's score to the leaderboard */
-void saveScore(Game* game);
+/* Set up a new game for the player name and difficulty already stored in the game */
+void setupGame(Game* game);
+/* Load game settings from the configuration file */
+void loadConfig(void);
+/* Re-read the configuration file, returns 1 if new settings were loaded */
+int reloadConfig(void);
+/* Apply reloaded settings to a game that is already running */
+void applyConfig(Game* game);
+/* Save player's score to the leaderboard and return the updated entries */
+void saveScore(Game* game, LeaderboardEntry leaderboard[], int* count);
 /* Load leaderboard data from file */
 void loadLeaderboard(LeaderboardEntry leaderboard[], int* count);
 /* Save leaderboard data to file */
 void saveLeaderboard(LeaderboardEntry leaderboard[], int count);
-/* Allocate memory for the game world */
+/* Reserve the game's arena and allocate the game world and the entity archetypes in it */
 void createWorld(Game* game);
+/* Make room in the archetypes for at least the given numbers of obstacles and junk items, returns 0 if out of memory */
+int reserveEntities(Game* game, int obstacles, int junk);
+/* Schedule the repeating events for the current settings, replacing the ones already pending */
+void scheduleRepeatingEvents(Game* game);
+/* Turn a free cell into an obstacle, returns its index or -1 if out of memory */
+int placeObstacle(Game* game, int x, int y);
+/* Spawn a junk item of a type on a free cell, returns its index or -1 if out of memory */
+int placeJunk(Game* game, int x, int y, JunkType type);
+/* Despawn a junk item, the last one moves into its index */
+void removeJunk(Game* game, int index);
 /* Draw the game world and display status */
 void renderWorld(Game* game);
 /* Process player input commands */
 void handleInput(Game* game);
-/* Update game state (currently unused) */
+/* Execute a single player command, option selects the item for the (U)se command */
+void applyCommand(Game* game, char command, int option);
+/* Advance the timed events by one turn and handle the ones that are due */
 void updateGame(Game* game);
 /* Move player's spaceship */
 void moveSpaceship(Game* game, int dx, int dy);
-/* Move the asteroid obstacle */
+/* Move the asteroid obstacles one at a time, the generic version for any speed the other kernels are checked against */
 void moveAsteroid(Game* game);
+/* Cast the ship's sight from where it is when fog of war is on */
+void updateSight(Game* game);
+/* Choose the step kernels specialized for the game's current settings */
+void selectKernels(Game* game);
+/* Advance an asteroid by one cell, bouncing off the world edges and off blocked cells */
+void stepAsteroid(Asteroid* asteroid, int worldWidth, int worldHeight, const unsigned char* blocked);
 /* Check for collisions with junk items and win condition */
 void checkCollisions(Game* game);
+/* Return the map symbol for a junk type */
+char junkSymbol(JunkType type);
 /* Process collection of a junk item */
 void collectJunk(Game* game, int index);
 /* Use collected items to repair ship or refuel */
@@ -162,9 +228,13 @@ void displayShipStatus(Game* game);
 void displayWelcomeMessage();
 /* Show game over or victory screen */
 void displayEndGameMessage(Game* game);
+/* Write the game over or victory message and save the score */
+void renderEndGameMessage(Game* game);
 /* Display the high score leaderboard */
 void displayLeaderboard();
-/* Free allocated memory when game ends */
+/* Write leaderboard entries that are already loaded, NULL output writes to the console */
+void printLeaderboard(OutputBuffer* output, const LeaderboardEntry leaderboard[], int count);
+/* Free allocated memory when game ends, releasing the arena at once */
 void cleanupGame(Game* game);
 
 #endif /* SPACEXPLORER_GAME_H */
\ No newline at end of file
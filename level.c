@@ -0,0 +1,197 @@
+/* Standard input/output functions (fprintf) */
+#include <stdio.h>
+/* Memory allocation functions (realloc, free, rand) */
+#include <stdlib.h>
+/* String manipulation functions (memchr) */
+#include <string.h>
+/* Level declarations */
+#include "level.h"
+/* Read-only file views */
+#include "mapped_file.h"
+
+/* Find the width of a level's rows and the length of their line ends from the first row */
+static size_t levelRowLength(const MappedFile* file, int* lineEnd) {
+    const char* newline = (const char*)memchr(file->data, '\n', file->length);
+    size_t length = newline != NULL ? (size_t)(newline - file->data) : file->length;
+    *lineEnd = 1;
+    if (length > 0 && file->data[length - 1] == '\r') {
+        length--;
+        *lineEnd = 2;
+    }
+    return length;
+}
+
+/* Read the world size of a level from its first row and its length, returns 0 and reports why if it cannot be played */
+int readLevelSize(const char* path, int* width, int* height) {
+    MappedFile file;
+    if (!mapFile(&file, path) || file.length == 0) {
+        unmapFile(&file);
+        fprintf(stderr, "Level %s: cannot be read\n", path);
+        return 0;
+    }
+
+    /* Rows are all as wide as the first, the last one may have no line end */
+    int lineEnd;
+    size_t rowLength = levelRowLength(&file, &lineEnd);
+    size_t stride = rowLength + lineEnd;
+    size_t rows = (file.length + stride - 1) / stride;
+    unmapFile(&file);
+    /* Worlds of other sizes would be clamped by validateConfig and no longer match the level's rows */
+    if (rowLength < WORLD_MIN_SIZE || rowLength > WORLD_MAX_SIZE || rows < WORLD_MIN_SIZE || rows > WORLD_MAX_SIZE) {
+        fprintf(stderr, "Level %s: is %zux%zu cells, levels must be %d to %d cells wide and high\n",
+                path, rowLength, rows, WORLD_MIN_SIZE, WORLD_MAX_SIZE);
+        return 0;
+    }
+    *width = (int)rowLength;
+    *height = (int)rows;
+    return 1;
+}
+
+/* Make room for one more entry in an array that grows by doubling, returns 0 if out of memory */
+static int reserveEntry(void** array, int* capacity, int count, size_t size) {
+    if (count < *capacity) {
+        return 1;
+    }
+    int grown = *capacity * 2 > count + 1 ? *capacity * 2 : count + 1;
+    void* entries = realloc(*array, (size_t)grown * size);
+    if (entries == NULL) {
+        return 0;
+    }
+    *array = entries;
+    *capacity = grown;
+    return 1;
+}
+
+/* Put the asteroids read from a level into a field sized for them, over the obstacles already placed */
+static int placeLevelAsteroids(Game* game, const Position* asteroids, int count) {
+    AsteroidField* field = &game->asteroids;
+    Arena* arena = field->arena;
+    freeAsteroidField(field);
+    if (!initAsteroidField(field, arena, count, game->worldWidth, game->worldHeight)) {
+        return 0;
+    }
+    const Position* obstacles = ARCHETYPE_COLUMN(&game->entities[ENTITY_OBSTACLES], COMPONENT_POSITION, Position);
+    for (int i = 0; i < game->impassableCount; i++) {
+        markFieldObstacle(field, obstacles[i].x, obstacles[i].y);
+    }
+
+    /* Levels only say where asteroids are, they set off in a random direction */
+    for (int i = 0; i < count; i++) {
+        field->x[i] = asteroids[i].x;
+        field->y[i] = asteroids[i].y;
+        field->dx[i] = (rand() % 3) - 1;
+        field->dy[i] = (rand() % 3) - 1;
+        if (field->dx[i] == 0 && field->dy[i] == 0) {
+            field->dx[i] = 1;
+        }
+        field->id[i] = i;
+    }
+    sortAsteroidField(field);
+    return 1;
+}
+
+/* Place the objects of a level in a created world of its size with no objects, returns 0 and reports why if it cannot */
+int loadLevel(Game* game, const char* path) {
+    MappedFile file;
+    if (!mapFile(&file, path) || file.length == 0) {
+        fprintf(stderr, "Level %s: cannot be read\n", path);
+        unmapFile(&file);
+        return 0;
+    }
+    int lineEnd;
+    if (levelRowLength(&file, &lineEnd) != (size_t)game->worldWidth) {
+        fprintf(stderr, "Level %s: is not %d cells wide\n", path, game->worldWidth);
+        unmapFile(&file);
+        return 0;
+    }
+
+    /* The archetypes start with the room createWorld gave them, the level's asteroids are gathered in one that doubles when full */
+    int asteroidCapacity = 0;
+    Position* asteroids = NULL;
+    int asteroidCount = 0;
+    int shipFound = 0;
+    const char* error = NULL;
+
+    const char* p = file.data;
+    const char* end = file.data + file.length;
+    int y;
+    for (y = 0; y < game->worldHeight; y++) {
+        char* row = game->world[y];
+        int x;
+        for (x = 0; x < game->worldWidth && p < end && *p != '\n' && *p != '\r' && error == NULL; x++) {
+            char symbol = *p++;
+            switch (symbol) {
+                case '#':
+                    if (placeObstacle(game, x, y) < 0) {
+                        error = "out of memory";
+                    }
+                    break;
+                case 'M':
+                case 'P':
+                case 'E':
+                case 'F':
+                    if (placeJunk(game, x, y,
+                                  symbol == 'M' ? METAL : symbol == 'P' ? PLASTIC : symbol == 'E' ? ELECTRONICS : FUEL_CELL) < 0) {
+                        error = "out of memory";
+                    }
+                    break;
+                case 'S':
+                    if (shipFound) {
+                        error = "has a second ship";
+                        break;
+                    }
+                    shipFound = 1;
+                    game->ship.position.x = x;
+                    game->ship.position.y = y;
+                    row[x] = 'S';
+                    break;
+                case 'A':
+                    if (!reserveEntry((void**)&asteroids, &asteroidCapacity, asteroidCount, sizeof(Position))) {
+                        error = "out of memory";
+                        break;
+                    }
+                    asteroids[asteroidCount].x = x;
+                    asteroids[asteroidCount].y = y;
+                    asteroidCount++;
+                    row[x] = 'A';
+                    break;
+                default:
+                    row[x] = '.';
+                    break;
+            }
+        }
+        if (error != NULL) {
+            break;
+        }
+
+        /* The row has to end right after its last cell */
+        if (p < end && *p == '\r') p++;
+        if (x < game->worldWidth || (p < end && *p != '\n')) {
+            error = "is not as wide as the first";
+            break;
+        }
+        if (p < end) p++;
+    }
+    /* Errors found past the last row are about the whole level */
+    int errorRow = error != NULL ? y + 1 : 0;
+    if (error == NULL && p < end) {
+        error = "has more rows than its size";
+    } else if (error == NULL && !shipFound) {
+        error = "has no ship";
+    }
+    unmapFile(&file);
+
+    if (error == NULL && !placeLevelAsteroids(game, asteroids, asteroidCount)) {
+        error = "out of memory";
+    }
+    free(asteroids);
+    if (error != NULL) {
+        if (errorRow > 0) {
+            fprintf(stderr, "Level %s: row %d %s\n", path, errorRow, error);
+        } else {
+            fprintf(stderr, "Level %s: %s\n", path, error);
+        }
+        return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,25 @@
+/**
+ * SpaceXplorer Level Header
+ *
+ * This header defines hand-made or pre-generated worlds read from text
+ * files. A level is drawn with the map symbols, one row of the world per
+ * line: '#' for obstacles, 'M', 'P', 'E' and 'F' for junk, 'S' for the
+ * ship and 'A' for asteroids, with any other character left empty. Every
+ * row is as wide as the first one. The file is mapped into memory and
+ * read once from start to end, each character going straight into the
+ * world rows and the entity arrays, so loading time grows with the size
+ * of the file and nothing else.
+ */
+
+#ifndef SPACEXPLORER_LEVEL_H
+#define SPACEXPLORER_LEVEL_H
+
+/* Game-specific declarations and structures */
+#include "game.h"
+
+/* Read the world size of a level from its first row and its length, returns 0 and reports why if it cannot be played */
+int readLevelSize(const char* path, int* width, int* height);
+/* Place the objects of a level in a created world of its size with no objects, returns 0 and reports why if it cannot */
+int loadLevel(Game* game, const char* path);
+
+#endif /* SPACEXPLORER_LEVEL_H */
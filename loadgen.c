@@ -0,0 +1,308 @@
+/**
+ * SpaceXplorer Load Generator
+ * Opens many concurrent sessions against the game server, plays random
+ * moves and reports the turn latency distribution
+ *
+ * Usage: spacexplorer_loadgen [--port N] [--sessions N] [--turns N] [--difficulty E|M|H]
+ */
+
+/* Standard input/output functions (printf, fprintf, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, qsort, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (strcmp, memcpy, etc.) */
+#include <string.h>
+/* Error numbers (errno, EAGAIN) */
+#include <errno.h>
+/* File descriptor functions (close) */
+#include <unistd.h>
+/* Socket functions (socket, connect, send, recv) */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+/* Event notification (epoll_create1, epoll_wait) */
+#include <sys/epoll.h>
+/* Resource limits (setrlimit) */
+#include <sys/resource.h>
+/* Server protocol constants */
+#include "server.h"
+/* Monotonic clock for latency measurements */
+#include "timing.h"
+
+/* Length of the prompt that ends every frame */
+#define PROMPT_LENGTH ((int)sizeof(SERVER_PROMPT) - 1)
+
+/**
+ * Simulated client
+ * One connection playing one game at a time
+ */
+typedef struct {
+    int fd;                         /* Connected socket, -1 when idle */
+    int connected;                  /* Flag indicating if the connection is established */
+    int playing;                    /* Flag indicating if the first frame was received */
+    long long turnStart;            /* Time the last command was sent, 0 if none in flight */
+    char tail[PROMPT_LENGTH];       /* Last bytes received, used to detect the prompt */
+    int tailLength;                 /* Number of valid bytes in tail */
+} Client;
+
+/* Server port */
+static int port = SERVER_DEFAULT_PORT;
+/* epoll instance used by the event loop */
+static int epollDescriptor = -1;
+/* Turn latencies in nanoseconds */
+static long long* samples = NULL;
+/* Number of recorded turns */
+static int sampleCount = 0;
+/* Number of turns to record */
+static int turnTarget = 100000;
+/* Number of games started */
+static int gamesStarted = 0;
+/* Number of connections that failed */
+static int failures = 0;
+/* Difficulty sent for every new game */
+static char difficulty = 'E';
+
+/* Open a non-blocking connection to the server */
+static void connectClient(Client* client) {
+    memset(client, 0, sizeof(*client));
+    client->fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (client->fd < 0) {
+        failures++;
+        return;
+    }
+
+    int enable = 1;
+    setsockopt(client->fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(client->fd, (struct sockaddr*)&address, sizeof(address)) != 0 && errno != EINPROGRESS) {
+        close(client->fd);
+        client->fd = -1;
+        failures++;
+        return;
+    }
+
+    /* Wait for the connection to complete */
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT;
+    event.data.ptr = client;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, client->fd, &event);
+    gamesStarted++;
+}
+
+/* Close a client connection */
+static void closeClient(Client* client) {
+    if (client->fd >= 0) {
+        epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, client->fd, NULL);
+        close(client->fd);
+        client->fd = -1;
+    }
+}
+
+/* Send a short message, returns 0 on failure */
+static int sendText(Client* client, const char* text) {
+    size_t length = strlen(text);
+    return send(client->fd, text, length, MSG_NOSIGNAL) == (ssize_t)length;
+}
+
+/* Record the latency of the turn in flight */
+static void finishTurn(Client* client) {
+    if (client->turnStart != 0 && sampleCount < turnTarget) {
+        samples[sampleCount++] = currentTimeNanos() - client->turnStart;
+    }
+    client->turnStart = 0;
+}
+
+/* Send a random move and start timing the turn */
+static void sendMove(Client* client) {
+    static const char* moves[] = {"W\n", "A\n", "S\n", "D\n"};
+    client->turnStart = currentTimeNanos();
+    if (!sendText(client, moves[rand() % 4])) {
+        client->turnStart = 0;
+        closeClient(client);
+        failures++;
+    }
+}
+
+/* Append received bytes to the tail and check if it now ends with the prompt */
+static int endsWithPrompt(Client* client, const char* data, ssize_t length) {
+    for (ssize_t i = 0; i < length; i++) {
+        if (client->tailLength == PROMPT_LENGTH) {
+            memmove(client->tail, client->tail + 1, PROMPT_LENGTH - 1);
+            client->tailLength--;
+        }
+        client->tail[client->tailLength++] = data[i];
+    }
+    return client->tailLength == PROMPT_LENGTH && memcmp(client->tail, SERVER_PROMPT, PROMPT_LENGTH) == 0;
+}
+
+/* Handle readable or writable events for a client */
+static void serviceClient(Client* client, unsigned int events) {
+    if (!client->connected && (events & EPOLLOUT)) {
+        /* Connection established, stop waiting for writability and answer the prompts */
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = client;
+        epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, client->fd, &event);
+        client->connected = 1;
+
+        char answers[32];
+        snprintf(answers, sizeof(answers), "loadgen\n%c\n", difficulty);
+        if (!sendText(client, answers)) {
+            closeClient(client);
+            failures++;
+            return;
+        }
+    }
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        char data[8192];
+        int sawPrompt = 0;
+        for (;;) {
+            ssize_t received = recv(client->fd, data, sizeof(data), 0);
+            if (received > 0) {
+                sawPrompt = endsWithPrompt(client, data, received);
+            } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                break;
+            } else if (received < 0 && errno == EINTR) {
+                continue;
+            } else {
+                /* Server closed the connection after the game ended */
+                if (!client->connected) failures++;
+                finishTurn(client);
+                closeClient(client);
+                return;
+            }
+        }
+
+        /* A complete frame arrived, record the turn and play the next one */
+        if (sawPrompt) {
+            client->tailLength = 0;
+            if (client->playing) {
+                finishTurn(client);
+            }
+            client->playing = 1;
+            if (sampleCount < turnTarget) {
+                sendMove(client);
+            }
+        }
+    }
+}
+
+/* Compare two latency samples for sorting */
+static int compareSamples(const void* a, const void* b) {
+    long long left = *(const long long*)a;
+    long long right = *(const long long*)b;
+    return (left > right) - (left < right);
+}
+
+/* Return the latency at the given percentile of the sorted samples */
+static double percentileMicros(double percentile) {
+    int index = (int)(percentile / 100.0 * (sampleCount - 1) + 0.5);
+    return samples[index] / 1000.0;
+}
+
+/**
+ * Load generator entry point
+ * Keeps the requested number of sessions busy until enough turns are recorded
+ */
+int main(int argc, char* argv[]) {
+    int sessionTarget = 1000;
+
+    /* Parse command line options */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            sessionTarget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--turns") == 0 && i + 1 < argc) {
+            turnTarget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) {
+            difficulty = argv[++i][0];
+        } else {
+            fprintf(stderr, "Usage: %s [--port N] [--sessions N] [--turns N] [--difficulty E|M|H]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sessionTarget < 1) sessionTarget = 1;
+    if (turnTarget < 1) turnTarget = 1;
+
+    /* Each session needs a descriptor */
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    samples = (long long*)malloc((size_t)turnTarget * sizeof(long long));
+    Client* clients = (Client*)malloc((size_t)sessionTarget * sizeof(Client));
+    if (samples == NULL || clients == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    for (int i = 0; i < sessionTarget; i++) {
+        connectClient(&clients[i]);
+    }
+
+    long long startTime = currentTimeNanos();
+    struct epoll_event events[256];
+    int idleRounds = 0;
+    while (sampleCount < turnTarget) {
+        int count = epoll_wait(epollDescriptor, events, 256, 1000);
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        /* Give up if the server stops answering */
+        idleRounds = count > 0 ? 0 : idleRounds + 1;
+        if (idleRounds >= 5) {
+            fprintf(stderr, "Server stopped responding\n");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            serviceClient((Client*)events[i].data.ptr, events[i].events);
+        }
+
+        /* Replace finished games with new ones to keep the concurrency level */
+        for (int i = 0; i < sessionTarget && sampleCount < turnTarget; i++) {
+            if (clients[i].fd < 0 && failures < sessionTarget) {
+                connectClient(&clients[i]);
+            }
+        }
+        if (failures >= sessionTarget) {
+            fprintf(stderr, "Too many connection failures, is the server running on port %d?\n", port);
+            break;
+        }
+    }
+    double seconds = (currentTimeNanos() - startTime) / 1e9;
+
+    for (int i = 0; i < sessionTarget; i++) {
+        closeClient(&clients[i]);
+    }
+
+    if (sampleCount == 0) {
+        fprintf(stderr, "No turns completed\n");
+        return 1;
+    }
+
+    /* Report the latency distribution */
+    qsort(samples, (size_t)sampleCount, sizeof(long long), compareSamples);
+    printf("sessions: %d concurrent, %d games started, %d failures\n", sessionTarget, gamesStarted, failures);
+    printf("turns:    %d in %.2f s (%.0f turns/s)\n", sampleCount, seconds, sampleCount / seconds);
+    printf("latency:  p50 %.1f us, p99 %.1f us, max %.1f us\n",
+           percentileMicros(50), percentileMicros(99), samples[sampleCount - 1] / 1000.0);
+
+    free(samples);
+    free(clients);
+    close(epollDescriptor);
+    return 0;
+}
@@ -9,42 +9,179 @@
 #include <stdlib.h>
 /* String manipulation functions (strcpy, strcmp, etc.) */
 #include <string.h>
+/* Character handling functions (toupper) */
+#include <ctype.h>
 /* Time functions for random number generator seeding */
 #include <time.h>
 /* Game-specific declarations and structures */
 #include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Monotonic clock for the startup profile */
+#include "timing.h"
+/* Per-phase timing statistics */
+#include "stats.h"
+/* Timeline trace of the timed phases */
+#include "trace.h"
+#ifdef SPACEXPLORER_SERVER
+/* Multi-session game server */
+#include "server.h"
+#endif
 
 /**
  * Main program entry point
  * Initializes the game, runs the main game loop, and displays end game message
+ *
+ * Options:
+ *   --startup-profile   Report the time from program start to the first frame, not counting the prompts
+ *   --stats [file]      Report per-phase timing percentiles at exit, optionally saving the histograms
+ *   --trace file        Save every timed phase as a span in Chrome trace-event format at exit
+ *   --level file        Play the world drawn in a level file instead of a random one
+ *   --server [port]     Host games for TCP clients instead of playing on the console
+ *   --shared [E|M|H]    With --server, put all players in one shared world
+ *   --tick-ms N         With --shared, milliseconds between world ticks
+ *   --spectate-port [N] With --shared, stream the world to spectators on this port
  */
-int main() {
+int main(int argc, char* argv[]) {
+    /* Record program start for the startup profile */
+    long long startTime = currentTimeNanos();
+    int startupProfile = 0;
+    /* Statistics reporting, with an optional file for the histograms */
+    int stats = 0;
+    const char* statsFile = NULL;
+    /* File for the timeline trace, NULL when not tracing */
+    const char* traceFile = NULL;
+#ifdef SPACEXPLORER_SERVER
+    /* Server mode settings */
+    int server = 0;
+    ServerOptions serverOptions = {SERVER_DEFAULT_PORT, 0, MEDIUM, SERVER_DEFAULT_TICK_MS, 0};
+#endif
+    
+    /* Parse command line options */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--startup-profile") == 0) {
+            startupProfile = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            /* Time every phase of the game loop, optionally saving the histograms */
+            stats = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                statsFile = argv[++i];
+            }
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            /* Record every timed phase for a timeline viewer */
+            traceFile = argv[++i];
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            /* Play a hand-made or pre-generated world, its size replaces the configured one */
+            LEVEL_FILE = argv[++i];
+#ifdef SPACEXPLORER_SERVER
+        } else if (strcmp(argv[i], "--server") == 0) {
+            /* Serve games over TCP, optionally on the given port */
+            server = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                serverOptions.port = atoi(argv[++i]);
+            }
+        } else if (strcmp(argv[i], "--shared") == 0) {
+            /* Put all server players in one world, optionally with the given difficulty */
+            serverOptions.shared = 1;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                char choice = (char)toupper((unsigned char)argv[++i][0]);
+                serverOptions.difficulty = choice == 'E' ? EASY : choice == 'H' ? HARD : MEDIUM;
+            }
+        } else if (strcmp(argv[i], "--tick-ms") == 0 && i + 1 < argc) {
+            serverOptions.tickMillis = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectate-port") == 0) {
+            /* Accept spectators, optionally on the given port */
+            serverOptions.spectatorPort = SERVER_DEFAULT_SPECTATOR_PORT;
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                serverOptions.spectatorPort = atoi(argv[++i]);
+            }
+#endif
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--startup-profile] [--stats [file]] [--trace file] [--level file] [--server [port] [--shared [E|M|H]] [--tick-ms N] [--spectate-port [N]]]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+#ifdef SPACEXPLORER_SERVER
+    /* Host games for network clients instead of playing on the console */
+    if (server) {
+        srand((unsigned int)time(NULL));
+        return runServer(&serverOptions);
+    }
+#endif
+    
     /* Seed random number generator with current time for varied gameplay */
     srand((unsigned int)time(NULL));
     
     /* Display welcome screen and introduction */
     displayWelcomeMessage();
+    long long welcomeTime = currentTimeNanos();
+    long long welcomeWait = promptWaitNanos;
     
     /* Create and initialize game state with player input */
     Game game;
     initGame(&game);
+    long long setupTime = currentTimeNanos();
+    long long setupWait = promptWaitNanos - welcomeWait;
+    /* Start timing once the player is in the game, setup is covered by the startup profile */
+    if (stats) {
+        enableStats(STATS_HISTOGRAMS);
+    }
+    if (traceFile != NULL && startTrace()) {
+        enableStats(STATS_TRACE);
+    }
     
     /* Main game loop - continues until game over condition is reached */
     while (!game.isGameOver) {
+        /* Time the whole turn for the statistics */
+        long long turnStart = STATS_START();
+        /* Everything a turn needs was allocated when the game was set up */
+        ALLOC_CHECK_BEGIN();
+        
         /* Render the current game state to the screen */
+        long long renderStart = STATS_START();
         renderWorld(&game);
-        /* Process player input for the current turn */
+        STATS_STOP(STATS_RENDER, renderStart);
+        
+        /* Report startup phases once the first frame is on screen, without the time the player took at the prompts */
+        if (startupProfile) {
+            long long frameTime = currentTimeNanos();
+            fprintf(stderr, "Startup profile: welcome %.3f ms, setup %.3f ms, first frame %.3f ms, total %.3f ms\n",
+                    (welcomeTime - startTime - welcomeWait) / 1e6, (setupTime - welcomeTime - setupWait) / 1e6,
+                    (frameTime - setupTime) / 1e6, (frameTime - startTime - promptWaitNanos) / 1e6);
+            fprintf(stderr, "(%.3f ms waiting for player input left out)\n", promptWaitNanos / 1e6);
+            startupProfile = 0;
+        }
+
+        /* Process player input for the current turn, timed as input and simulate inside */
         handleInput(&game);
-        /* Update game state (placeholder for future features) */
+        
+        /* Advance the event wheel one turn and handle the events that fell due */
+        long long updateStart = STATS_START();
         updateGame(&game);
+        ALLOC_CHECK_END("Turn");
+        /* Pick up balance changes saved to the config file since the last turn */
+        if (pollConfigWatch() && reloadConfig()) {
+            applyConfig(&game);
+        }
+        STATS_STOP(STATS_UPDATE, updateStart);
+        STATS_STOP(STATS_TURN, turnStart);
     }
     
-    /* Clean up memory - commented out because it's not being used in this version
-       but would be necessary if dynamic memory allocation was used */
-    // cleanupGame(&game);
-    
     /* Display game over or victory screen and save score */
     displayEndGameMessage(&game);
     
+    /* Release the game's arena and anything else it holds */
+    cleanupGame(&game);
+    
+    /* Report where the time of each turn went */
+    if (stats) {
+        reportStats(statsFile);
+    }
+    if (traceFile != NULL) {
+        writeTrace(traceFile);
+    }
+    
     return 0;
 } 
\ No newline at end of file
@@ -0,0 +1,97 @@
+/* Standard input/output functions (fopen, fread, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, etc.) */
+#include <stdlib.h>
+/* Mapped file declarations */
+#include "mapped_file.h"
+
+#ifndef _WIN32
+/* File descriptor functions (open, close, fstat) */
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+/* Memory mapping functions (mmap, munmap) */
+#include <sys/mman.h>
+#endif
+
+/* Open a file and expose its whole contents as one read-only buffer */
+int mapFile(MappedFile* file, const char* path) {
+    file->data = NULL;
+    file->length = 0;
+    file->isMapped = 0;
+
+#ifndef _WIN32
+    /* Try to open the file for reading */
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+
+    /* Query the file size so the whole file can be mapped at once */
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return 0;
+    }
+
+    /* Empty files cannot be mapped, but are still valid input */
+    if (info.st_size == 0) {
+        close(fd);
+        return 1;
+    }
+
+    /* Map the file read-only, the descriptor is not needed afterwards */
+    void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return 0;
+    }
+
+    file->data = (const char*)data;
+    file->length = (size_t)info.st_size;
+    file->isMapped = 1;
+    return 1;
+#else
+    /* Without mmap, read the whole file into one heap buffer instead */
+    FILE* handle = fopen(path, "rb");
+    if (handle == NULL) {
+        return 0;
+    }
+
+    /* Determine the file size */
+    fseek(handle, 0, SEEK_END);
+    long size = ftell(handle);
+    fseek(handle, 0, SEEK_SET);
+    if (size <= 0) {
+        fclose(handle);
+        return size == 0;
+    }
+
+    /* Read the contents in one call */
+    char* data = (char*)malloc((size_t)size);
+    if (data == NULL) {
+        fclose(handle);
+        return 0;
+    }
+    file->length = fread(data, 1, (size_t)size, handle);
+    file->data = data;
+    fclose(handle);
+    return 1;
+#endif
+}
+
+/* Release the memory backing a mapped file */
+void unmapFile(MappedFile* file) {
+    if (file->data != NULL) {
+#ifndef _WIN32
+        if (file->isMapped) {
+            munmap((void*)file->data, file->length);
+        }
+#else
+        free((void*)file->data);
+#endif
+    }
+    file->data = NULL;
+    file->length = 0;
+    file->isMapped = 0;
+}
@@ -0,0 +1,29 @@
+/**
+ * SpaceXplorer Mapped File Header
+ *
+ * This header defines a small read-only file view used by the
+ * parsers, so whole files can be scanned in place in a single pass.
+ */
+
+#ifndef SPACEXPLORER_MAPPED_FILE_H
+#define SPACEXPLORER_MAPPED_FILE_H
+
+/* Size types (size_t) */
+#include <stddef.h>
+
+/**
+ * Read-only view of a whole file
+ * Backed by mmap where available, or by a heap copy otherwise
+ */
+typedef struct {
+    const char* data;   /* First byte of the file contents */
+    size_t length;      /* Number of bytes in the file */
+    int isMapped;       /* Flag indicating if data is a memory mapping */
+} MappedFile;
+
+/* Open a file and map its contents, returns 1 on success and 0 on failure */
+int mapFile(MappedFile* file, const char* path);
+/* Release a view created by mapFile */
+void unmapFile(MappedFile* file);
+
+#endif /* SPACEXPLORER_MAPPED_FILE_H */
@@ -0,0 +1,159 @@
+/* Memory allocation functions (malloc, calloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Obstacle sets declarations */
+#include "obstacle_sets.h"
+
+/* Cells around a cell, clockwise from the one above, side neighbours at even positions */
+static const int RING[8][2] = {
+    {0, -1}, {1, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}
+};
+
+/* Hash table slot a cell's probe starts from */
+static unsigned int cellSlot(const ObstacleSets* sets, long long cell) {
+    return (unsigned int)(((unsigned long long)cell * 0x9E3779B97F4A7C15ull) >> 32) & sets->slotMask;
+}
+
+/* Allocate sets for up to capacity obstacles in a world, returns 0 if out of memory */
+int initObstacleSets(ObstacleSets* sets, int width, int height, int capacity) {
+    memset(sets, 0, sizeof(*sets));
+    sets->width = width;
+    sets->height = height;
+    sets->capacity = capacity;
+
+    /* The table is kept at most half full so probes stay short */
+    unsigned int slots = 16;
+    while (slots < 2u * (unsigned int)capacity) {
+        slots *= 2;
+    }
+    sets->slotMask = slots - 1;
+
+    /* The world edge is one more set after the obstacles */
+    sets->parent = (int*)malloc(((size_t)capacity + 1) * sizeof(int));
+    sets->rank = (unsigned char*)calloc((size_t)capacity + 1, 1);
+    sets->cells = (long long*)malloc(((size_t)capacity + 1) * sizeof(long long));
+    sets->slots = (int*)malloc((size_t)slots * sizeof(int));
+    if (sets->parent == NULL || sets->rank == NULL || sets->cells == NULL || sets->slots == NULL) {
+        freeObstacleSets(sets);
+        return 0;
+    }
+    memset(sets->slots, -1, (size_t)slots * sizeof(int));
+    sets->parent[capacity] = capacity;
+    return 1;
+}
+
+/* Free the arrays of obstacle sets */
+void freeObstacleSets(ObstacleSets* sets) {
+    free(sets->parent);
+    free(sets->rank);
+    free(sets->cells);
+    free(sets->slots);
+    memset(sets, 0, sizeof(*sets));
+}
+
+/* Return the number of the obstacle on a cell, -1 if the cell is free */
+static int findObstacle(const ObstacleSets* sets, long long cell) {
+    for (unsigned int slot = cellSlot(sets, cell); sets->slots[slot] >= 0; slot = (slot + 1) & sets->slotMask) {
+        if (sets->cells[sets->slots[slot]] == cell) {
+            return sets->slots[slot];
+        }
+    }
+    return -1;
+}
+
+/* Return the root of an obstacle's set, halving the path to it on the way */
+static int findRoot(ObstacleSets* sets, int obstacle) {
+    while (sets->parent[obstacle] != obstacle) {
+        sets->parent[obstacle] = sets->parent[sets->parent[obstacle]];
+        obstacle = sets->parent[obstacle];
+    }
+    return obstacle;
+}
+
+/* Join the sets of two obstacles, hanging the shallower tree under the deeper one */
+static void joinSets(ObstacleSets* sets, int a, int b) {
+    a = findRoot(sets, a);
+    b = findRoot(sets, b);
+    if (a == b) {
+        return;
+    }
+    if (sets->rank[a] < sets->rank[b]) {
+        sets->parent[a] = b;
+    } else {
+        sets->parent[b] = a;
+        if (sets->rank[a] == sets->rank[b]) {
+            sets->rank[a]++;
+        }
+    }
+}
+
+/* Return the set root of a cell around a given one, the world edge for cells outside, -1 for a free cell */
+static int ringRoot(ObstacleSets* sets, int x, int y, int position) {
+    int nx = x + RING[position][0];
+    int ny = y + RING[position][1];
+    if (nx < 0 || nx >= sets->width || ny < 0 || ny >= sets->height) {
+        return findRoot(sets, sets->capacity);
+    }
+    int obstacle = findObstacle(sets, (long long)ny * sets->width + nx);
+    return obstacle >= 0 ? findRoot(sets, obstacle) : -1;
+}
+
+/* Return 1 if the free cells stay connected with an obstacle on the given free cell */
+int obstacleKeepsConnected(ObstacleSets* sets, int x, int y) {
+    int roots[8];
+    for (int position = 0; position < 8; position++) {
+        roots[position] = ringRoot(sets, x, y, position);
+    }
+
+    /*
+     * The free side neighbours fall into runs joined through free corners.
+     * Each run ends at a gap of obstacles going round to the next run, and
+     * two gaps in the same set would close a ring cutting the runs apart.
+     */
+    int gaps[4];
+    int gapCount = 0;
+    for (int side = 0; side < 8; side += 2) {
+        int corner = side + 1;
+        int nextSide = (side + 2) % 8;
+        if (roots[side] >= 0 || (roots[corner] < 0 && roots[nextSide] < 0)) {
+            continue;
+        }
+        /* The gap's obstacles touch each other, so its first one stands for all of them */
+        gaps[gapCount++] = roots[corner] >= 0 ? roots[corner] : roots[nextSide];
+    }
+    for (int i = 0; i < gapCount; i++) {
+        for (int j = i + 1; j < gapCount; j++) {
+            if (gaps[i] == gaps[j]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/* Add an obstacle on a free cell, returns 0 if the sets are full */
+int addObstacleToSets(ObstacleSets* sets, int x, int y) {
+    if (sets->count >= sets->capacity) {
+        return 0;
+    }
+    int obstacle = sets->count++;
+    long long cell = (long long)y * sets->width + x;
+    sets->parent[obstacle] = obstacle;
+    sets->rank[obstacle] = 0;
+    sets->cells[obstacle] = cell;
+    unsigned int slot = cellSlot(sets, cell);
+    while (sets->slots[slot] >= 0) {
+        slot = (slot + 1) & sets->slotMask;
+    }
+    sets->slots[slot] = obstacle;
+
+    /* Obstacles touching by a side or a corner, and the world edge, are in one set */
+    for (int position = 0; position < 8; position++) {
+        int root = ringRoot(sets, x, y, position);
+        if (root >= 0) {
+            joinSets(sets, obstacle, root);
+        }
+    }
+    return 1;
+}
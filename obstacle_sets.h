@@ -0,0 +1,45 @@
+/**
+ * SpaceXplorer Obstacle Sets Header
+ *
+ * This header defines a union-find over the obstacles of a world, used
+ * to keep its free cells connected while obstacles are placed. Free cells
+ * that touch by a side are connected exactly when no ring of obstacles
+ * touching by a side or a corner, or a chain of them from world edge to
+ * world edge, runs between them. An obstacle therefore cuts the free cells
+ * apart only when it joins two separate runs of obstacles around it that
+ * already belong to the same set, with the world edge as one more set.
+ * The check looks at the eight cells around the new obstacle and finds
+ * their sets, so its cost does not depend on the size of the world.
+ * Obstacles are looked up by cell in a hash table, so the memory used
+ * grows with the number of obstacles and not with the size of the world.
+ */
+
+#ifndef SPACEXPLORER_OBSTACLE_SETS_H
+#define SPACEXPLORER_OBSTACLE_SETS_H
+
+/**
+ * Obstacle sets
+ * Obstacle i is in the set of its root, the world edge is number capacity
+ */
+typedef struct {
+    int width;                  /* Width of the world */
+    int height;                 /* Height of the world */
+    int count;                  /* Number of obstacles added */
+    int capacity;               /* Number of obstacles there is room for */
+    int* parent;                /* Parent of each obstacle in its set, a root is its own parent */
+    unsigned char* rank;        /* Upper bound of the height of each root's tree */
+    long long* cells;           /* Cell index y * width + x of each obstacle */
+    int* slots;                 /* Hash table of obstacle numbers by cell, -1 for an empty slot */
+    unsigned int slotMask;      /* Number of hash table slots minus one */
+} ObstacleSets;
+
+/* Allocate sets for up to capacity obstacles in a world, returns 0 if out of memory */
+int initObstacleSets(ObstacleSets* sets, int width, int height, int capacity);
+/* Free the arrays of obstacle sets */
+void freeObstacleSets(ObstacleSets* sets);
+/* Return 1 if the free cells stay connected with an obstacle on the given free cell */
+int obstacleKeepsConnected(ObstacleSets* sets, int x, int y);
+/* Add an obstacle on a free cell, returns 0 if the sets are full */
+int addObstacleToSets(ObstacleSets* sets, int x, int y);
+
+#endif /* SPACEXPLORER_OBSTACLE_SETS_H */
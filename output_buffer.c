@@ -0,0 +1,135 @@
+/* Standard input/output functions (vsnprintf) */
+#include <stdio.h>
+/* Memory allocation functions (realloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memcpy, memmove) */
+#include <string.h>
+/* Output buffer declarations */
+#include "output_buffer.h"
+
+/* Prepare an empty buffer */
+void initOutputBuffer(OutputBuffer* buffer) {
+    buffer->data = NULL;
+    buffer->length = 0;
+    buffer->offset = 0;
+    buffer->capacity = 0;
+}
+
+/* Ensure there is room for the given number of additional bytes */
+static void reserveOutput(OutputBuffer* buffer, size_t extra) {
+    if (buffer->length + extra <= buffer->capacity) {
+        return;
+    }
+
+    /* Reuse the consumed space at the start before growing */
+    if (buffer->offset > 0) {
+        memmove(buffer->data, buffer->data + buffer->offset, buffer->length - buffer->offset);
+        buffer->length -= buffer->offset;
+        buffer->offset = 0;
+        if (buffer->length + extra <= buffer->capacity) {
+            return;
+        }
+    }
+
+    /* Grow geometrically so appends stay cheap */
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 256;
+    while (capacity < buffer->length + extra) {
+        capacity *= 2;
+    }
+    char* data = (char*)realloc(buffer->data, capacity);
+    if (data == NULL) {
+        return;
+    }
+    buffer->data = data;
+    buffer->capacity = capacity;
+}
+
+/* Make room for at least the given number of bytes after the ones buffered */
+void reserveOutputBuffer(OutputBuffer* buffer, size_t length) {
+    reserveOutput(buffer, length);
+}
+
+/* Append raw bytes */
+void appendOutput(OutputBuffer* buffer, const char* text, size_t length) {
+    reserveOutput(buffer, length);
+    if (buffer->length + length > buffer->capacity) {
+        return;
+    }
+    memcpy(buffer->data + buffer->length, text, length);
+    buffer->length += length;
+}
+
+/* Append formatted text from an argument list */
+void appendOutputv(OutputBuffer* buffer, const char* format, va_list args) {
+    /* Try to format directly into the free space first */
+    va_list retry;
+    va_copy(retry, args);
+    size_t space = buffer->capacity - buffer->length;
+    int needed = vsnprintf(buffer->data != NULL ? buffer->data + buffer->length : NULL, space, format, args);
+
+    /* Grow and format again if the text did not fit */
+    if (needed >= 0 && (size_t)needed >= space) {
+        reserveOutput(buffer, (size_t)needed + 1);
+        space = buffer->capacity - buffer->length;
+        if ((size_t)needed < space) {
+            vsnprintf(buffer->data + buffer->length, space, format, retry);
+        } else {
+            needed = -1;
+        }
+    }
+    va_end(retry);
+
+    if (needed > 0) {
+        buffer->length += (size_t)needed;
+    }
+}
+
+/* Append formatted text */
+void appendOutputf(OutputBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    appendOutputv(buffer, format, args);
+    va_end(args);
+}
+
+/* Write formatted text to the buffer, or to the console when the buffer is NULL */
+void writeOutput(OutputBuffer* buffer, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (buffer != NULL) {
+        appendOutputv(buffer, format, args);
+    } else {
+        vprintf(format, args);
+    }
+    va_end(args);
+}
+
+/* Write raw bytes to the buffer, or to the console when the buffer is NULL */
+void writeOutputBytes(OutputBuffer* buffer, const char* text, size_t length) {
+    if (buffer != NULL) {
+        appendOutput(buffer, text, length);
+    } else {
+        fwrite(text, 1, length, stdout);
+    }
+}
+
+/* Mark bytes at the start as consumed */
+void consumeOutput(OutputBuffer* buffer, size_t length) {
+    buffer->offset += length;
+    if (buffer->offset >= buffer->length) {
+        buffer->offset = 0;
+        buffer->length = 0;
+    }
+}
+
+/* Discard all buffered bytes but keep the memory */
+void clearOutputBuffer(OutputBuffer* buffer) {
+    buffer->length = 0;
+    buffer->offset = 0;
+}
+
+/* Release the memory used by a buffer */
+void freeOutputBuffer(OutputBuffer* buffer) {
+    free(buffer->data);
+    initOutputBuffer(buffer);
+}
@@ -0,0 +1,49 @@
+/**
+ * SpaceXplorer Output Buffer Header
+ *
+ * This header defines a growable byte buffer that game output can be
+ * written to instead of the console, for example to send it over a
+ * network connection.
+ */
+
+#ifndef SPACEXPLORER_OUTPUT_BUFFER_H
+#define SPACEXPLORER_OUTPUT_BUFFER_H
+
+/* Size types (size_t) */
+#include <stddef.h>
+/* Variable argument lists (va_list) */
+#include <stdarg.h>
+
+/**
+ * Growable output buffer
+ * Bytes are appended at the end and consumed from the start
+ */
+typedef struct {
+    char* data;         /* Buffered bytes */
+    size_t length;      /* Number of bytes written */
+    size_t offset;      /* Number of bytes already consumed from the start */
+    size_t capacity;    /* Allocated size of data */
+} OutputBuffer;
+
+/* Prepare an empty buffer */
+void initOutputBuffer(OutputBuffer* buffer);
+/* Make room for at least the given number of bytes after the ones buffered */
+void reserveOutputBuffer(OutputBuffer* buffer, size_t length);
+/* Append raw bytes */
+void appendOutput(OutputBuffer* buffer, const char* text, size_t length);
+/* Append formatted text */
+void appendOutputf(OutputBuffer* buffer, const char* format, ...);
+/* Append formatted text from an argument list */
+void appendOutputv(OutputBuffer* buffer, const char* format, va_list args);
+/* Write formatted text to the buffer, or to the console when the buffer is NULL */
+void writeOutput(OutputBuffer* buffer, const char* format, ...);
+/* Write raw bytes to the buffer, or to the console when the buffer is NULL */
+void writeOutputBytes(OutputBuffer* buffer, const char* text, size_t length);
+/* Mark bytes at the start as consumed, resetting the buffer once all are consumed */
+void consumeOutput(OutputBuffer* buffer, size_t length);
+/* Discard all buffered bytes but keep the memory */
+void clearOutputBuffer(OutputBuffer* buffer);
+/* Release the memory used by a buffer */
+void freeOutputBuffer(OutputBuffer* buffer);
+
+#endif /* SPACEXPLORER_OUTPUT_BUFFER_H */
@@ -0,0 +1,212 @@
+/* Memory allocation functions (calloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memset) */
+#include <string.h>
+/* Reachability declarations */
+#include "reachability.h"
+
+/* Cells packed into one word of a bitset */
+#define REACH_CELLS_PER_WORD 64
+
+/* Allocate the bitsets of a world with nothing reached, returns 0 if out of memory */
+int initReachMap(ReachMap* map, int width, int height) {
+    memset(map, 0, sizeof(*map));
+    map->width = width;
+    map->height = height;
+    map->rowWords = (width + REACH_CELLS_PER_WORD - 1) / REACH_CELLS_PER_WORD;
+    map->top = -1;
+    size_t words = (size_t)map->rowWords * height;
+    map->passable = (unsigned long long*)calloc(words, sizeof(unsigned long long));
+    map->reached = (unsigned long long*)calloc(words, sizeof(unsigned long long));
+    map->next = (unsigned long long*)calloc(words, sizeof(unsigned long long));
+    if (map->passable == NULL || map->reached == NULL || map->next == NULL) {
+        freeReachMap(map);
+        return 0;
+    }
+    return 1;
+}
+
+/* Free the bitsets of a reachability map */
+void freeReachMap(ReachMap* map) {
+    free(map->passable);
+    free(map->reached);
+    free(map->next);
+    memset(map, 0, sizeof(*map));
+}
+
+/* Clear the reached bits of the rows and words the last fill wrote */
+static void clearLastFill(ReachMap* map) {
+    if (map->top < 0) {
+        return;
+    }
+    size_t length = (size_t)(map->right - map->left + 1) * sizeof(unsigned long long);
+    for (int row = map->top; row <= map->bottom; row++) {
+        size_t offset = (size_t)row * map->rowWords + map->left;
+        memset(&map->reached[offset], 0, length);
+        memset(&map->next[offset], 0, length);
+    }
+}
+
+/* Pack the passable cells of a block of rows and words, one bit per cell */
+static void loadPassable(ReachMap* map, const unsigned char* blocked, int top, int bottom, int left, int right) {
+    for (int row = top; row <= bottom; row++) {
+        const unsigned char* cells = &blocked[(size_t)row * map->width];
+        unsigned long long* words = &map->passable[(size_t)row * map->rowWords];
+        for (int word = left; word <= right; word++) {
+            int first = word * REACH_CELLS_PER_WORD;
+            int last = first + REACH_CELLS_PER_WORD < map->width ? first + REACH_CELLS_PER_WORD : map->width;
+            unsigned long long bits = 0;
+            for (int x = first; x < last; x++) {
+                bits |= (unsigned long long)(cells[x] == 0) << (x - first);
+            }
+            words[word] = bits;
+        }
+    }
+}
+
+/* Grow reached bits towards higher bits through the passable ones, doubling the distance each step */
+static unsigned long long fillUp(unsigned long long reached, unsigned long long passable) {
+    reached |= passable & (reached << 1);
+    passable &= passable << 1;
+    reached |= passable & (reached << 2);
+    passable &= passable << 2;
+    reached |= passable & (reached << 4);
+    passable &= passable << 4;
+    reached |= passable & (reached << 8);
+    passable &= passable << 8;
+    reached |= passable & (reached << 16);
+    passable &= passable << 16;
+    return reached | (passable & (reached << 32));
+}
+
+/* Grow reached bits towards lower bits through the passable ones, doubling the distance each step */
+static unsigned long long fillDown(unsigned long long reached, unsigned long long passable) {
+    reached |= passable & (reached >> 1);
+    passable &= passable >> 1;
+    reached |= passable & (reached >> 2);
+    passable &= passable >> 2;
+    reached |= passable & (reached >> 4);
+    passable &= passable >> 4;
+    reached |= passable & (reached >> 8);
+    passable &= passable >> 8;
+    reached |= passable & (reached >> 16);
+    passable &= passable >> 16;
+    return reached | (passable & (reached >> 32));
+}
+
+/*
+ * Reach a row from the row a sweep came from and fill its passable runs
+ * from end to end, the runs carry on across words through the carries.
+ * Returns nonzero if the row reached a cell it had not reached before.
+ */
+static unsigned long long sweepRow(ReachMap* map, int row, int from) {
+    unsigned long long* reached = &map->reached[(size_t)row * map->rowWords];
+    const unsigned long long* source = &map->reached[(size_t)from * map->rowWords];
+    const unsigned long long* passable = &map->passable[(size_t)row * map->rowWords];
+    unsigned long long changed = 0;
+
+    /* Runs are filled towards the end of the row, then back towards its start */
+    unsigned long long carry = 0;
+    for (int word = 0; word < map->rowWords; word++) {
+        unsigned long long bits = reached[word] | ((source[word] | carry) & passable[word]);
+        bits = fillUp(bits, passable[word]);
+        carry = bits >> 63;
+        changed |= bits ^ reached[word];
+        reached[word] = bits;
+    }
+    carry = 0;
+    for (int word = map->rowWords - 1; word >= 0; word--) {
+        unsigned long long bits = reached[word] | ((carry << 63) & passable[word]);
+        bits = fillDown(bits, passable[word]);
+        carry = bits & 1;
+        changed |= bits ^ reached[word];
+        reached[word] = bits;
+    }
+    return changed;
+}
+
+/* Fill the whole world from the start cell, sweeping down and up until nothing new is reached */
+static void sweepFill(ReachMap* map, const unsigned char* blocked, int x, int y) {
+    map->top = 0;
+    map->bottom = map->height - 1;
+    map->left = 0;
+    map->right = map->rowWords - 1;
+    loadPassable(map, blocked, map->top, map->bottom, map->left, map->right);
+    map->reached[(size_t)y * map->rowWords + x / REACH_CELLS_PER_WORD] |= 1ull << (x % REACH_CELLS_PER_WORD);
+
+    /* Fill the start cell's run first, the sweeps carry it on to the other rows */
+    sweepRow(map, y, y);
+    unsigned long long changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int row = 1; row < map->height; row++) {
+            changed |= sweepRow(map, row, row - 1);
+        }
+        for (int row = map->height - 2; row >= 0; row--) {
+            changed |= sweepRow(map, row, row + 1);
+        }
+    }
+}
+
+/* Grow the reached cells one move at a time inside the square the moves can cover */
+static void stepFill(ReachMap* map, const unsigned char* blocked, int x, int y, int maxSteps) {
+    map->top = y - maxSteps < 0 ? 0 : y - maxSteps;
+    map->bottom = y + maxSteps >= map->height ? map->height - 1 : y + maxSteps;
+    map->left = (x - maxSteps < 0 ? 0 : x - maxSteps) / REACH_CELLS_PER_WORD;
+    map->right = (x + maxSteps >= map->width ? map->width - 1 : x + maxSteps) / REACH_CELLS_PER_WORD;
+    loadPassable(map, blocked, map->top, map->bottom, map->left, map->right);
+    map->reached[(size_t)y * map->rowWords + x / REACH_CELLS_PER_WORD] |= 1ull << (x % REACH_CELLS_PER_WORD);
+
+    for (int step = 1; step <= maxSteps; step++) {
+        /* Only the square of the moves taken so far can hold reached cells */
+        int top = y - step < map->top ? map->top : y - step;
+        int bottom = y + step > map->bottom ? map->bottom : y + step;
+        int left = (x - step < 0 ? 0 : x - step) / REACH_CELLS_PER_WORD;
+        int right = (x + step >= map->width ? map->width - 1 : x + step) / REACH_CELLS_PER_WORD;
+
+        /* Bits outside the square are clear, so rows and words next to it can be read as they are */
+        unsigned long long changed = 0;
+        for (int row = top; row <= bottom; row++) {
+            const unsigned long long* current = &map->reached[(size_t)row * map->rowWords];
+            const unsigned long long* above = row > 0 ? current - map->rowWords : NULL;
+            const unsigned long long* below = row < map->height - 1 ? current + map->rowWords : NULL;
+            const unsigned long long* passable = &map->passable[(size_t)row * map->rowWords];
+            unsigned long long* next = &map->next[(size_t)row * map->rowWords];
+            for (int word = left; word <= right; word++) {
+                unsigned long long bits = current[word] | (current[word] << 1) | (current[word] >> 1);
+                if (word > 0) bits |= current[word - 1] >> 63;
+                if (word < map->rowWords - 1) bits |= current[word + 1] << 63;
+                if (above != NULL) bits |= above[word];
+                if (below != NULL) bits |= below[word];
+                bits &= passable[word];
+                changed |= bits ^ current[word];
+                next[word] = bits;
+            }
+        }
+
+        /* The square only grows, so every row and word of the step before is written again */
+        unsigned long long* swap = map->reached;
+        map->reached = map->next;
+        map->next = swap;
+        if (!changed) {
+            break;
+        }
+    }
+}
+
+/* Mark the cells reachable from a start cell in at most maxSteps moves, negative for no limit, around cells flagged in blocked */
+void floodFillReach(ReachMap* map, const unsigned char* blocked, int x, int y, int maxSteps) {
+    clearLastFill(map);
+
+    /* A path never visits a cell twice, so a limit of a move per cell is no limit at all */
+    if (maxSteps < 0 || (long long)maxSteps >= (long long)map->width * map->height) {
+        sweepFill(map, blocked, x, y);
+    } else {
+        stepFill(map, blocked, x, y, maxSteps);
+    }
+}
+
+/* Return 1 if the last fill reached the cell */
+int cellReached(const ReachMap* map, int x, int y) {
+    return (int)(map->reached[(size_t)y * map->rowWords + x / REACH_CELLS_PER_WORD] >> (x % REACH_CELLS_PER_WORD)) & 1;
+}
@@ -0,0 +1,43 @@
+/**
+ * SpaceXplorer Reachability Header
+ *
+ * This header defines a flood fill of the cells the ship can reach. The
+ * passable and reached cells are stored as one bit per cell, 64 cells to
+ * a word, so a whole word of cells is grown at once. A fill bounded by
+ * the ship's fuel grows the reached cells by one move in each direction
+ * per step, and only reads and writes the square those moves can cover
+ * around the start, so it costs the same in any size of world. An
+ * unbounded fill sweeps the rows down and up, filling every run of
+ * passable cells in a row at once, until a sweep reaches nothing new.
+ */
+
+#ifndef SPACEXPLORER_REACHABILITY_H
+#define SPACEXPLORER_REACHABILITY_H
+
+/**
+ * Reachability map
+ * Cell (x, y) is bit x % 64 of word y * rowWords + x / 64 of each bitset
+ */
+typedef struct {
+    int width;                      /* Width of the world */
+    int height;                     /* Height of the world */
+    int rowWords;                   /* Words of each row of a bitset */
+    unsigned long long* passable;   /* Cells the ship can move through */
+    unsigned long long* reached;    /* Cells reached by the fill */
+    unsigned long long* next;       /* Cells reached after the step being taken */
+    int top;                        /* First row the last fill wrote, -1 before the first fill */
+    int bottom;                     /* Last row the last fill wrote */
+    int left;                       /* First word of a row the last fill wrote */
+    int right;                      /* Last word of a row the last fill wrote */
+} ReachMap;
+
+/* Allocate the bitsets of a world with nothing reached, returns 0 if out of memory */
+int initReachMap(ReachMap* map, int width, int height);
+/* Free the bitsets of a reachability map */
+void freeReachMap(ReachMap* map);
+/* Mark the cells reachable from a start cell in at most maxSteps moves, negative for no limit, around cells flagged in blocked */
+void floodFillReach(ReachMap* map, const unsigned char* blocked, int x, int y, int maxSteps);
+/* Return 1 if the last fill reached the cell */
+int cellReached(const ReachMap* map, int x, int y);
+
+#endif /* SPACEXPLORER_REACHABILITY_H */
@@ -0,0 +1,672 @@
+/* File functions for the cache (tmpfile, fseek, fread, fwrite) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, calloc, realloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memset, memcpy, strchr) */
+#include <string.h>
+/* Sector world declarations */
+#include "sector_world.h"
+
+#ifndef _WIN32
+/* The thread loading the sectors and its signals */
+#include <pthread.h>
+#endif
+
+/* Cells of a sector */
+#define SECTOR_CELLS (SECTOR_SIZE * SECTOR_SIZE)
+/* Junk symbols in the order of JunkType */
+#define SECTOR_JUNK_SYMBOLS "MPEF"
+/* Cells around the ship's starting cell that are kept empty */
+#define SECTOR_START_CLEARANCE 1
+
+/* States of a sector */
+enum {
+    SECTOR_LOADING,     /* Waiting for the background thread to generate or read it */
+    SECTOR_READY,       /* Cells loaded, owned by the game */
+    SECTOR_WRITING      /* Evicted, waiting for the background thread to write it to the cache */
+};
+
+/**
+ * Sector
+ * Cell (x, y) of the sector is cells[y * SECTOR_SIZE + x], world cell
+ * (sx * SECTOR_SIZE + x, sy * SECTOR_SIZE + y)
+ */
+typedef struct Sector {
+    int sx;                         /* Sector column */
+    int sy;                         /* Sector row */
+    int state;                      /* SECTOR_LOADING, SECTOR_READY or SECTOR_WRITING */
+    int dirty;                      /* Flag set once the game changed a cell */
+    char cells[SECTOR_CELLS];       /* Map symbol of each cell */
+    struct Sector* hashNext;        /* Next sector of the same hash bucket */
+    struct Sector* lruPrev;         /* Sector used more recently */
+    struct Sector* lruNext;         /* Sector used less recently */
+    struct Sector* jobNext;         /* Next sector in the background thread's queue or in the loaded list */
+} Sector;
+
+/**
+ * Cache entry
+ * Where the last version of an evicted sector was written in the cache file
+ */
+typedef struct {
+    int sx;                 /* Sector column */
+    int sy;                 /* Sector row */
+    long offset;            /* Offset of the record in the file, -1 for an empty slot */
+} CacheEntry;
+
+/**
+ * Cache record header
+ * Followed in the file by a 2-byte entry per junk item, its cell in the
+ * low 12 bits and its type in the next 2
+ */
+typedef struct {
+    int junkCount;                                  /* Number of junk entries after the header */
+    unsigned long long obstacles[SECTOR_SIZE];      /* Obstacle bits of each row */
+} CacheRecord;
+
+/**
+ * Sector world
+ * The sectors and the LRU list belong to the game's thread, the job queue
+ * and the loaded list are shared with the background thread under the lock,
+ * and the cache file and its index belong to the background thread
+ */
+struct SectorWorld {
+    unsigned int seed;              /* World seed the sectors are generated from */
+    unsigned long long obstacleLimit; /* Cell hashes below this are obstacles */
+    unsigned long long junkLimit;   /* Cell hashes below this and not obstacles are junk */
+    Sector** buckets;               /* Hash table of the sectors kept or being loaded */
+    unsigned int bucketMask;        /* Number of buckets minus one */
+    Sector lru;                     /* Sentinel of the ready sectors, most recently used after it */
+    int resident;                   /* Number of ready sectors */
+    int budget;                     /* Number of ready sectors kept before the least recently used go */
+    Sector* pool;                   /* Block of budget sectors allocated with the world, NULL if it could not be */
+    Sector* spare;                  /* Unused sectors of the pool, linked through jobNext */
+    int keepLeft;                   /* First sector column of the area last prefetched */
+    int keepTop;                    /* First sector row of the area last prefetched */
+    int keepRight;                  /* Last sector column of the area last prefetched */
+    int keepBottom;                 /* Last sector row of the area last prefetched */
+    Sector* jobs;                   /* Sectors for the background thread to load or write, oldest first */
+    Sector* lastJob;                /* Newest sector of the queue */
+    Sector* loaded;                 /* Sectors loaded since the game last took them in */
+    FILE* cache;                    /* Cache file of changed sectors, NULL if none could be opened */
+    CacheEntry* index;              /* Hash table of the sectors in the cache file */
+    unsigned int indexMask;         /* Number of index slots minus one */
+    int indexCount;                 /* Number of sectors in the cache file */
+#ifndef _WIN32
+    pthread_t thread;               /* Background thread */
+    int threadStarted;              /* Flag set if the thread is running */
+    pthread_mutex_t lock;           /* Guards the queue, the loaded list, the spare sectors and the sector states */
+    pthread_cond_t wake;            /* Signaled when a job is queued or the world closes */
+    pthread_cond_t ready;           /* Signaled when a sector is loaded */
+    int stopping;                   /* Flag telling the thread to exit */
+#endif
+};
+
+#ifndef _WIN32
+/* Take the lock shared with the background thread */
+static void lockWorld(SectorWorld* world) {
+    pthread_mutex_lock(&world->lock);
+}
+
+/* Release the lock shared with the background thread */
+static void unlockWorld(SectorWorld* world) {
+    pthread_mutex_unlock(&world->lock);
+}
+#else
+/* Sectors are loaded on the game's thread, there is nothing to lock */
+static void lockWorld(SectorWorld* world) {
+    (void)world;
+}
+
+/* Sectors are loaded on the game's thread, there is nothing to unlock */
+static void unlockWorld(SectorWorld* world) {
+    (void)world;
+}
+#endif
+
+/* Take an unused sector from the pool, or from the heap once the pool is used up, returns NULL if out of memory */
+static Sector* takeSector(SectorWorld* world) {
+    lockWorld(world);
+    Sector* sector = world->spare;
+    if (sector != NULL) {
+        world->spare = sector->jobNext;
+    }
+    unlockWorld(world);
+    return sector != NULL ? sector : (Sector*)malloc(sizeof(Sector));
+}
+
+/* Return 1 if a sector belongs to the pool rather than the heap */
+static int pooledSector(const SectorWorld* world, const Sector* sector) {
+    return world->pool != NULL && sector >= world->pool && sector < world->pool + world->budget;
+}
+
+/* Give a sector back to the pool it came from, or free it if it came from the heap */
+static void releaseSector(SectorWorld* world, Sector* sector) {
+    if (pooledSector(world, sector)) {
+        lockWorld(world);
+        sector->jobNext = world->spare;
+        world->spare = sector;
+        unlockWorld(world);
+    } else {
+        free(sector);
+    }
+}
+
+/* Return the sector a cell coordinate is in, rounding down for negative ones */
+static int sectorOf(int coordinate) {
+    return coordinate >= 0 ? coordinate / SECTOR_SIZE : -((-(coordinate + 1)) / SECTOR_SIZE) - 1;
+}
+
+/* Mix sector or cell coordinates into a hash */
+static unsigned long long mixCoordinates(unsigned long long seed, int x, int y) {
+    unsigned long long hash = ((unsigned long long)(unsigned int)x << 32 | (unsigned int)y) ^ (seed * 0x9E3779B97F4A7C15ull);
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBull;
+    return hash ^ (hash >> 31);
+}
+
+/* Hash table bucket of a sector */
+static unsigned int sectorBucket(const SectorWorld* world, int sx, int sy) {
+    return (unsigned int)mixCoordinates(0, sx, sy) & world->bucketMask;
+}
+
+/* Find a sector kept or being loaded, NULL if it is not */
+static Sector* findSector(const SectorWorld* world, int sx, int sy) {
+    for (Sector* sector = world->buckets[sectorBucket(world, sx, sy)]; sector != NULL; sector = sector->hashNext) {
+        if (sector->sx == sx && sector->sy == sy) {
+            return sector;
+        }
+    }
+    return NULL;
+}
+
+/* Take a sector out of the hash table */
+static void removeSector(SectorWorld* world, Sector* sector) {
+    Sector** link = &world->buckets[sectorBucket(world, sector->sx, sector->sy)];
+    while (*link != sector) {
+        link = &(*link)->hashNext;
+    }
+    *link = sector->hashNext;
+}
+
+/* Take a ready sector out of the LRU list */
+static void unlinkRecent(Sector* sector) {
+    sector->lruPrev->lruNext = sector->lruNext;
+    sector->lruNext->lruPrev = sector->lruPrev;
+}
+
+/* Put a ready sector at the front of the LRU list */
+static void linkRecent(SectorWorld* world, Sector* sector) {
+    sector->lruPrev = &world->lru;
+    sector->lruNext = world->lru.lruNext;
+    world->lru.lruNext->lruPrev = sector;
+    world->lru.lruNext = sector;
+}
+
+/* Generate the cells of a sector from the world seed */
+static void generateSector(const SectorWorld* world, Sector* sector) {
+    for (int y = 0; y < SECTOR_SIZE; y++) {
+        int cellY = sector->sy * SECTOR_SIZE + y;
+        for (int x = 0; x < SECTOR_SIZE; x++) {
+            int cellX = sector->sx * SECTOR_SIZE + x;
+            unsigned long long hash = mixCoordinates(world->seed, cellX, cellY);
+            unsigned long long roll = hash & 0xFFFFFFFFull;
+            char symbol = '.';
+
+            /* The ship starts on cell (0, 0) with room to move */
+            if (abs(cellX) <= SECTOR_START_CLEARANCE && abs(cellY) <= SECTOR_START_CLEARANCE) {
+                symbol = '.';
+            } else if (roll < world->obstacleLimit) {
+                symbol = '#';
+            } else if (roll < world->junkLimit) {
+                symbol = SECTOR_JUNK_SYMBOLS[hash >> 62];
+            }
+            sector->cells[y * SECTOR_SIZE + x] = symbol;
+        }
+    }
+}
+
+/* Index slot of a sector in the cache file, or the empty slot it would go in */
+static CacheEntry* cacheSlot(const SectorWorld* world, int sx, int sy) {
+    unsigned int slot = (unsigned int)mixCoordinates(1, sx, sy) & world->indexMask;
+    while (world->index[slot].offset >= 0 && (world->index[slot].sx != sx || world->index[slot].sy != sy)) {
+        slot = (slot + 1) & world->indexMask;
+    }
+    return &world->index[slot];
+}
+
+/* Double the cache index, returns 0 if out of memory */
+static int growCacheIndex(SectorWorld* world) {
+    CacheEntry* old = world->index;
+    unsigned int oldSlots = world->indexMask + 1;
+    CacheEntry* grown = (CacheEntry*)malloc((size_t)oldSlots * 2 * sizeof(CacheEntry));
+    if (grown == NULL) {
+        return 0;
+    }
+    for (unsigned int slot = 0; slot < oldSlots * 2; slot++) {
+        grown[slot].offset = -1;
+    }
+    world->index = grown;
+    world->indexMask = oldSlots * 2 - 1;
+    for (unsigned int slot = 0; slot < oldSlots; slot++) {
+        if (old[slot].offset >= 0) {
+            *cacheSlot(world, old[slot].sx, old[slot].sy) = old[slot];
+        }
+    }
+    free(old);
+    return 1;
+}
+
+/* Write a changed sector to the cache file, over its last version if it has one */
+static void writeSector(SectorWorld* world, const Sector* sector) {
+    /* The index is kept at most half full so probes stay short */
+    if ((unsigned int)(world->indexCount + 1) * 2 > world->indexMask + 1 && !growCacheIndex(world)) {
+        return;
+    }
+
+    CacheRecord record;
+    unsigned short junk[SECTOR_CELLS];
+    memset(&record, 0, sizeof(record));
+    for (int cell = 0; cell < SECTOR_CELLS; cell++) {
+        char symbol = sector->cells[cell];
+        const char* type = symbol != '.' ? strchr(SECTOR_JUNK_SYMBOLS, symbol) : NULL;
+        if (symbol == '#') {
+            record.obstacles[cell / SECTOR_SIZE] |= 1ull << (cell % SECTOR_SIZE);
+        } else if (type != NULL) {
+            junk[record.junkCount++] = (unsigned short)(cell | (type - SECTOR_JUNK_SYMBOLS) << 12);
+        }
+    }
+
+    /* Junk is only ever collected, so a new version never outgrows the old one's place */
+    CacheEntry* entry = cacheSlot(world, sector->sx, sector->sy);
+    long offset = entry->offset;
+    if (offset < 0) {
+        if (fseek(world->cache, 0, SEEK_END) != 0 || (offset = ftell(world->cache)) < 0) {
+            return;
+        }
+    } else if (fseek(world->cache, offset, SEEK_SET) != 0) {
+        return;
+    }
+    if (fwrite(&record, sizeof(record), 1, world->cache) != 1 ||
+        fwrite(junk, sizeof(junk[0]), (size_t)record.junkCount, world->cache) != (size_t)record.junkCount) {
+        /* A sector that could not be written is generated again, with its junk back */
+        if (entry->offset >= 0) {
+            entry->offset = -1;
+            world->indexCount--;
+        }
+        return;
+    }
+    if (entry->offset < 0) {
+        entry->sx = sector->sx;
+        entry->sy = sector->sy;
+        entry->offset = offset;
+        world->indexCount++;
+    }
+}
+
+/* Read a sector's last version from the cache file, returns 0 if it has none */
+static int readSector(SectorWorld* world, Sector* sector) {
+    if (world->cache == NULL) {
+        return 0;
+    }
+    const CacheEntry* entry = cacheSlot(world, sector->sx, sector->sy);
+    CacheRecord record;
+    unsigned short junk[SECTOR_CELLS];
+    if (entry->offset < 0 || fseek(world->cache, entry->offset, SEEK_SET) != 0 ||
+        fread(&record, sizeof(record), 1, world->cache) != 1 ||
+        record.junkCount < 0 || record.junkCount > SECTOR_CELLS ||
+        fread(junk, sizeof(junk[0]), (size_t)record.junkCount, world->cache) != (size_t)record.junkCount) {
+        return 0;
+    }
+    for (int cell = 0; cell < SECTOR_CELLS; cell++) {
+        sector->cells[cell] = (record.obstacles[cell / SECTOR_SIZE] >> (cell % SECTOR_SIZE)) & 1 ? '#' : '.';
+    }
+    for (int i = 0; i < record.junkCount; i++) {
+        sector->cells[junk[i] & (SECTOR_CELLS - 1)] = SECTOR_JUNK_SYMBOLS[(junk[i] >> 12) & 3];
+    }
+    return 1;
+}
+
+/* Load or write a sector taken from the queue, a written sector is released */
+static void runSectorJob(SectorWorld* world, Sector* sector, int writing) {
+    if (writing) {
+        writeSector(world, sector);
+        releaseSector(world, sector);
+    } else if (!readSector(world, sector)) {
+        generateSector(world, sector);
+    }
+}
+
+/* Put a sector on the background thread's queue */
+static void queueSector(SectorWorld* world, Sector* sector) {
+#ifndef _WIN32
+    if (world->threadStarted) {
+        sector->jobNext = NULL;
+        lockWorld(world);
+        if (world->lastJob != NULL) {
+            world->lastJob->jobNext = sector;
+        } else {
+            world->jobs = sector;
+        }
+        world->lastJob = sector;
+        pthread_cond_signal(&world->wake);
+        unlockWorld(world);
+        return;
+    }
+#endif
+    /* With no thread the job is done right away */
+    int writing = sector->state == SECTOR_WRITING;
+    runSectorJob(world, sector, writing);
+    if (!writing) {
+        sector->state = SECTOR_READY;
+        sector->jobNext = world->loaded;
+        world->loaded = sector;
+    }
+}
+
+#ifndef _WIN32
+/* Background thread, loads and writes the queued sectors in order until the world closes */
+static void* sectorThread(void* argument) {
+    SectorWorld* world = (SectorWorld*)argument;
+    lockWorld(world);
+    for (;;) {
+        while (world->jobs == NULL && !world->stopping) {
+            pthread_cond_wait(&world->wake, &world->lock);
+        }
+        if (world->stopping) {
+            break;
+        }
+
+        /* A write queued before a load of the same sector is done first, so the load reads it back */
+        Sector* sector = world->jobs;
+        world->jobs = sector->jobNext;
+        if (world->jobs == NULL) {
+            world->lastJob = NULL;
+        }
+        int writing = sector->state == SECTOR_WRITING;
+        unlockWorld(world);
+        runSectorJob(world, sector, writing);
+        lockWorld(world);
+
+        if (!writing) {
+            sector->state = SECTOR_READY;
+            sector->jobNext = world->loaded;
+            world->loaded = sector;
+            pthread_cond_broadcast(&world->ready);
+        }
+    }
+    unlockWorld(world);
+    return NULL;
+}
+#endif
+
+/* Start a world with about the given numbers of obstacles and junk in every area of cells, returns NULL if out of memory */
+SectorWorld* openSectorWorld(unsigned int seed, int obstacles, int junk, long long cells, size_t memoryBudget) {
+    SectorWorld* world = (SectorWorld*)calloc(1, sizeof(SectorWorld));
+    if (world == NULL) {
+        return NULL;
+    }
+    world->seed = seed;
+    world->lru.lruPrev = &world->lru;
+    world->lru.lruNext = &world->lru;
+    world->keepRight = -1;
+    world->keepBottom = -1;
+
+    /* Each cell rolls a 32-bit number, the shares of the range match the shares of the cells */
+    unsigned long long range = 1ull << 32;
+    world->obstacleLimit = cells > 0 ? (unsigned long long)obstacles * range / (unsigned long long)cells : 0;
+    world->junkLimit = cells > 0 ? world->obstacleLimit + (unsigned long long)junk * range / (unsigned long long)cells : 0;
+    world->obstacleLimit = world->obstacleLimit < range ? world->obstacleLimit : range;
+    world->junkLimit = world->junkLimit < range ? world->junkLimit : range;
+
+    world->budget = (int)(memoryBudget / sizeof(Sector) > 1 ? memoryBudget / sizeof(Sector) : 1);
+    unsigned int buckets = 64;
+    while (buckets < 2u * (unsigned int)world->budget && buckets < (1u << 20)) {
+        buckets *= 2;
+    }
+    world->bucketMask = buckets - 1;
+    world->buckets = (Sector**)calloc(buckets, sizeof(Sector*));
+    world->indexMask = 63;
+    world->index = (CacheEntry*)malloc((size_t)(world->indexMask + 1) * sizeof(CacheEntry));
+    if (world->buckets == NULL || world->index == NULL) {
+        closeSectorWorld(world);
+        return NULL;
+    }
+    for (unsigned int slot = 0; slot <= world->indexMask; slot++) {
+        world->index[slot].offset = -1;
+    }
+
+    /* The sectors kept within the budget come from one block, so streaming does not go back to the heap */
+    world->pool = (Sector*)malloc((size_t)world->budget * sizeof(Sector));
+    for (int i = world->budget - 1; world->pool != NULL && i >= 0; i--) {
+        world->pool[i].jobNext = world->spare;
+        world->spare = &world->pool[i];
+    }
+
+    /* The cache file is deleted when it is closed, changed sectors stay in memory if there is none */
+    world->cache = tmpfile();
+
+#ifndef _WIN32
+    pthread_mutex_init(&world->lock, NULL);
+    pthread_cond_init(&world->wake, NULL);
+    pthread_cond_init(&world->ready, NULL);
+    /* Sectors are loaded on the game's thread if no thread can be started */
+    world->threadStarted = pthread_create(&world->thread, NULL, sectorThread, world) == 0;
+#endif
+    return world;
+}
+
+/* Stop the background thread and free a world, its sectors and its cache file */
+void closeSectorWorld(SectorWorld* world) {
+    if (world == NULL) {
+        return;
+    }
+#ifndef _WIN32
+    if (world->threadStarted) {
+        lockWorld(world);
+        world->stopping = 1;
+        pthread_cond_signal(&world->wake);
+        unlockWorld(world);
+        pthread_join(world->thread, NULL);
+    }
+    if (world->buckets != NULL) {
+        pthread_mutex_destroy(&world->lock);
+        pthread_cond_destroy(&world->wake);
+        pthread_cond_destroy(&world->ready);
+    }
+#endif
+
+    /* Sectors still queued for writing are only in the queue, all others are in the hash table */
+    while (world->jobs != NULL) {
+        Sector* sector = world->jobs;
+        world->jobs = sector->jobNext;
+        if (sector->state == SECTOR_WRITING && !pooledSector(world, sector)) {
+            free(sector);
+        }
+    }
+    if (world->buckets != NULL) {
+        for (unsigned int bucket = 0; bucket <= world->bucketMask; bucket++) {
+            while (world->buckets[bucket] != NULL) {
+                Sector* sector = world->buckets[bucket];
+                world->buckets[bucket] = sector->hashNext;
+                if (!pooledSector(world, sector)) {
+                    free(sector);
+                }
+            }
+        }
+    }
+    if (world->cache != NULL) {
+        fclose(world->cache);
+    }
+    free(world->pool);
+    free(world->buckets);
+    free(world->index);
+    free(world);
+}
+
+/* Add the sectors loaded in the background to the front of the LRU list */
+static void takeLoadedSectors(SectorWorld* world) {
+    lockWorld(world);
+    Sector* sector = world->loaded;
+    world->loaded = NULL;
+    unlockWorld(world);
+    while (sector != NULL) {
+        Sector* next = sector->jobNext;
+        linkRecent(world, sector);
+        world->resident++;
+        sector = next;
+    }
+}
+
+/* Return 1 if a sector is in the area last prefetched */
+static int sectorKept(const SectorWorld* world, const Sector* sector) {
+    return sector->sx >= world->keepLeft && sector->sx <= world->keepRight &&
+           sector->sy >= world->keepTop && sector->sy <= world->keepBottom;
+}
+
+/* Evict the least recently used sectors outside the kept area while over the budget */
+static void evictSectors(SectorWorld* world) {
+    Sector* sector = world->lru.lruPrev;
+    while (world->resident > world->budget && sector != &world->lru) {
+        Sector* previous = sector->lruPrev;
+        /* Changed sectors have nowhere to go without a cache file */
+        if (!sectorKept(world, sector) && (!sector->dirty || world->cache != NULL)) {
+            unlinkRecent(sector);
+            removeSector(world, sector);
+            world->resident--;
+            if (sector->dirty) {
+                lockWorld(world);
+                sector->state = SECTOR_WRITING;
+                unlockWorld(world);
+                queueSector(world, sector);
+            } else {
+                /* Unchanged sectors are generated again when needed */
+                releaseSector(world, sector);
+            }
+        }
+        sector = previous;
+    }
+}
+
+/* Queue the sectors of an area that are not kept or loading yet, moving the kept ones to the front of the LRU list */
+static void requestSectors(SectorWorld* world, int left, int top, int right, int bottom) {
+    for (int sy = top; sy <= bottom; sy++) {
+        for (int sx = left; sx <= right; sx++) {
+            Sector* sector = findSector(world, sx, sy);
+            if (sector == NULL) {
+                /* A sector that cannot be allocated reads as empty space */
+                sector = takeSector(world);
+                if (sector == NULL) {
+                    continue;
+                }
+                sector->sx = sx;
+                sector->sy = sy;
+                sector->state = SECTOR_LOADING;
+                sector->dirty = 0;
+                sector->lruPrev = NULL;
+                sector->lruNext = NULL;
+                unsigned int bucket = sectorBucket(world, sx, sy);
+                sector->hashNext = world->buckets[bucket];
+                world->buckets[bucket] = sector;
+                queueSector(world, sector);
+            } else {
+                lockWorld(world);
+                int ready = sector->state == SECTOR_READY && sector->lruNext != NULL;
+                unlockWorld(world);
+                /* Sectors loaded but not taken in yet are linked when they are */
+                if (ready) {
+                    unlinkRecent(sector);
+                    linkRecent(world, sector);
+                }
+            }
+        }
+    }
+}
+
+/* Load the sectors over an area, waiting for the ones not loaded yet, returns the number waited for */
+int requireSectors(SectorWorld* world, int left, int top, int width, int height) {
+    int firstX = sectorOf(left), lastX = sectorOf(left + width - 1);
+    int firstY = sectorOf(top), lastY = sectorOf(top + height - 1);
+    takeLoadedSectors(world);
+    requestSectors(world, firstX, firstY, lastX, lastY);
+
+    int waited = 0;
+    lockWorld(world);
+    for (int sy = firstY; sy <= lastY; sy++) {
+        for (int sx = firstX; sx <= lastX; sx++) {
+            Sector* sector = findSector(world, sx, sy);
+            if (sector != NULL && sector->state == SECTOR_LOADING) {
+                waited++;
+#ifndef _WIN32
+                while (sector->state == SECTOR_LOADING) {
+                    pthread_cond_wait(&world->ready, &world->lock);
+                }
+#endif
+            }
+        }
+    }
+    unlockWorld(world);
+    takeLoadedSectors(world);
+    return waited;
+}
+
+/* Keep the sectors over an area in memory and start loading the missing ones in the background */
+void prefetchSectors(SectorWorld* world, int left, int top, int width, int height) {
+    world->keepLeft = sectorOf(left);
+    world->keepTop = sectorOf(top);
+    world->keepRight = sectorOf(left + width - 1);
+    world->keepBottom = sectorOf(top + height - 1);
+    takeLoadedSectors(world);
+    requestSectors(world, world->keepLeft, world->keepTop, world->keepRight, world->keepBottom);
+    evictSectors(world);
+}
+
+/* Take in the sectors loaded in the background and evict the ones over the budget, without waiting */
+void pollSectors(SectorWorld* world) {
+    takeLoadedSectors(world);
+    evictSectors(world);
+}
+
+/* Return a ready sector, NULL if it is not loaded */
+static Sector* readySector(SectorWorld* world, int sx, int sy) {
+    Sector* sector = findSector(world, sx, sy);
+    if (sector == NULL) {
+        return NULL;
+    }
+    lockWorld(world);
+    int ready = sector->state == SECTOR_READY;
+    unlockWorld(world);
+    return ready ? sector : NULL;
+}
+
+/* Copy a row of cells as map symbols, cells of sectors that are not loaded read as empty */
+void readSectorRow(SectorWorld* world, int x, int y, int length, char* row) {
+    int sy = sectorOf(y);
+    int rowOffset = (y - sy * SECTOR_SIZE) * SECTOR_SIZE;
+    while (length > 0) {
+        /* Copy the part of the row inside one sector at a time */
+        int sx = sectorOf(x);
+        int column = x - sx * SECTOR_SIZE;
+        int run = SECTOR_SIZE - column < length ? SECTOR_SIZE - column : length;
+        const Sector* sector = readySector(world, sx, sy);
+        if (sector != NULL) {
+            memcpy(row, &sector->cells[rowOffset + column], (size_t)run);
+        } else {
+            memset(row, '.', (size_t)run);
+        }
+        row += run;
+        x += run;
+        length -= run;
+    }
+}
+
+/* Empty a cell of a loaded sector, the change is kept when the sector is evicted */
+void clearSectorCell(SectorWorld* world, int x, int y) {
+    int sx = sectorOf(x), sy = sectorOf(y);
+    Sector* sector = readySector(world, sx, sy);
+    if (sector != NULL) {
+        sector->cells[(y - sy * SECTOR_SIZE) * SECTOR_SIZE + (x - sx * SECTOR_SIZE)] = '.';
+        sector->dirty = 1;
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * SpaceXplorer Sector World Header
+ *
+ * This header defines worlds with no edges, streamed as square sectors
+ * around the ship. A sector is generated from the world seed and its
+ * coordinates the first time it is needed, so it always comes out the
+ * same. Sectors are kept in memory up to a budget, the ones used least
+ * recently going first, and they are taken from a block allocated with
+ * the world for the budget rather than from the heap. A sector the game changed, by collecting junk on
+ * it, is written to a cache file when it goes and read back from there
+ * the next time it is needed. A background thread generates, reads and
+ * writes the sectors, and the game asks for the sectors around its
+ * window well before the window reaches them, so moving the ship does
+ * not wait for them.
+ */
+
+#ifndef SPACEXPLORER_SECTOR_WORLD_H
+#define SPACEXPLORER_SECTOR_WORLD_H
+
+/* Size types (size_t) */
+#include <stddef.h>
+
+/* Width and height of a sector in cells */
+#define SECTOR_SIZE 64
+
+/* Streamed world, its sectors and the thread loading them */
+typedef struct SectorWorld SectorWorld;
+
+/* Start a world with about the given numbers of obstacles and junk in every area of cells, returns NULL if out of memory */
+SectorWorld* openSectorWorld(unsigned int seed, int obstacles, int junk, long long cells, size_t memoryBudget);
+/* Stop the background thread and free a world, its sectors and its cache file */
+void closeSectorWorld(SectorWorld* world);
+/* Load the sectors over an area, waiting for the ones not loaded yet, returns the number waited for */
+int requireSectors(SectorWorld* world, int left, int top, int width, int height);
+/* Keep the sectors over an area in memory and start loading the missing ones in the background */
+void prefetchSectors(SectorWorld* world, int left, int top, int width, int height);
+/* Take in the sectors loaded in the background and evict the ones over the budget, without waiting */
+void pollSectors(SectorWorld* world);
+/* Copy a row of cells as map symbols, cells of sectors that are not loaded read as empty */
+void readSectorRow(SectorWorld* world, int x, int y, int length, char* row);
+/* Empty a cell of a loaded sector, the change is kept when the sector is evicted */
+void clearSectorCell(SectorWorld* world, int x, int y);
+
+#endif /* SPACEXPLORER_SECTOR_WORLD_H */
@@ -0,0 +1,830 @@
+/* Enable GNU extensions (accept4) */
+#define _GNU_SOURCE
+/* Standard input/output functions (printf, perror, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (memcpy, memchr, etc.) */
+#include <string.h>
+/* Character handling functions (toupper, isspace) */
+#include <ctype.h>
+/* Error numbers (errno, EAGAIN) */
+#include <errno.h>
+/* Signal handling (signal, sig_atomic_t) */
+#include <signal.h>
+/* File descriptor functions (read, close) */
+#include <unistd.h>
+/* Socket functions (socket, bind, accept4, send) */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+/* Event notification (epoll_create1, epoll_wait) */
+#include <sys/epoll.h>
+/* Resource limits (setrlimit) */
+#include <sys/resource.h>
+/* Periodic timers (timerfd_create, timerfd_settime) */
+#include <sys/timerfd.h>
+/* Scatter-gather output (struct iovec) */
+#include <sys/uio.h>
+/* Game-specific declarations and structures */
+#include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Default assets embedded at build time */
+#include "assets.h"
+/* Shared-world multiplayer */
+#include "shared_world.h"
+/* Binary state stream for spectators */
+#include "state_stream.h"
+/* Server declarations */
+#include "server.h"
+
+/* Maximum number of events handled per epoll_wait call */
+#define SERVER_MAX_EVENTS 256
+/* Maximum length of one input line from a client */
+#define SERVER_MAX_LINE 64
+/* Clients with more unsent output than this are disconnected */
+#define SERVER_MAX_PENDING (1024 * 1024)
+/* Number of stream frames that can wait to be sent to one spectator */
+#define SPECTATOR_QUEUE_LENGTH 64
+/* Maximum number of frames handed to the socket in one call */
+#define SPECTATOR_MAX_IOV 16
+/* Number of ticks between keyframes sent to every spectator */
+#define SPECTATOR_KEYFRAME_INTERVAL 50
+/* Spectators further behind than this many unacknowledged ticks have their unsent frames dropped and start again from a keyframe */
+#define SPECTATOR_MAX_UNACKED 32
+
+/**
+ * Connection state
+ * Tracks which answer the server expects next from the client
+ */
+typedef enum {
+    SESSION_NAME,        /* Waiting for the player name */
+    SESSION_DIFFICULTY,  /* Waiting for the difficulty choice */
+    SESSION_PLAYING,     /* Waiting for game commands */
+    SESSION_CLOSING,     /* Game over, closing once output is sent */
+    SESSION_SPECTATING   /* Receiving the state stream, sending acknowledgements */
+} SessionState;
+
+/**
+ * Encoded stream frame
+ * Encoded once per tick and shared by every spectator it is queued for
+ */
+typedef struct {
+    int references;             /* Number of queues and encoders holding the frame */
+    size_t length;              /* Number of bytes in data */
+    char data[];                /* Frame header and body */
+} StreamFrame;
+
+/**
+ * Spectator queue
+ * Frames waiting to be sent to one spectator and its acknowledgement state
+ */
+typedef struct {
+    StreamFrame* frames[SPECTATOR_QUEUE_LENGTH];    /* Ring of queued frames */
+    int head;                                       /* Index of the oldest queued frame */
+    int count;                                      /* Number of queued frames */
+    size_t headOffset;                              /* Bytes of the oldest frame already sent */
+    int needsKeyframe;                              /* Flag set when the next frame must be a keyframe */
+    unsigned int ackedTick;                         /* Latest tick the spectator acknowledged, or the keyframe it was last resynchronized with */
+    unsigned char ack[STREAM_ACK_SIZE];             /* Partial acknowledgement */
+    int ackLength;                                  /* Number of bytes in the partial acknowledgement */
+} SpectatorQueue;
+
+/**
+ * Client session
+ * One connection with its own game and buffered input and output
+ */
+typedef struct Session {
+    int fd;                          /* Connected socket */
+    SessionState state;              /* Current protocol state */
+    int hasWorld;                    /* Flag indicating if the game world was created */
+    int wantsWrite;                  /* Flag indicating if EPOLLOUT is registered */
+    int playerId;                    /* Player id in the shared world, -1 if not joined */
+    SpectatorQueue* spectator;       /* Stream frames for a spectator, NULL for players */
+    Game game;                       /* Game played by this connection */
+    OutputBuffer output;             /* Rendered frames waiting to be sent */
+    char input[SERVER_MAX_LINE];     /* Partial input line */
+    size_t inputLength;              /* Number of bytes in the partial line */
+    struct Session* prev;            /* Previous session in the active list */
+    struct Session* next;            /* Next session in the active list */
+} Session;
+
+/* Flag set by the signal handler to stop the server */
+static volatile sig_atomic_t stopRequested = 0;
+/* epoll instance used by the event loop */
+static int epollDescriptor = -1;
+/* List of connected sessions */
+static Session* sessions = NULL;
+/* Number of connected sessions */
+static int sessionCount = 0;
+/* Sessions closed during the current batch of events, waiting to be freed */
+static Session* closedSessions = NULL;
+/* Settings the server was started with */
+static const ServerOptions* serverOptions = NULL;
+/* World played by all sessions in shared-world mode */
+static SharedWorld sharedWorld;
+/* Marker stored in epoll events for the shared world tick timer */
+static int tickTimerMarker;
+/* Marker stored in epoll events for the spectator listener */
+static int spectatorListenerMarker;
+/* Number of connected spectators */
+static int spectatorCount = 0;
+/* World state at the previous and the current tick, deltas are encoded between them */
+static StreamSnapshot streamSnapshots[2];
+/* Index of the snapshot of the current tick */
+static int currentSnapshot = 0;
+/* Flag indicating if the other snapshot holds the previous tick */
+static int hasBaseSnapshot = 0;
+/* Scratch buffer frames are encoded into */
+static OutputBuffer streamEncoding;
+
+/* Request a clean shutdown when interrupted */
+static void handleStopSignal(int signalNumber) {
+    (void)signalNumber;
+    stopRequested = 1;
+}
+
+/* Raise the open file limit so thousands of clients can connect */
+static void raiseFileLimit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+/* Create the non-blocking listening socket on the loopback interface */
+static int openListener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        perror("socket");
+        return -1;
+    }
+
+    /* Allow quick restarts of the server on the same port */
+    int enable = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, SOMAXCONN) != 0) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/* Update the events the session is registered for */
+static void watchSession(Session* session, int wantsWrite) {
+    if (session->wantsWrite == wantsWrite) {
+        return;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN | (wantsWrite ? EPOLLOUT : 0);
+    event.data.ptr = session;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_MOD, session->fd, &event);
+    session->wantsWrite = wantsWrite;
+}
+
+/* Disconnect a client, the session is freed after the current batch of events */
+static void closeSession(Session* session) {
+    epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, session->fd, NULL);
+    close(session->fd);
+    session->fd = -1;
+
+    /* Unlink from the active session list */
+    if (session->prev != NULL) session->prev->next = session->next;
+    else sessions = session->next;
+    if (session->next != NULL) session->next->prev = session->prev;
+    sessionCount--;
+
+    if (session->hasWorld) {
+        cleanupGame(&session->game);
+        session->hasWorld = 0;
+    }
+    if (session->playerId >= 0) {
+        leaveSharedWorld(&sharedWorld, session->playerId);
+        session->playerId = -1;
+    }
+    if (session->spectator != NULL) {
+        spectatorCount--;
+    }
+
+    /* Later events in the same batch may still point at this session */
+    session->next = closedSessions;
+    closedSessions = session;
+}
+
+/* Drop one reference to a stream frame, freeing it with the last one */
+static void releaseFrame(StreamFrame* frame) {
+    if (--frame->references == 0) {
+        free(frame);
+    }
+}
+
+/* Drop the queued frames not started yet, a frame partly sent is kept so the stream stays whole */
+static void dropQueuedFrames(SpectatorQueue* queue) {
+    int kept = queue->headOffset > 0 ? 1 : 0;
+    for (int i = kept; i < queue->count; i++) {
+        releaseFrame(queue->frames[(queue->head + i) % SPECTATOR_QUEUE_LENGTH]);
+    }
+    queue->count = kept;
+}
+
+/* Free the sessions closed while handling the last batch of events */
+static void freeClosedSessions(void) {
+    while (closedSessions != NULL) {
+        Session* session = closedSessions;
+        closedSessions = session->next;
+        if (session->spectator != NULL) {
+            SpectatorQueue* queue = session->spectator;
+            for (int i = 0; i < queue->count; i++) {
+                releaseFrame(queue->frames[(queue->head + i) % SPECTATOR_QUEUE_LENGTH]);
+            }
+            free(queue);
+        }
+        freeOutputBuffer(&session->output);
+        free(session);
+    }
+}
+
+/* Send queued stream frames straight from the shared buffers, returns 0 if the session was closed */
+static int flushSpectator(Session* session) {
+    SpectatorQueue* queue = session->spectator;
+    while (queue->count > 0) {
+        /* Hand several frames to the socket at once without copying them */
+        struct iovec parts[SPECTATOR_MAX_IOV];
+        int partCount = 0;
+        for (int i = 0; i < queue->count && partCount < SPECTATOR_MAX_IOV; i++) {
+            StreamFrame* frame = queue->frames[(queue->head + i) % SPECTATOR_QUEUE_LENGTH];
+            size_t skip = i == 0 ? queue->headOffset : 0;
+            parts[partCount].iov_base = frame->data + skip;
+            parts[partCount].iov_len = frame->length - skip;
+            partCount++;
+        }
+
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = parts;
+        message.msg_iovlen = (size_t)partCount;
+        ssize_t sent = sendmsg(session->fd, &message, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            /* Socket is full, continue when it becomes writable again */
+            watchSession(session, 1);
+            return 1;
+        }
+        if (sent <= 0) {
+            closeSession(session);
+            return 0;
+        }
+
+        /* Release the frames that were sent completely */
+        size_t remaining = (size_t)sent;
+        while (remaining > 0) {
+            StreamFrame* frame = queue->frames[queue->head];
+            size_t left = frame->length - queue->headOffset;
+            if (remaining < left) {
+                queue->headOffset += remaining;
+                break;
+            }
+            remaining -= left;
+            queue->headOffset = 0;
+            queue->head = (queue->head + 1) % SPECTATOR_QUEUE_LENGTH;
+            queue->count--;
+            releaseFrame(frame);
+        }
+    }
+
+    /* Everything was sent */
+    watchSession(session, 0);
+    return 1;
+}
+
+/* Send as much buffered output as the socket accepts, returns 0 if the session was closed */
+static int flushSession(Session* session) {
+    if (session->spectator != NULL) {
+        return flushSpectator(session);
+    }
+
+    OutputBuffer* output = &session->output;
+    while (output->offset < output->length) {
+        ssize_t sent = send(session->fd, output->data + output->offset,
+                            output->length - output->offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            consumeOutput(output, (size_t)sent);
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            /* Socket is full, continue when it becomes writable again */
+            if (output->length - output->offset > SERVER_MAX_PENDING) {
+                closeSession(session);
+                return 0;
+            }
+            watchSession(session, 1);
+            return 1;
+        } else {
+            closeSession(session);
+            return 0;
+        }
+    }
+
+    /* Everything was sent */
+    watchSession(session, 0);
+    if (session->state == SESSION_CLOSING) {
+        closeSession(session);
+        return 0;
+    }
+    return 1;
+}
+
+/* Render the current frame followed by the command prompt */
+static void sendFrame(Session* session) {
+    renderWorld(&session->game);
+    appendOutput(&session->output, SERVER_PROMPT, sizeof(SERVER_PROMPT) - 1);
+}
+
+/* Handle one complete input line from a client */
+static void processLine(Session* session, char* line) {
+    Game* game = &session->game;
+
+    /* Trim surrounding whitespace, including the carriage return sent by telnet */
+    size_t length = strlen(line);
+    while (length > 0 && isspace((unsigned char)line[length - 1])) line[--length] = 0;
+    while (*line != 0 && isspace((unsigned char)*line)) line++;
+
+    switch (session->state) {
+        case SESSION_NAME:
+            /* Store the player name, truncated to the maximum length */
+            strncpy(game->playerName, *line != 0 ? line : "Player", MAX_NAME_LENGTH - 1);
+            game->playerName[MAX_NAME_LENGTH - 1] = 0;
+            
+            if (serverOptions->shared) {
+                /* Join the shared world straight away, its difficulty is fixed */
+                session->playerId = joinSharedWorld(&sharedWorld, game->playerName);
+                if (session->playerId < 0) {
+                    appendOutputf(&session->output, "\nThe shared world is full, try again later.\n");
+                    session->state = SESSION_CLOSING;
+                    break;
+                }
+                session->state = SESSION_PLAYING;
+                renderSharedView(&sharedWorld, session->playerId, &session->output);
+                appendOutput(&session->output, SERVER_PROMPT, sizeof(SERVER_PROMPT) - 1);
+                break;
+            }
+            appendOutputf(&session->output, "Choose difficulty (E)asy, (M)edium, (H)ard: ");
+            session->state = SESSION_DIFFICULTY;
+            break;
+
+        case SESSION_DIFFICULTY:
+            /* Set difficulty based on the first character */
+            switch (toupper((unsigned char)line[0])) {
+                case 'E': game->difficulty = EASY; break;
+                case 'M': game->difficulty = MEDIUM; break;
+                case 'H': game->difficulty = HARD; break;
+                default:
+                    appendOutputf(&session->output, "Choose difficulty (E)asy, (M)edium, (H)ard: ");
+                    return;
+            }
+
+            /* Create the world, game output goes to this connection */
+            game->output = &session->output;
+            setupGame(game);
+            session->hasWorld = 1;
+            session->state = SESSION_PLAYING;
+            sendFrame(session);
+            break;
+
+        case SESSION_PLAYING:
+            if (serverOptions->shared) {
+                /* Shared world commands wait for the next tick */
+                queueSharedCommand(&sharedWorld, session->playerId, line[0],
+                                   toupper((unsigned char)line[0]) == 'U' ? atoi(line + 1) : 0);
+                break;
+            }
+            
+            /* Apply the command, U is followed by the item number */
+            applyCommand(game, line[0], toupper((unsigned char)line[0]) == 'U' ? atoi(line + 1) : 0);
+            updateGame(game);
+
+            if (game->isGameOver) {
+                /* Send the result and close the connection afterwards */
+                renderEndGameMessage(game);
+                session->state = SESSION_CLOSING;
+            } else {
+                sendFrame(session);
+            }
+            break;
+
+        case SESSION_CLOSING:
+        case SESSION_SPECTATING:
+            /* Ignore input after the game has ended, spectators only send acknowledgements */
+            break;
+    }
+}
+
+/* Record the ticks a spectator acknowledged, the latest complete one counts */
+static void readAcknowledgements(Session* session, const char* data, ssize_t length) {
+    SpectatorQueue* queue = session->spectator;
+    for (ssize_t i = 0; i < length; i++) {
+        queue->ack[queue->ackLength++] = (unsigned char)data[i];
+        if (queue->ackLength == STREAM_ACK_SIZE) {
+            unsigned int tick = (unsigned int)queue->ack[0] | (unsigned int)queue->ack[1] << 8 |
+                                (unsigned int)queue->ack[2] << 16 | (unsigned int)queue->ack[3] << 24;
+            /* Acknowledgements of frames sent before a resynchronization do not move the tick back */
+            if ((int)(tick - queue->ackedTick) > 0) {
+                queue->ackedTick = tick;
+            }
+            queue->ackLength = 0;
+        }
+    }
+}
+
+/* Process the input line gathered so far and start an empty one */
+static void endInputLine(Session* session) {
+    session->input[session->inputLength] = 0;
+    session->inputLength = 0;
+    processLine(session, session->input);
+}
+
+/* Read available input and process every complete line, returns 0 if the session was closed */
+static int readSession(Session* session) {
+    char data[4096];
+    for (;;) {
+        ssize_t received = recv(session->fd, data, sizeof(data), 0);
+        if (received == 0) {
+            closeSession(session);
+            return 0;
+        }
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            closeSession(session);
+            return 0;
+        }
+
+        if (session->spectator != NULL) {
+            readAcknowledgements(session, data, received);
+            continue;
+        }
+
+        /* Split the received bytes into lines, a line filling the buffer is processed and the byte starts the next one */
+        for (ssize_t i = 0; i < received; i++) {
+            if (data[i] != '\n' && session->inputLength == SERVER_MAX_LINE - 1) {
+                endInputLine(session);
+            }
+            if (data[i] == '\n') {
+                endInputLine(session);
+            } else {
+                session->input[session->inputLength++] = data[i];
+            }
+        }
+    }
+    return flushSession(session);
+}
+
+/* Accept all pending connections and greet the new players or start streaming to the new spectators */
+static void acceptSessions(int listener, int spectating) {
+    for (;;) {
+        int fd = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            /* Stop when there are no more pending connections or no descriptors left */
+            return;
+        }
+
+        /* Frames are small, send them without waiting to fill a segment */
+        int enable = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        Session* session = (Session*)calloc(1, sizeof(Session));
+        if (session == NULL) {
+            close(fd);
+            continue;
+        }
+        session->fd = fd;
+        session->state = spectating ? SESSION_SPECTATING : SESSION_NAME;
+        session->playerId = -1;
+        initOutputBuffer(&session->output);
+        if (spectating) {
+            /* Spectators start with a keyframe on the next tick */
+            session->spectator = (SpectatorQueue*)calloc(1, sizeof(SpectatorQueue));
+            if (session->spectator == NULL) {
+                close(fd);
+                free(session);
+                continue;
+            }
+            session->spectator->needsKeyframe = 1;
+            session->spectator->ackedTick = sharedWorld.tick;
+        }
+
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = session;
+        if (epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, fd, &event) != 0) {
+            close(fd);
+            free(session->spectator);
+            free(session);
+            continue;
+        }
+
+        /* Link into the active session list */
+        session->next = sessions;
+        if (sessions != NULL) sessions->prev = session;
+        sessions = session;
+        sessionCount++;
+        if (spectating) {
+            spectatorCount++;
+            continue;
+        }
+
+        /* Send the welcome screen and ask for the player name */
+        appendOutputf(&session->output, "\n========================================\n");
+        appendOutputf(&session->output, "        WELCOME TO SPACEXPLORER        \n");
+        appendOutputf(&session->output, "========================================\n\n");
+        appendOutput(&session->output, DEFAULT_INTRO_TEXT, sizeof(DEFAULT_INTRO_TEXT) - 1);
+        appendOutputf(&session->output, "\nEnter your name (max %d characters): ", MAX_NAME_LENGTH - 1);
+        flushSession(session);
+    }
+}
+
+/* Copy the encoded frame out of the scratch buffer into a frame that spectators can share */
+static StreamFrame* takeEncodedFrame(void) {
+    size_t length = streamEncoding.length - streamEncoding.offset;
+    StreamFrame* frame = (StreamFrame*)malloc(sizeof(StreamFrame) + length);
+    if (frame != NULL) {
+        frame->references = 1;
+        frame->length = length;
+        memcpy(frame->data, streamEncoding.data + streamEncoding.offset, length);
+    }
+    clearOutputBuffer(&streamEncoding);
+    return frame;
+}
+
+/* Encode the tick once and queue the same frame for every spectator */
+static void streamToSpectators(void) {
+    if (spectatorCount == 0) {
+        /* Nobody is watching, the next spectator starts from a keyframe anyway */
+        hasBaseSnapshot = 0;
+        return;
+    }
+
+    StreamSnapshot* base = &streamSnapshots[currentSnapshot];
+    StreamSnapshot* current = &streamSnapshots[currentSnapshot ^ 1];
+    if (!captureSnapshot(current, &sharedWorld)) {
+        hasBaseSnapshot = 0;
+        return;
+    }
+    currentSnapshot ^= 1;
+
+    /* Everyone gets a keyframe periodically, otherwise only spectators resynchronizing do */
+    int periodicKeyframe = !hasBaseSnapshot || current->tick % SPECTATOR_KEYFRAME_INTERVAL == 0;
+    StreamFrame* keyframe = NULL;
+    StreamFrame* delta = NULL;
+
+    for (Session* session = sessions; session != NULL; ) {
+        Session* next = session->next;
+        SpectatorQueue* queue = session->spectator;
+        if (queue == NULL) {
+            session = next;
+            continue;
+        }
+
+        /* A spectator that is too far behind skips the frames it has not been sent yet and resynchronizes with a keyframe */
+        int resynchronize = queue->count == SPECTATOR_QUEUE_LENGTH ||
+                            current->tick - queue->ackedTick > SPECTATOR_MAX_UNACKED;
+        if (resynchronize) {
+            dropQueuedFrames(queue);
+            queue->needsKeyframe = 1;
+        }
+
+        StreamFrame* frame;
+        if (queue->needsKeyframe || periodicKeyframe) {
+            if (keyframe == NULL) {
+                encodeKeyframe(&streamEncoding, current);
+                keyframe = takeEncodedFrame();
+            }
+            frame = keyframe;
+        } else {
+            if (delta == NULL) {
+                encodeDelta(&streamEncoding, base, current);
+                delta = takeEncodedFrame();
+            }
+            frame = delta;
+        }
+        if (frame == NULL) {
+            queue->needsKeyframe = 1;
+            session = next;
+            continue;
+        }
+
+        /* The keyframe starts the spectator over, its tick is where the unacknowledged ticks count from */
+        if (resynchronize) {
+            queue->ackedTick = current->tick;
+        }
+        queue->needsKeyframe = 0;
+        frame->references++;
+        queue->frames[(queue->head + queue->count) % SPECTATOR_QUEUE_LENGTH] = frame;
+        queue->count++;
+        flushSession(session);
+        session = next;
+    }
+
+    /* Drop the encoder's own references, queued frames stay alive until sent */
+    if (keyframe != NULL) releaseFrame(keyframe);
+    if (delta != NULL) releaseFrame(delta);
+    hasBaseSnapshot = 1;
+}
+
+/* Advance the shared world and send every player their new view */
+static void tickSessions(int timer) {
+    /* Read the number of expirations to rearm the timer */
+    unsigned long long expirations;
+    if (read(timer, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+        return;
+    }
+
+    tickSharedWorld(&sharedWorld);
+
+    for (Session* session = sessions; session != NULL; ) {
+        Session* next = session->next;
+        if (session->state == SESSION_PLAYING) {
+            SharedPlayer* player = &sharedWorld.players[session->playerId];
+            if (player->isGameOver) {
+                /* Reuse the single-player end screen and leaderboard for the result */
+                Game* game = &session->game;
+                game->ship = player->ship;
+                game->score = player->score;
+                game->hasWon = player->hasWon;
+                game->difficulty = sharedWorld.difficulty;
+                game->output = &session->output;
+                renderEndGameMessage(game);
+                session->state = SESSION_CLOSING;
+            } else {
+                renderSharedView(&sharedWorld, session->playerId, &session->output);
+                appendOutput(&session->output, SERVER_PROMPT, sizeof(SERVER_PROMPT) - 1);
+            }
+            flushSession(session);
+        }
+        session = next;
+    }
+
+    streamToSpectators();
+}
+
+/* Start the periodic timer that ticks the shared world, returns its descriptor */
+static int startTickTimer(int tickMillis) {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer < 0) {
+        perror("timerfd_create");
+        return -1;
+    }
+
+    struct itimerspec interval;
+    interval.it_interval.tv_sec = tickMillis / 1000;
+    interval.it_interval.tv_nsec = (long)(tickMillis % 1000) * 1000000L;
+    interval.it_value = interval.it_interval;
+    timerfd_settime(timer, 0, &interval, NULL);
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = &tickTimerMarker;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, timer, &event);
+    return timer;
+}
+
+/* Run the game server on the loopback interface until interrupted */
+int runServer(const ServerOptions* options) {
+    serverOptions = options;
+
+    /* Load settings once, they are shared by every session */
+    loadConfig();
+    raiseFileLimit();
+
+    int listener = openListener(options->port);
+    if (listener < 0) {
+        return 1;
+    }
+
+    epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    struct epoll_event listenEvent;
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.ptr = NULL;
+    epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, listener, &listenEvent);
+
+    /* In shared-world mode create the world and tick it on a timer */
+    int timer = -1;
+    int spectatorListener = -1;
+    if (options->shared) {
+        if (!createSharedWorld(&sharedWorld, options->difficulty)) {
+            fprintf(stderr, "Not enough memory for the shared world\n");
+            return 1;
+        }
+        timer = startTickTimer(options->tickMillis > 0 ? options->tickMillis : SERVER_DEFAULT_TICK_MS);
+
+        /* Spectators connect to their own port and receive the binary state stream */
+        if (options->spectatorPort > 0) {
+            spectatorListener = openListener(options->spectatorPort);
+            if (spectatorListener < 0) {
+                return 1;
+            }
+            struct epoll_event spectatorEvent;
+            spectatorEvent.events = EPOLLIN;
+            spectatorEvent.data.ptr = &spectatorListenerMarker;
+            epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, spectatorListener, &spectatorEvent);
+            initOutputBuffer(&streamEncoding);
+            initSnapshot(&streamSnapshots[0]);
+            initSnapshot(&streamSnapshots[1]);
+        }
+    } else if (options->spectatorPort > 0) {
+        fprintf(stderr, "Spectating needs a shared world, ignoring the spectator port\n");
+    }
+
+    signal(SIGINT, handleStopSignal);
+    signal(SIGTERM, handleStopSignal);
+    printf("SpaceXplorer server listening on 127.0.0.1:%d%s\n", options->port,
+           options->shared ? " (shared world)" : "");
+    if (spectatorListener >= 0) {
+        printf("Spectators can connect on 127.0.0.1:%d\n", options->spectatorPort);
+    }
+    fflush(stdout);
+
+    struct epoll_event events[SERVER_MAX_EVENTS];
+    while (!stopRequested) {
+        /* Wake up at least once a second to check for config changes */
+        int count = epoll_wait(epollDescriptor, events, SERVER_MAX_EVENTS, 1000);
+        if (count < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            Session* session = (Session*)events[i].data.ptr;
+            if (session == NULL) {
+                acceptSessions(listener, 0);
+                continue;
+            }
+            if (events[i].data.ptr == &spectatorListenerMarker) {
+                acceptSessions(spectatorListener, 1);
+                continue;
+            }
+            if (events[i].data.ptr == &tickTimerMarker) {
+                tickSessions(timer);
+                continue;
+            }
+            if (session->fd < 0) {
+                /* Closed earlier in this batch */
+                continue;
+            }
+
+            /* Drop broken connections, otherwise read input before sending output */
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                closeSession(session);
+            } else if ((events[i].events & EPOLLIN) && !readSession(session)) {
+                continue;
+            } else if (events[i].events & EPOLLOUT) {
+                flushSession(session);
+            }
+        }
+
+        freeClosedSessions();
+
+        /* Apply balance changes from the config file to every running game */
+        if (pollConfigWatch() && reloadConfig()) {
+            for (Session* session = sessions; session != NULL; session = session->next) {
+                if (session->hasWorld) {
+                    applyConfig(&session->game);
+                }
+            }
+        }
+    }
+
+    /* Disconnect everyone before exiting */
+    printf("Shutting down, closing %d sessions\n", sessionCount);
+    while (sessions != NULL) {
+        closeSession(sessions);
+    }
+    freeClosedSessions();
+    close(listener);
+    if (timer >= 0) {
+        close(timer);
+        destroySharedWorld(&sharedWorld);
+    }
+    if (spectatorListener >= 0) {
+        close(spectatorListener);
+        freeSnapshot(&streamSnapshots[0]);
+        freeSnapshot(&streamSnapshots[1]);
+        freeOutputBuffer(&streamEncoding);
+    }
+    close(epollDescriptor);
+    stopConfigWatch();
+    return 0;
+}
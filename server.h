@@ -0,0 +1,56 @@
+/**
+ * SpaceXplorer Server Header
+ *
+ * This header defines the multi-session game server. Every TCP
+ * connection plays its own game, sending one command per line and
+ * receiving the rendered frame after each command.
+ *
+ * Protocol (plain text, one line per message):
+ * - Server sends the intro and asks for a name, client sends a name line
+ * - Server asks for a difficulty, client sends E, M or H
+ * - Server sends a frame ending with SERVER_PROMPT, client sends a command
+ *   (W, A, S, D, I, Q, or U1/U2 to use an item)
+ * - When the game ends the server sends the end message and closes
+ *
+ * In shared-world mode all connections play in one world, the difficulty
+ * prompt is skipped, and commands are applied on a fixed tick after which
+ * every player receives the view around their ship.
+ *
+ * A shared world can also be watched on a separate spectator port. The
+ * server writes the binary state stream from state_stream.h to every
+ * spectator and each spectator acknowledges the ticks it applied.
+ */
+
+#ifndef SPACEXPLORER_SERVER_H
+#define SPACEXPLORER_SERVER_H
+
+/* Game difficulty settings */
+#include "game.h"
+
+/* Default TCP port for the game server */
+#define SERVER_DEFAULT_PORT 4000
+/* Prompt that ends every frame sent to a client */
+#define SERVER_PROMPT "\nEnter command: "
+
+/* Default TCP port for spectators of the shared world */
+#define SERVER_DEFAULT_SPECTATOR_PORT 4001
+
+/* Default tick interval of the shared world in milliseconds */
+#define SERVER_DEFAULT_TICK_MS 100
+
+/**
+ * Server settings
+ * Chosen on the command line when starting the server
+ */
+typedef struct {
+    int port;                   /* TCP port to listen on */
+    int shared;                 /* Flag for shared-world mode */
+    Difficulty difficulty;      /* Difficulty of the shared world */
+    int tickMillis;             /* Shared world tick interval in milliseconds */
+    int spectatorPort;          /* TCP port for spectators of the shared world, 0 for none */
+} ServerOptions;
+
+/* Run the game server on the loopback interface until interrupted, returns the exit code */
+int runServer(const ServerOptions* options);
+
+#endif /* SPACEXPLORER_SERVER_H */
@@ -0,0 +1,512 @@
+/* Memory allocation functions (malloc, free, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (memset, strncpy, etc.) */
+#include <string.h>
+/* Character handling functions (toupper) */
+#include <ctype.h>
+/* Game-specific declarations and structures */
+#include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Shared world declarations */
+#include "shared_world.h"
+
+/* Symbol used for other players' ships */
+#define OTHER_SHIP_SYMBOL 'O'
+/* Width and height of a player's view */
+#define VIEW_SIZE (2 * SHARED_VIEW_RADIUS + 1)
+
+/* Draw the next number from the world's own xorshift generator */
+static unsigned int nextRandom(SharedWorld* world) {
+    unsigned int x = world->random;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    world->random = x;
+    return x;
+}
+
+/* Mix three numbers into a well-distributed hash, used to rank pickup claims */
+static unsigned int mixHash(unsigned int a, unsigned int b, unsigned int c) {
+    unsigned int h = a * 0x9E3779B1u ^ b * 0x85EBCA77u ^ c * 0xC2B2AE3Du;
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    return h;
+}
+
+/* Find the spatial cell containing a world position */
+static int cellAt(const SharedWorld* world, int x, int y) {
+    return (y / SHARED_CELL_SIZE) * world->cellsX + x / SHARED_CELL_SIZE;
+}
+
+/* Allocate cell lists for the given number of cells and entities */
+static int initCellLists(CellLists* lists, int cellCount, int capacity) {
+    lists->heads = (int*)malloc((size_t)cellCount * sizeof(int));
+    lists->next = (int*)malloc((size_t)(capacity + 1) * sizeof(int));
+    lists->prev = (int*)malloc((size_t)(capacity + 1) * sizeof(int));
+    lists->cell = (int*)malloc((size_t)(capacity + 1) * sizeof(int));
+    if (lists->heads == NULL || lists->next == NULL || lists->prev == NULL || lists->cell == NULL) {
+        return 0;
+    }
+    for (int i = 0; i < cellCount; i++) lists->heads[i] = -1;
+    for (int i = 0; i < capacity; i++) lists->cell[i] = -1;
+    return 1;
+}
+
+/* Make room for more entities in the cell lists */
+static int growCellLists(CellLists* lists, int oldCapacity, int capacity) {
+    int* next = (int*)realloc(lists->next, (size_t)capacity * sizeof(int));
+    if (next != NULL) lists->next = next;
+    int* prev = (int*)realloc(lists->prev, (size_t)capacity * sizeof(int));
+    if (prev != NULL) lists->prev = prev;
+    int* cell = (int*)realloc(lists->cell, (size_t)capacity * sizeof(int));
+    if (cell != NULL) lists->cell = cell;
+    if (next == NULL || prev == NULL || cell == NULL) {
+        return 0;
+    }
+    for (int i = oldCapacity; i < capacity; i++) lists->cell[i] = -1;
+    return 1;
+}
+
+/* Free the memory used by cell lists */
+static void freeCellLists(CellLists* lists) {
+    free(lists->heads);
+    free(lists->next);
+    free(lists->prev);
+    free(lists->cell);
+}
+
+/* Link an entity into the list of a cell */
+static void linkEntity(CellLists* lists, int id, int cell) {
+    lists->cell[id] = cell;
+    lists->prev[id] = -1;
+    lists->next[id] = lists->heads[cell];
+    if (lists->heads[cell] >= 0) lists->prev[lists->heads[cell]] = id;
+    lists->heads[cell] = id;
+}
+
+/* Remove an entity from the list of its cell */
+static void unlinkEntity(CellLists* lists, int id) {
+    int cell = lists->cell[id];
+    if (cell < 0) return;
+    if (lists->prev[id] >= 0) lists->next[lists->prev[id]] = lists->next[id];
+    else lists->heads[cell] = lists->next[id];
+    if (lists->next[id] >= 0) lists->prev[lists->next[id]] = lists->prev[id];
+    lists->cell[id] = -1;
+}
+
+/* Move an entity to another cell list if its cell changed */
+static void relinkEntity(CellLists* lists, int id, int cell) {
+    if (lists->cell[id] != cell) {
+        unlinkEntity(lists, id);
+        linkEntity(lists, id, cell);
+    }
+}
+
+/* Check if a position has an asteroid on it, looking only at the asteroids in its cell */
+static int hasAsteroidAt(const SharedWorld* world, int x, int y) {
+    for (int a = world->asteroidCells.heads[cellAt(world, x, y)]; a >= 0; a = world->asteroidCells.next[a]) {
+        if (world->asteroids[a].position.x == x && world->asteroids[a].position.y == y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Check if a position holds junk, looking only at the junk in its cell */
+static int hasJunkAt(const SharedWorld* world, int x, int y) {
+    for (int j = world->junkCells.heads[cellAt(world, x, y)]; j >= 0; j = world->junkCells.next[j]) {
+        if (world->junkItems[j].position.x == x && world->junkItems[j].position.y == y) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Pick a random cell free of obstacles, asteroids and junk, returns 0 if none was found */
+static int findFreePosition(SharedWorld* world, Position* position) {
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        int x = (int)(nextRandom(world) % (unsigned int)world->worldWidth);
+        int y = (int)(nextRandom(world) % (unsigned int)world->worldHeight);
+        if (!world->obstacleMap[y * world->worldWidth + x] &&
+            !hasAsteroidAt(world, x, y) && !hasJunkAt(world, x, y)) {
+            position->x = x;
+            position->y = y;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Give a junk item a random type and place it on a free cell */
+static void spawnJunk(SharedWorld* world, int index) {
+    SpaceJunk* junk = &world->junkItems[index];
+    unlinkEntity(&world->junkCells, index);
+    if (!findFreePosition(world, &junk->position)) {
+        junk->collected = 1;
+        return;
+    }
+    junk->type = (JunkType)(nextRandom(world) % 4);
+    junk->value = gameConfig.junkValues[junk->type];
+    junk->symbol = junkSymbol(junk->type);
+    junk->collected = 0;
+    linkEntity(&world->junkCells, index, cellAt(world, junk->position.x, junk->position.y));
+}
+
+/* Create a shared world using the current settings */
+int createSharedWorld(SharedWorld* world, Difficulty difficulty) {
+    memset(world, 0, sizeof(*world));
+    world->worldWidth = gameConfig.worldWidth;
+    world->worldHeight = gameConfig.worldHeight;
+    world->difficulty = difficulty;
+    world->random = gameConfig.seed != 0 ? (unsigned int)gameConfig.seed : 0x2545F491u;
+    world->cellsX = (world->worldWidth + SHARED_CELL_SIZE - 1) / SHARED_CELL_SIZE;
+    world->cellsY = (world->worldHeight + SHARED_CELL_SIZE - 1) / SHARED_CELL_SIZE;
+    int cellCount = world->cellsX * world->cellsY;
+
+    /* Allocate the world state and the spatial cell lists */
+    world->asteroidCount = gameConfig.asteroidCount;
+    world->junkCount = gameConfig.junkCounts[difficulty];
+    world->playerCapacity = 64;
+    world->obstacleMap = (unsigned char*)calloc((size_t)world->worldWidth * world->worldHeight, 1);
+    world->asteroids = (Asteroid*)malloc((size_t)(world->asteroidCount + 1) * sizeof(Asteroid));
+    world->junkItems = (SpaceJunk*)malloc((size_t)(world->junkCount + 1) * sizeof(SpaceJunk));
+    world->junkClaims = (int*)malloc((size_t)(world->junkCount + 1) * sizeof(int));
+    world->players = (SharedPlayer*)calloc((size_t)world->playerCapacity, sizeof(SharedPlayer));
+    if (world->obstacleMap == NULL || world->asteroids == NULL || world->junkItems == NULL ||
+        world->junkClaims == NULL || world->players == NULL ||
+        !initCellLists(&world->playerCells, cellCount, world->playerCapacity) ||
+        !initCellLists(&world->junkCells, cellCount, world->junkCount) ||
+        !initCellLists(&world->asteroidCells, cellCount, world->asteroidCount)) {
+        destroySharedWorld(world);
+        return 0;
+    }
+
+    /* Launch asteroids from random edges, moving into the world */
+    for (int i = 0; i < world->asteroidCount; i++) {
+        Asteroid* asteroid = &world->asteroids[i];
+        int edge = (int)(nextRandom(world) % 4);
+        int alongX = (int)(nextRandom(world) % (unsigned int)world->worldWidth);
+        int alongY = (int)(nextRandom(world) % (unsigned int)world->worldHeight);
+        int drift = (int)(nextRandom(world) % 3) - 1;
+        switch (edge) {
+            case 0: asteroid->position.x = alongX; asteroid->position.y = 0;
+                    asteroid->direction.x = drift; asteroid->direction.y = 1; break;
+            case 1: asteroid->position.x = world->worldWidth - 1; asteroid->position.y = alongY;
+                    asteroid->direction.x = -1; asteroid->direction.y = drift; break;
+            case 2: asteroid->position.x = alongX; asteroid->position.y = world->worldHeight - 1;
+                    asteroid->direction.x = drift; asteroid->direction.y = -1; break;
+            default: asteroid->position.x = 0; asteroid->position.y = alongY;
+                     asteroid->direction.x = 1; asteroid->direction.y = drift; break;
+        }
+        asteroid->symbol = 'A';
+        linkEntity(&world->asteroidCells, i, cellAt(world, asteroid->position.x, asteroid->position.y));
+    }
+
+    /* Scatter obstacles on cells without asteroids */
+    for (int i = 0; i < gameConfig.obstacleCount; i++) {
+        for (int attempt = 0; attempt < 1000; attempt++) {
+            int x = (int)(nextRandom(world) % (unsigned int)world->worldWidth);
+            int y = (int)(nextRandom(world) % (unsigned int)world->worldHeight);
+            if (!world->obstacleMap[y * world->worldWidth + x] && !hasAsteroidAt(world, x, y)) {
+                world->obstacleMap[y * world->worldWidth + x] = 1;
+                break;
+            }
+        }
+    }
+
+    /* Scatter the junk on the remaining free cells */
+    for (int i = 0; i < world->junkCount; i++) {
+        world->junkCells.cell[i] = -1;
+        world->junkClaims[i] = -1;
+        spawnJunk(world, i);
+    }
+    return 1;
+}
+
+/* Free all memory used by a shared world */
+void destroySharedWorld(SharedWorld* world) {
+    free(world->obstacleMap);
+    free(world->asteroids);
+    free(world->junkItems);
+    free(world->junkClaims);
+    free(world->players);
+    freeCellLists(&world->playerCells);
+    freeCellLists(&world->junkCells);
+    freeCellLists(&world->asteroidCells);
+    memset(world, 0, sizeof(*world));
+}
+
+/* Add a player at a random free position */
+int joinSharedWorld(SharedWorld* world, const char* playerName) {
+    /* Reuse the first free slot, or grow the player array */
+    int id = 0;
+    while (id < world->playerCapacity && world->players[id].active) id++;
+    if (id == world->playerCapacity) {
+        int capacity = world->playerCapacity * 2;
+        SharedPlayer* players = (SharedPlayer*)realloc(world->players, (size_t)capacity * sizeof(SharedPlayer));
+        if (players == NULL) return -1;
+        memset(players + world->playerCapacity, 0, (size_t)(capacity - world->playerCapacity) * sizeof(SharedPlayer));
+        world->players = players;
+        if (!growCellLists(&world->playerCells, world->playerCapacity, capacity)) return -1;
+        world->playerCapacity = capacity;
+    }
+
+    SharedPlayer* player = &world->players[id];
+    memset(player, 0, sizeof(*player));
+    if (!findFreePosition(world, &player->ship.position)) {
+        return -1;
+    }
+
+    /* Initialize the ship with the same stats as a single-player game */
+    player->active = 1;
+    player->ship.fuel = gameConfig.fuelLevels[world->difficulty];
+    player->ship.maxFuel = gameConfig.fuelLevels[world->difficulty];
+    player->ship.health = gameConfig.maxHealth;
+    player->ship.maxHealth = gameConfig.maxHealth;
+    strncpy(player->playerName, playerName, MAX_NAME_LENGTH - 1);
+    linkEntity(&world->playerCells, id, cellAt(world, player->ship.position.x, player->ship.position.y));
+    return id;
+}
+
+/* Remove a player from the world */
+void leaveSharedWorld(SharedWorld* world, int playerId) {
+    unlinkEntity(&world->playerCells, playerId);
+    world->players[playerId].active = 0;
+}
+
+/* Queue a command for the player, applied on the next tick */
+void queueSharedCommand(SharedWorld* world, int playerId, char command, int option) {
+    world->players[playerId].command = (char)toupper((unsigned char)command);
+    world->players[playerId].option = option;
+}
+
+/* End a player's game and take their ship out of the world */
+static void endPlayerGame(SharedWorld* world, int playerId, int hasWon) {
+    world->players[playerId].isGameOver = 1;
+    world->players[playerId].hasWon = hasWon;
+    unlinkEntity(&world->playerCells, playerId);
+}
+
+/* Apply a player's queued command */
+static void applyPlayerCommand(SharedWorld* world, int playerId) {
+    SharedPlayer* player = &world->players[playerId];
+    Spaceship* ship = &player->ship;
+    int dx = 0, dy = 0;
+
+    switch (player->command) {
+        case 'W': dy = -1; break;
+        case 'S': dy = 1; break;
+        case 'A': dx = -1; break;
+        case 'D': dx = 1; break;
+        case 'U':
+            /* Use metal to repair or a fuel cell to refuel */
+            if (player->option == 1 && ship->metal > 0) {
+                ship->metal--;
+                ship->health += gameConfig.repairAmount;
+                if (ship->health > ship->maxHealth) ship->health = ship->maxHealth;
+            } else if (player->option == 2 && ship->fuelCells > 0) {
+                ship->fuelCells--;
+                ship->fuel += gameConfig.refuelAmount;
+                if (ship->fuel > ship->maxFuel) ship->fuel = ship->maxFuel;
+            }
+            break;
+        case 'Q':
+            endPlayerGame(world, playerId, 0);
+            break;
+    }
+    player->command = 0;
+
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    /* Move only within the world and never onto obstacles */
+    int newX = ship->position.x + dx;
+    int newY = ship->position.y + dy;
+    if (newX < 0 || newX >= world->worldWidth || newY < 0 || newY >= world->worldHeight ||
+        world->obstacleMap[newY * world->worldWidth + newX]) {
+        return;
+    }
+    ship->position.x = newX;
+    ship->position.y = newY;
+    relinkEntity(&world->playerCells, playerId, cellAt(world, newX, newY));
+
+    /* Consume fuel based on difficulty level */
+    ship->fuel -= gameConfig.fuelConsumption[world->difficulty];
+    if (ship->fuel <= 0) {
+        endPlayerGame(world, playerId, 0);
+    }
+}
+
+/* Give a junk item to the player who won the claim */
+static void awardJunk(SharedWorld* world, int playerId, int index) {
+    SharedPlayer* player = &world->players[playerId];
+    SpaceJunk* junk = &world->junkItems[index];
+
+    player->score += junk->value;
+    switch (junk->type) {
+        case METAL: player->ship.metal++; break;
+        case PLASTIC: player->ship.plastic++; break;
+        case ELECTRONICS: player->ship.electronics++; break;
+        case FUEL_CELL: player->ship.fuelCells++; break;
+    }
+
+    /* Collected junk reappears elsewhere so the shared world never runs dry */
+    spawnJunk(world, index);
+
+    if (player->score >= gameConfig.winScores[world->difficulty]) {
+        endPlayerGame(world, playerId, 1);
+    }
+}
+
+/* Advance the world by one tick */
+void tickSharedWorld(SharedWorld* world) {
+    /* Apply every queued command in player id order */
+    for (int id = 0; id < world->playerCapacity; id++) {
+        SharedPlayer* player = &world->players[id];
+        if (player->active && !player->isGameOver && player->command != 0) {
+            applyPlayerCommand(world, id);
+        }
+    }
+
+    /* Each ship claims the junk under it, only junk in the ship's own cell is checked.
+       When several ships reach the same junk in one tick, the claim with the lowest
+       hash of tick, junk and player wins, so ties do not always favour the same player */
+    int claimed = 0;
+    for (int id = 0; id < world->playerCapacity; id++) {
+        SharedPlayer* player = &world->players[id];
+        if (!player->active || player->isGameOver) continue;
+
+        int x = player->ship.position.x;
+        int y = player->ship.position.y;
+        for (int j = world->junkCells.heads[cellAt(world, x, y)]; j >= 0; j = world->junkCells.next[j]) {
+            SpaceJunk* junk = &world->junkItems[j];
+            if (junk->position.x != x || junk->position.y != y || junk->collected) continue;
+
+            int current = world->junkClaims[j];
+            if (current < 0) {
+                claimed++;
+            }
+            if (current < 0 || mixHash(world->tick, (unsigned int)j, (unsigned int)id) <
+                               mixHash(world->tick, (unsigned int)j, (unsigned int)current)) {
+                world->junkClaims[j] = id;
+            }
+        }
+    }
+
+    /* Award the claimed junk, visiting claims through the ships again to stay local */
+    for (int id = 0; id < world->playerCapacity && claimed > 0; id++) {
+        SharedPlayer* player = &world->players[id];
+        if (!player->active || player->isGameOver) continue;
+
+        int x = player->ship.position.x;
+        int y = player->ship.position.y;
+        for (int j = world->junkCells.heads[cellAt(world, x, y)]; j >= 0; ) {
+            int next = world->junkCells.next[j];
+            if (world->junkClaims[j] >= 0 &&
+                world->junkItems[j].position.x == x && world->junkItems[j].position.y == y) {
+                int winner = world->junkClaims[j];
+                world->junkClaims[j] = -1;
+                claimed--;
+                awardJunk(world, winner, j);
+            }
+            j = next;
+        }
+    }
+
+    /* Move the asteroids, checking only the players in the cell they move into */
+    int speed = gameConfig.asteroidSpeeds[world->difficulty];
+    for (int a = 0; a < world->asteroidCount; a++) {
+        Asteroid* asteroid = &world->asteroids[a];
+        for (int i = 0; i < speed; i++) {
+            stepAsteroid(asteroid, world->worldWidth, world->worldHeight, world->obstacleMap);
+            int cell = cellAt(world, asteroid->position.x, asteroid->position.y);
+            relinkEntity(&world->asteroidCells, a, cell);
+
+            for (int id = world->playerCells.heads[cell]; id >= 0; ) {
+                int next = world->playerCells.next[id];
+                if (world->players[id].ship.position.x == asteroid->position.x &&
+                    world->players[id].ship.position.y == asteroid->position.y) {
+                    endPlayerGame(world, id, 0);
+                }
+                id = next;
+            }
+        }
+    }
+
+    world->tick++;
+}
+
+/* Write the part of the world around the player's ship and the player's status */
+void renderSharedView(SharedWorld* world, int playerId, OutputBuffer* output) {
+    SharedPlayer* player = &world->players[playerId];
+    char view[VIEW_SIZE][VIEW_SIZE];
+
+    /* Center the view on the ship, keeping it inside the world */
+    int left = player->ship.position.x - SHARED_VIEW_RADIUS;
+    int top = player->ship.position.y - SHARED_VIEW_RADIUS;
+    if (left > world->worldWidth - VIEW_SIZE) left = world->worldWidth - VIEW_SIZE;
+    if (top > world->worldHeight - VIEW_SIZE) top = world->worldHeight - VIEW_SIZE;
+    if (left < 0) left = 0;
+    if (top < 0) top = 0;
+    int width = world->worldWidth < VIEW_SIZE ? world->worldWidth : VIEW_SIZE;
+    int height = world->worldHeight < VIEW_SIZE ? world->worldHeight : VIEW_SIZE;
+
+    /* Start with empty space and obstacles */
+    for (int y = 0; y < height; y++) {
+        const unsigned char* row = world->obstacleMap + (size_t)(top + y) * world->worldWidth + left;
+        for (int x = 0; x < width; x++) {
+            view[y][x] = row[x] ? '#' : '.';
+        }
+    }
+
+    /* Draw entities from only the spatial cells that overlap the view */
+    int nearbyPlayers = 0;
+    int firstCellX = left / SHARED_CELL_SIZE, lastCellX = (left + width - 1) / SHARED_CELL_SIZE;
+    int firstCellY = top / SHARED_CELL_SIZE, lastCellY = (top + height - 1) / SHARED_CELL_SIZE;
+    for (int cy = firstCellY; cy <= lastCellY; cy++) {
+        for (int cx = firstCellX; cx <= lastCellX; cx++) {
+            int cell = cy * world->cellsX + cx;
+            for (int j = world->junkCells.heads[cell]; j >= 0; j = world->junkCells.next[j]) {
+                int x = world->junkItems[j].position.x - left, y = world->junkItems[j].position.y - top;
+                if (x >= 0 && x < width && y >= 0 && y < height) view[y][x] = world->junkItems[j].symbol;
+            }
+            for (int id = world->playerCells.heads[cell]; id >= 0; id = world->playerCells.next[id]) {
+                int x = world->players[id].ship.position.x - left, y = world->players[id].ship.position.y - top;
+                if (id != playerId && x >= 0 && x < width && y >= 0 && y < height) {
+                    view[y][x] = OTHER_SHIP_SYMBOL;
+                    nearbyPlayers++;
+                }
+            }
+            for (int a = world->asteroidCells.heads[cell]; a >= 0; a = world->asteroidCells.next[a]) {
+                int x = world->asteroids[a].position.x - left, y = world->asteroids[a].position.y - top;
+                if (x >= 0 && x < width && y >= 0 && y < height) view[y][x] = world->asteroids[a].symbol;
+            }
+        }
+    }
+    view[player->ship.position.y - top][player->ship.position.x - left] = 'S';
+
+    /* Print the x-axis coordinates of the view at the top */
+    appendOutputf(output, "\n   ");
+    for (int x = 0; x < width; x++) {
+        appendOutput(output, &"0123456789"[(left + x) % 10], 1);
+    }
+    appendOutputf(output, "\n");
+
+    /* Print the view with y-axis coordinates */
+    for (int y = 0; y < height; y++) {
+        appendOutputf(output, "%2d ", (top + y) % 100);
+        appendOutput(output, view[y], (size_t)width);
+        appendOutputf(output, "\n");
+    }
+
+    /* Display the player's status and the shared world status */
+    appendOutputf(output, "\nFuel: %d/%d | Health: %d/%d | Score: %d\n",
+                  player->ship.fuel, player->ship.maxFuel,
+                  player->ship.health, player->ship.maxHealth, player->score);
+    appendOutputf(output, "Position: %d,%d | Ships nearby: %d | Tick: %u\n",
+                  player->ship.position.x, player->ship.position.y, nearbyPlayers, world->tick);
+    appendOutputf(output, "\nControls: (W)Up (S)Down (A)Left (D)Right (Q)Quit (U1)Repair (U2)Refuel\n");
+}
@@ -0,0 +1,90 @@
+/**
+ * SpaceXplorer Shared World Header
+ *
+ * This header defines the shared-world mode, where many players fly
+ * their own ships through one world and compete for the same junk.
+ *
+ * The world is partitioned into square spatial cells. Every player,
+ * junk item and asteroid is linked into the list of the cell it is in,
+ * so pickups, asteroid hits and each player's view only look at the
+ * cells around a position instead of at every entity in the world.
+ */
+
+#ifndef SPACEXPLORER_SHARED_WORLD_H
+#define SPACEXPLORER_SHARED_WORLD_H
+
+/* Game structures shared with the single-player mode */
+#include "game.h"
+
+/* Width and height of one spatial cell in world cells */
+#define SHARED_CELL_SIZE 16
+/* Number of world cells visible in every direction around a ship */
+#define SHARED_VIEW_RADIUS 8
+
+/**
+ * Spatial cell lists
+ * Links entities of one kind into per-cell doubly linked lists by index
+ */
+typedef struct {
+    int* heads;     /* First entity in each cell, -1 if the cell is empty */
+    int* next;      /* Next entity in the same cell, -1 at the end */
+    int* prev;      /* Previous entity in the same cell, -1 at the start */
+    int* cell;      /* Cell each entity is linked into, -1 if not linked */
+} CellLists;
+
+/**
+ * Player in the shared world
+ * Each player has their own ship, score and pending command
+ */
+typedef struct {
+    Spaceship ship;                     /* Player's spaceship */
+    int score;                          /* Player's current score */
+    int active;                         /* Flag indicating if this slot is in use */
+    int isGameOver;                     /* Flag indicating if the player's game has ended */
+    int hasWon;                         /* Flag indicating if the player won */
+    char command;                       /* Command to apply on the next tick, 0 for none */
+    int option;                         /* Item number for the (U)se command */
+    char playerName[MAX_NAME_LENGTH];   /* Player's name */
+} SharedPlayer;
+
+/**
+ * Shared world state
+ * One world with its junk, obstacles and asteroids, and all players in it
+ */
+typedef struct {
+    int worldWidth;                     /* Width of the world */
+    int worldHeight;                    /* Height of the world */
+    Difficulty difficulty;              /* Difficulty used for all balance values */
+    unsigned char* obstacleMap;         /* One flag per cell, set where an obstacle is */
+    SpaceJunk* junkItems;               /* Array of collectible items */
+    int junkCount;                      /* Number of junk items */
+    Asteroid* asteroids;                /* Array of moving asteroids */
+    int asteroidCount;                  /* Number of asteroids */
+    SharedPlayer* players;              /* Player slots, indexed by player id */
+    int playerCapacity;                 /* Number of allocated player slots */
+    int cellsX;                         /* Number of spatial cells across */
+    int cellsY;                         /* Number of spatial cells down */
+    CellLists playerCells;              /* Players linked by spatial cell */
+    CellLists junkCells;                /* Junk items linked by spatial cell */
+    CellLists asteroidCells;            /* Asteroids linked by spatial cell */
+    int* junkClaims;                    /* Player claiming each junk item this tick, -1 if none */
+    unsigned int random;                /* State of the world's own random generator */
+    unsigned int tick;                  /* Number of ticks simulated */
+} SharedWorld;
+
+/* Create a shared world using the current settings, returns 1 on success */
+int createSharedWorld(SharedWorld* world, Difficulty difficulty);
+/* Free all memory used by a shared world */
+void destroySharedWorld(SharedWorld* world);
+/* Add a player at a random free position, returns the player id or -1 if the world is full */
+int joinSharedWorld(SharedWorld* world, const char* playerName);
+/* Remove a player from the world */
+void leaveSharedWorld(SharedWorld* world, int playerId);
+/* Queue a command for the player, applied on the next tick */
+void queueSharedCommand(SharedWorld* world, int playerId, char command, int option);
+/* Advance the world by one tick, applying all queued commands */
+void tickSharedWorld(SharedWorld* world);
+/* Write the part of the world around the player's ship and the player's status */
+void renderSharedView(SharedWorld* world, int playerId, OutputBuffer* output);
+
+#endif /* SPACEXPLORER_SHARED_WORLD_H */
@@ -0,0 +1,312 @@
+/**
+ * SpaceXplorer Headless Simulator
+ * Plays scripted games without a console, as fast as the simulation runs,
+ * and reports how many turns per second it managed. The script and the
+ * worlds come from the seed, so two runs play exactly the same games and
+ * their checksums match.
+ *
+ * Usage: spacexplorer_sim [--games N] [--sizes N,N,...] [--difficulty E|M|H]
+ *                         [--asteroids N] [--max-turns N] [--seed N] [--generic] [--render]
+ *                         [--threads N] [--procedural] [--level FILE] [--streaming] [--compact]
+ */
+
+/* Standard input/output functions (printf, fprintf, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (atoi, strtoul, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (strcmp, strtok, etc.) */
+#include <string.h>
+/* Character handling functions (toupper) */
+#include <ctype.h>
+/* Game-specific declarations and structures */
+#include "game.h"
+/* Tunable game settings */
+#include "config.h"
+/* Monotonic clock for the turn rate */
+#include "timing.h"
+/* Number of threads the asteroid field is moved on */
+#include "thread_pool.h"
+/* Worlds read from level files */
+#include "level.h"
+/* Bit-packed copies of a game's board */
+#include "compact_game.h"
+
+/* Largest number of world sizes accepted on the command line */
+#define SIM_MAX_SIZES 16
+/* Fuel left at which the script uses a fuel cell if it has one */
+#define SIM_REFUEL_LEVEL 20
+/* Leaderboard file written by the end of rendered games */
+#define SIM_LEADERBOARD_FILE "spacexplorer_sim_leaderboard.txt"
+/* Bytes of output room per turn beyond the drawn map, for the status lines and messages */
+#define SIM_OUTPUT_SLACK 4096
+
+/**
+ * Totals over all simulated games
+ * The checksum mixes every game's final state
+ */
+typedef struct {
+    long long games;            /* Number of games played */
+    long long turns;            /* Number of commands applied */
+    long long wins;             /* Games won */
+    long long hits;             /* Games lost to an asteroid */
+    long long outOfFuel;        /* Games lost to an empty tank */
+    long long nanos;            /* Time spent applying commands */
+    unsigned long long checksum; /* Hash of the final states */
+} SimTotals;
+
+/* Output of the simulated games, cleared every turn */
+static OutputBuffer simOutput;
+/* Compact state the games are round-tripped through with --compact */
+static CompactGame* simCompact = NULL;
+/* Size of the compact state's block */
+static size_t simCompactBytes = 0;
+
+/* Advance the script's random state and return the next number */
+static unsigned int nextRandom(unsigned int* state) {
+    /* xorshift32, independent of rand() which places the world objects */
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* Pick the script's next command, a random walk that refuels and repairs when it can */
+static char nextCommand(const Game* game, unsigned int* state, int* option) {
+    if (game->ship.fuel <= SIM_REFUEL_LEVEL && game->ship.fuelCells > 0) {
+        *option = 2;
+        return 'U';
+    }
+    if (game->ship.health < game->ship.maxHealth && game->ship.metal > 0) {
+        *option = 1;
+        return 'U';
+    }
+    *option = 0;
+    return "WASD"[nextRandom(state) % 4];
+}
+
+/* Mix a value into the checksum */
+static void mixChecksum(SimTotals* totals, long long value) {
+    totals->checksum = (totals->checksum ^ (unsigned long long)value) * 1099511628211ULL;
+}
+
+/* Pack the board of a game and unpack it again, which leaves it as it was */
+static void repackGame(Game* game) {
+    size_t bytes = packedGameSize(game);
+    if (bytes == 0) {
+        return;
+    }
+    if (bytes > simCompactBytes) {
+        CompactGame* grown = (CompactGame*)realloc(simCompact, bytes);
+        if (grown == NULL) {
+            return;
+        }
+        simCompact = grown;
+        simCompactBytes = bytes;
+    }
+    packGame(game, simCompact);
+    if (!unpackGame(game, simCompact)) {
+        fprintf(stderr, "Out of memory unpacking a compact game\n");
+        exit(1);
+    }
+}
+
+/* Play one game to its end or the turn limit */
+static void playGame(SimTotals* totals, Difficulty difficulty, int seed, int maxTurns, int generic, int render,
+                     int compact) {
+    Game game;
+    memset(&game, 0, sizeof(game));
+    strcpy(game.playerName, "sim");
+    game.difficulty = difficulty;
+    game.output = &simOutput;
+    gameConfig.seed = seed;
+    setupGame(&game);
+    if (generic) {
+        game.moveAsteroids = moveAsteroid;
+    }
+    /* The output of a turn fits without growing, the map's rows with their numbers and line ends plus the text */
+    reserveOutputBuffer(&simOutput, (size_t)(game.worldWidth + 4) * (game.worldHeight + 2) + SIM_OUTPUT_SLACK);
+
+    unsigned int state = (unsigned int)seed * 2654435761u + 1u;
+    int turns = 0;
+    long long start = currentTimeNanos();
+    while (!game.isGameOver && turns < maxTurns) {
+        /* Turns allocate nothing, the game's memory was all taken at setup */
+        ALLOC_CHECK_BEGIN();
+        /* Draw every turn like the console game does */
+        if (render) {
+            renderWorld(&game);
+        }
+        int option = 0;
+        char command = nextCommand(&game, &state, &option);
+        applyCommand(&game, command, option);
+        updateGame(&game);
+        /* Asteroid spawns pick the kernels again */
+        if (generic) {
+            game.moveAsteroids = moveAsteroid;
+        }
+        clearOutputBuffer(&simOutput);
+        ALLOC_CHECK_END("Simulated turn");
+        /* The compact state holds the whole board, so the game plays on the same after the round trip */
+        if (compact) {
+            repackGame(&game);
+            if (generic) {
+                game.moveAsteroids = moveAsteroid;
+            }
+        }
+        turns++;
+    }
+    /* Finish like the console game, saving the score */
+    if (render) {
+        renderEndGameMessage(&game);
+        clearOutputBuffer(&simOutput);
+    }
+    totals->nanos += currentTimeNanos() - start;
+
+    /* Tally how the game ended */
+    totals->games++;
+    totals->turns += turns;
+    if (game.hasWon) {
+        totals->wins++;
+    } else if (game.isGameOver && game.ship.fuel <= 0) {
+        totals->outOfFuel++;
+    } else if (game.isGameOver) {
+        totals->hits++;
+    }
+    mixChecksum(totals, turns);
+    mixChecksum(totals, game.score);
+    mixChecksum(totals, game.ship.fuel);
+    mixChecksum(totals, game.ship.position.x * 65536LL + game.ship.position.y);
+    /* Where the map of a streamed world ended up, which is always 0 otherwise */
+    if (game.sectors != NULL) {
+        mixChecksum(totals, game.originX * 65536LL + game.originY);
+    }
+    /* The field is kept in tile order, so the asteroids are summed by placement number in any order */
+    unsigned long long asteroidSum = 0;
+    for (int a = 0; a < game.asteroids.count; a++) {
+        unsigned long long value = (unsigned long long)game.asteroids.id[a] << 32 |
+                                   (unsigned long long)(game.asteroids.x[a] * 65536LL + game.asteroids.y[a]);
+        asteroidSum += (value ^ value >> 29) * 0xBF58476D1CE4E5B9ULL;
+    }
+    mixChecksum(totals, (long long)asteroidSum);
+    cleanupGame(&game);
+}
+
+/**
+ * Simulator entry point
+ * Plays the requested games on every size and difficulty and prints the rate
+ */
+int main(int argc, char* argv[]) {
+    int games = 200;
+    int sizes[SIM_MAX_SIZES] = {WORLD_MIN_SIZE};
+    int sizeCount = 1;
+    int difficulties[DIFFICULTY_LEVELS] = {EASY, MEDIUM, HARD};
+    int difficultyCount = DIFFICULTY_LEVELS;
+    int asteroids = -1;
+    int maxTurns = 100000;
+    int seed = 1;
+    int generic = 0;
+    int render = 0;
+    int threads = 0;
+    int procedural = 0;
+    int streaming = 0;
+    int compact = 0;
+
+    /* Parse command line options */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+            sizeCount = 0;
+            for (char* item = strtok(argv[++i], ","); item != NULL && sizeCount < SIM_MAX_SIZES;
+                 item = strtok(NULL, ",")) {
+                sizes[sizeCount++] = atoi(item);
+            }
+        } else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) {
+            char choice = (char)toupper((unsigned char)argv[++i][0]);
+            difficulties[0] = choice == 'E' ? EASY : choice == 'H' ? HARD : MEDIUM;
+            difficultyCount = 1;
+        } else if (strcmp(argv[i], "--asteroids") == 0 && i + 1 < argc) {
+            asteroids = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-turns") == 0 && i + 1 < argc) {
+            maxTurns = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--generic") == 0) {
+            /* Always use the scalar moveAsteroid instead of the kernel selectKernels picks, for comparison */
+            generic = 1;
+        } else if (strcmp(argv[i], "--render") == 0) {
+            /* Also draw every turn and the end of every game, saving scores to a scratch leaderboard */
+            render = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            /* Threads the asteroid field is moved on, one per processor by default */
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--procedural") == 0) {
+            /* Shape the worlds from noise instead of scattering obstacles and junk evenly */
+            procedural = 1;
+        } else if (strcmp(argv[i], "--level") == 0 && i + 1 < argc) {
+            /* Play the world of a level file, which sets the world size */
+            LEVEL_FILE = argv[++i];
+            sizeCount = 1;
+        } else if (strcmp(argv[i], "--streaming") == 0) {
+            /* Stream endless worlds, the sizes being the sizes of the map following the ship */
+            streaming = 1;
+        } else if (strcmp(argv[i], "--compact") == 0) {
+            /* Pack every game into its compact state and unpack it again after each turn, the checksum stays the same */
+            compact = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--games N] [--sizes N,N,...] [--difficulty E|M|H]\n"
+                            "       [--asteroids N] [--max-turns N] [--seed N] [--generic] [--render]\n"
+                            "       [--threads N] [--procedural] [--level FILE] [--streaming] [--compact]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (sizeCount == 0 || games < 1) {
+        fprintf(stderr, "Nothing to simulate\n");
+        return 1;
+    }
+
+    setWorkerThreads(threads);
+    LEADERBOARD_FILE = SIM_LEADERBOARD_FILE;
+    initOutputBuffer(&simOutput);
+    SimTotals totals;
+    memset(&totals, 0, sizeof(totals));
+    totals.checksum = 14695981039346656037ULL;
+
+    for (int s = 0; s < sizeCount; s++) {
+        /* Default settings on a square world, asteroids scale with the area unless given */
+        setDefaultConfig(&gameConfig);
+        gameConfig.worldWidth = sizes[s];
+        gameConfig.worldHeight = sizes[s];
+        gameConfig.asteroidCount = asteroids >= 0 ? asteroids : (sizes[s] * sizes[s] / 256 > 1 ? sizes[s] * sizes[s] / 256 : 1);
+        gameConfig.proceduralWorld = procedural;
+        gameConfig.streamingWorld = streaming;
+        /* readLevelSize reports why a level cannot be played */
+        if (LEVEL_FILE != NULL && !readLevelSize(LEVEL_FILE, &gameConfig.worldWidth, &gameConfig.worldHeight)) {
+            return 1;
+        }
+        validateConfig(&gameConfig);
+
+        for (int d = 0; d < difficultyCount; d++) {
+            for (int g = 0; g < games; g++) {
+                playGame(&totals, (Difficulty)difficulties[d], seed + g, maxTurns, generic, render, compact);
+            }
+        }
+    }
+    freeOutputBuffer(&simOutput);
+    free(simCompact);
+    remove(SIM_LEADERBOARD_FILE);
+    threads = workerThreads();
+    stopWorkerThreads();
+
+    double seconds = totals.nanos / 1e9;
+    printf("games:     %lld (%lld won, %lld hit by an asteroid, %lld out of fuel)\n",
+           totals.games, totals.wins, totals.hits, totals.outOfFuel);
+    printf("turns:     %lld in %.3f s\n", totals.turns, seconds);
+    printf("rate:      %.0f turns/s, %.1f ns per turn\n", seconds > 0 ? totals.turns / seconds : 0.0,
+           totals.turns > 0 ? (double)totals.nanos / totals.turns : 0.0);
+    printf("kernels:   %s, %d threads\n", generic ? "generic" : "selected", threads);
+    printf("checksum:  %016llx\n", totals.checksum);
+    return 0;
+}
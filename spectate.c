@@ -0,0 +1,268 @@
+/**
+ * SpaceXplorer Spectator
+ * Watches a shared-world server through the binary state stream, decoding
+ * every frame and acknowledging it, and reports the stream's bandwidth
+ *
+ * Usage: spacexplorer_spectate [--port N] [--spectators N] [--seconds N] [--show]
+ */
+
+/* Standard input/output functions (printf, fprintf, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, etc.) */
+#include <stdlib.h>
+/* String manipulation functions (strcmp, memmove, etc.) */
+#include <string.h>
+/* Error numbers (errno, EAGAIN) */
+#include <errno.h>
+/* File descriptor functions (close) */
+#include <unistd.h>
+/* Socket functions (socket, connect, send, recv) */
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+/* Event notification (epoll_create1, epoll_wait) */
+#include <sys/epoll.h>
+/* Resource limits (setrlimit) */
+#include <sys/resource.h>
+/* State stream decoding */
+#include "state_stream.h"
+/* Server protocol constants */
+#include "server.h"
+/* Monotonic clock for the report interval */
+#include "timing.h"
+
+/* Size of the receive buffer of one spectator */
+#define RECEIVE_BUFFER_SIZE (1024 * 1024)
+
+/**
+ * Simulated spectator
+ * One connection with the world state it decoded so far
+ */
+typedef struct {
+    int fd;                     /* Connected socket, -1 when closed */
+    unsigned char* buffer;      /* Received bytes not yet decoded */
+    size_t buffered;            /* Number of bytes in buffer */
+    StreamSnapshot snapshot;    /* World state decoded from the stream */
+} Spectator;
+
+/* Number of keyframes decoded by all spectators */
+static long long keyframes = 0;
+/* Number of delta frames decoded by all spectators */
+static long long deltas = 0;
+/* Bytes received in keyframes */
+static long long keyframeBytes = 0;
+/* Bytes received in delta frames */
+static long long deltaBytes = 0;
+/* Number of spectators that received a frame they could not apply */
+static int malformed = 0;
+
+/* Open a blocking connection to the spectator port, then switch it to non-blocking */
+static int connectSpectator(Spectator* spectator, int port) {
+    memset(spectator, 0, sizeof(*spectator));
+    spectator->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    spectator->buffer = (unsigned char*)malloc(RECEIVE_BUFFER_SIZE);
+    initSnapshot(&spectator->snapshot);
+    if (spectator->fd < 0 || spectator->buffer == NULL) {
+        return 0;
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(spectator->fd, (struct sockaddr*)&address, sizeof(address)) != 0) {
+        close(spectator->fd);
+        spectator->fd = -1;
+        return 0;
+    }
+    return 1;
+}
+
+/* Close a spectator connection and free its state */
+static void closeSpectator(Spectator* spectator) {
+    if (spectator->fd >= 0) {
+        close(spectator->fd);
+        spectator->fd = -1;
+    }
+    free(spectator->buffer);
+    spectator->buffer = NULL;
+    freeSnapshot(&spectator->snapshot);
+}
+
+/* Decode every complete frame received and acknowledge the last one, returns 0 on a stream error */
+static int decodeFrames(Spectator* spectator) {
+    size_t used = 0;
+    int applied = 0;
+    for (;;) {
+        size_t frameLength = 0;
+        int result = decodeFrame(&spectator->snapshot, spectator->buffer + used,
+                                 spectator->buffered - used, &frameLength);
+        if (result == 0) break;
+        if (result < 0) {
+            malformed++;
+            return 0;
+        }
+
+        /* Count the bandwidth of each frame type */
+        if (spectator->buffer[used] == STREAM_KEYFRAME) {
+            keyframes++;
+            keyframeBytes += (long long)frameLength;
+        } else {
+            deltas++;
+            deltaBytes += (long long)frameLength;
+        }
+        used += frameLength;
+        applied = 1;
+    }
+
+    memmove(spectator->buffer, spectator->buffer + used, spectator->buffered - used);
+    spectator->buffered -= used;
+
+    /* Acknowledge the tick the decoded state is at */
+    if (applied) {
+        unsigned int tick = spectator->snapshot.tick;
+        unsigned char ack[STREAM_ACK_SIZE] = {
+            (unsigned char)tick, (unsigned char)(tick >> 8), (unsigned char)(tick >> 16), (unsigned char)(tick >> 24)
+        };
+        if (send(spectator->fd, ack, sizeof(ack), MSG_NOSIGNAL) != (ssize_t)sizeof(ack)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Read everything available from a spectator connection, returns 0 if it closed */
+static int serviceSpectator(Spectator* spectator) {
+    for (;;) {
+        if (spectator->buffered == RECEIVE_BUFFER_SIZE) {
+            /* A frame larger than the buffer can never be decoded */
+            malformed++;
+            return 0;
+        }
+        ssize_t received = recv(spectator->fd, spectator->buffer + spectator->buffered,
+                                RECEIVE_BUFFER_SIZE - spectator->buffered, MSG_DONTWAIT);
+        if (received > 0) {
+            spectator->buffered += (size_t)received;
+            if (!decodeFrames(spectator)) return 0;
+        } else if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 1;
+        } else if (received < 0 && errno == EINTR) {
+            continue;
+        } else {
+            return 0;
+        }
+    }
+}
+
+/* Print the players in the decoded world of a spectator */
+static void showWorld(const StreamSnapshot* snapshot) {
+    int active = 0;
+    for (int id = 0; id < snapshot->playerCapacity; id++) {
+        active += snapshot->players[id].active;
+    }
+    printf("tick %u, %dx%d world, %d asteroids, %d junk, %d players\n", snapshot->tick,
+           snapshot->worldWidth, snapshot->worldHeight, snapshot->asteroidCount, snapshot->junkCount, active);
+    for (int id = 0, shown = 0; id < snapshot->playerCapacity && shown < 10; id++) {
+        const StreamPlayer* player = &snapshot->players[id];
+        if (!player->active) continue;
+        printf("  %-19s at %d,%d fuel %d health %d score %d%s\n", player->playerName,
+               player->position.x, player->position.y, player->fuel, player->health, player->score,
+               player->flags & STREAM_PLAYER_WON ? " (won)" :
+               player->flags & STREAM_PLAYER_GAME_OVER ? " (game over)" : "");
+        shown++;
+    }
+}
+
+/**
+ * Spectator entry point
+ * Watches the stream with the requested number of connections for a while
+ */
+int main(int argc, char* argv[]) {
+    int port = SERVER_DEFAULT_SPECTATOR_PORT;
+    int spectatorCount = 1;
+    int seconds = 10;
+    int show = 0;
+
+    /* Parse command line options */
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--spectators") == 0 && i + 1 < argc) {
+            spectatorCount = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--show") == 0) {
+            show = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--port N] [--spectators N] [--seconds N] [--show]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (spectatorCount < 1) spectatorCount = 1;
+
+    /* Each spectator needs a descriptor */
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    Spectator* spectators = (Spectator*)calloc((size_t)spectatorCount, sizeof(Spectator));
+    int epollDescriptor = epoll_create1(EPOLL_CLOEXEC);
+    if (spectators == NULL || epollDescriptor < 0) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int i = 0; i < spectatorCount; i++) {
+        if (!connectSpectator(&spectators[i], port)) {
+            fprintf(stderr, "Could not connect to the spectator port %d\n", port);
+            return 1;
+        }
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.ptr = &spectators[i];
+        epoll_ctl(epollDescriptor, EPOLL_CTL_ADD, spectators[i].fd, &event);
+    }
+
+    long long startTime = currentTimeNanos();
+    long long nextReport = startTime + 1000000000LL;
+    long long endTime = startTime + (long long)seconds * 1000000000LL;
+    int connected = spectatorCount;
+    struct epoll_event events[256];
+    while (connected > 0 && currentTimeNanos() < endTime) {
+        int count = epoll_wait(epollDescriptor, events, 256, 100);
+        for (int i = 0; i < count; i++) {
+            Spectator* spectator = (Spectator*)events[i].data.ptr;
+            if (!serviceSpectator(spectator)) {
+                epoll_ctl(epollDescriptor, EPOLL_CTL_DEL, spectator->fd, NULL);
+                close(spectator->fd);
+                spectator->fd = -1;
+                connected--;
+            }
+        }
+
+        if (show && currentTimeNanos() >= nextReport) {
+            showWorld(&spectators[0].snapshot);
+            nextReport += 1000000000LL;
+        }
+    }
+    double elapsed = (currentTimeNanos() - startTime) / 1e9;
+
+    /* Report the bandwidth next to the size of the whole map as text */
+    const StreamSnapshot* world = &spectators[0].snapshot;
+    printf("spectators: %d, %d still connected, %d malformed streams\n", spectatorCount, connected, malformed);
+    printf("keyframes:  %lld, %.0f bytes on average\n", keyframes,
+           keyframes > 0 ? (double)keyframeBytes / keyframes : 0.0);
+    printf("deltas:     %lld, %.1f bytes on average\n", deltas, deltas > 0 ? (double)deltaBytes / deltas : 0.0);
+    printf("bandwidth:  %.1f KB/s per spectator, the map as text is %lld bytes per tick\n",
+           (keyframeBytes + deltaBytes) / elapsed / 1024.0 / spectatorCount,
+           (long long)world->worldWidth * (world->worldHeight + 1));
+
+    for (int i = 0; i < spectatorCount; i++) {
+        closeSpectator(&spectators[i]);
+    }
+    free(spectators);
+    close(epollDescriptor);
+    return malformed > 0 ? 1 : 0;
+}
@@ -0,0 +1,609 @@
+/* Memory allocation functions (malloc, realloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memcpy, memset, strncpy) */
+#include <string.h>
+/* State stream declarations */
+#include "state_stream.h"
+
+/*
+ * Keyframe body:
+ * - tick, world width, world height
+ * - obstacle count, then the gap between successive obstacle cell indices
+ * - asteroid count, then x and y of every asteroid
+ * - junk count, then x, y and a type byte (type, plus 4 if collected) of every item
+ * - player slot count, active player count, then the id and full record of every active player
+ *
+ * Delta body:
+ * - tick, tick of the base snapshot
+ * - moved asteroids: count, then index gap and move of each
+ * - changed junk: count, then index gap, x, y and type byte of each
+ * - player slot count
+ * - players that left: count, then id gap of each
+ * - players that joined: count, then id gap and full record of each, a slot
+ *   taken over by a player of another name between ticks included
+ * - changed players: count, then id gap, a mask of STREAM_FIELD_* bits and the changed fields
+ *
+ * Index gaps count the entries skipped since the previous one in the section, so
+ * small sets of changes in a large world still take a byte per index. A move packs
+ * the zigzag encoded x and y change into the two halves of one byte when both fit.
+ */
+
+/* Player field mask bit, the ship moved */
+#define STREAM_FIELD_POSITION 1
+/* Player field mask bit, the fuel changed */
+#define STREAM_FIELD_FUEL 2
+/* Player field mask bit, the health changed */
+#define STREAM_FIELD_HEALTH 4
+/* Player field mask bit, the score changed */
+#define STREAM_FIELD_SCORE 8
+/* Player field mask bit, the carried items changed */
+#define STREAM_FIELD_ITEMS 16
+/* Player field mask bit, the game over flags changed */
+#define STREAM_FIELD_FLAGS 32
+/* Move byte announcing that both changes follow as varints */
+#define STREAM_LONG_MOVE 0xFF
+/* Largest number of player slots accepted from a stream */
+#define STREAM_MAX_PLAYERS (1 << 20)
+
+/**
+ * Frame body reader
+ * Tracks the read position and whether the body ran out of bytes
+ */
+typedef struct {
+    const unsigned char* data;  /* Body bytes */
+    size_t length;              /* Number of body bytes */
+    size_t position;            /* Number of bytes read */
+    int failed;                 /* Flag set when a read went past the end */
+} StreamReader;
+
+/* Map a signed number to an unsigned one, keeping small magnitudes small */
+static unsigned int zigzag(int value) {
+    return ((unsigned int)value << 1) ^ (value < 0 ? ~0u : 0u);
+}
+
+/* Reverse the zigzag mapping */
+static int unzigzag(unsigned int value) {
+    return (int)(value >> 1) ^ -(int)(value & 1);
+}
+
+/* Append one byte */
+static void putByte(OutputBuffer* output, unsigned int value) {
+    char byte = (char)value;
+    appendOutput(output, &byte, 1);
+}
+
+/* Append an unsigned number as a varint */
+static void putVarint(OutputBuffer* output, unsigned int value) {
+    char bytes[5];
+    size_t count = 0;
+    while (value >= 0x80) {
+        bytes[count++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    bytes[count++] = (char)value;
+    appendOutput(output, bytes, count);
+}
+
+/* Append a position change, packed into one byte when both halves fit */
+static void putMove(OutputBuffer* output, Position from, Position to) {
+    unsigned int dx = zigzag(to.x - from.x);
+    unsigned int dy = zigzag(to.y - from.y);
+    if (dx < 15 && dy < 15) {
+        putByte(output, dx | dy << 4);
+    } else {
+        putByte(output, STREAM_LONG_MOVE);
+        putVarint(output, dx);
+        putVarint(output, dy);
+    }
+}
+
+/* Start a frame, returns the position of its header for finishFrame */
+static size_t startFrame(OutputBuffer* output, char type) {
+    char header[STREAM_HEADER_SIZE] = {type, 0, 0, 0, 0};
+    size_t start = output->length - output->offset;
+    appendOutput(output, header, sizeof(header));
+    return start;
+}
+
+/* Fill in the body length of a frame once the body is written */
+static void finishFrame(OutputBuffer* output, size_t start) {
+    unsigned char* header = (unsigned char*)output->data + output->offset + start;
+    size_t length = output->length - output->offset - start - STREAM_HEADER_SIZE;
+    for (int i = 0; i < 4; i++) {
+        header[1 + i] = (unsigned char)(length >> (8 * i));
+    }
+}
+
+/* Read one byte */
+static unsigned int getByte(StreamReader* reader) {
+    if (reader->position >= reader->length) {
+        reader->failed = 1;
+        return 0;
+    }
+    return reader->data[reader->position++];
+}
+
+/* Read a varint */
+static unsigned int getVarint(StreamReader* reader) {
+    unsigned int value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        unsigned int byte = getByte(reader);
+        value |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    reader->failed = 1;
+    return 0;
+}
+
+/* Read a position change and apply it */
+static void getMove(StreamReader* reader, Position* position) {
+    unsigned int byte = getByte(reader);
+    unsigned int dx, dy;
+    if (byte == STREAM_LONG_MOVE) {
+        dx = getVarint(reader);
+        dy = getVarint(reader);
+    } else {
+        dx = byte & 0x0F;
+        dy = byte >> 4;
+    }
+    position->x += unzigzag(dx);
+    position->y += unzigzag(dy);
+}
+
+/* Check if a junk item differs between two snapshots */
+static int junkChanged(const StreamJunk* before, const StreamJunk* after) {
+    return before->position.x != after->position.x || before->position.y != after->position.y ||
+           before->type != after->type || before->collected != after->collected;
+}
+
+/* Check if a player differs between two snapshots, returns the mask of changed fields */
+static int playerChanges(const StreamPlayer* before, const StreamPlayer* after) {
+    int mask = 0;
+    if (before->position.x != after->position.x || before->position.y != after->position.y) {
+        mask |= STREAM_FIELD_POSITION;
+    }
+    if (before->fuel != after->fuel) mask |= STREAM_FIELD_FUEL;
+    if (before->health != after->health) mask |= STREAM_FIELD_HEALTH;
+    if (before->score != after->score) mask |= STREAM_FIELD_SCORE;
+    if (memcmp(before->items, after->items, sizeof(before->items)) != 0) mask |= STREAM_FIELD_ITEMS;
+    if (before->flags != after->flags) mask |= STREAM_FIELD_FLAGS;
+    return mask;
+}
+
+/* Check if a player slot is taken by a new player in the second snapshot, a slot reused between ticks counts as a join */
+static int playerJoined(const StreamSnapshot* base, const StreamSnapshot* current, int id) {
+    if (!current->players[id].active) return 0;
+    if (id >= base->playerCapacity || !base->players[id].active) return 1;
+    return strcmp(base->players[id].playerName, current->players[id].playerName) != 0;
+}
+
+/* Append the complete record of a player */
+static void putPlayer(OutputBuffer* output, const StreamPlayer* player) {
+    putVarint(output, (unsigned int)player->position.x);
+    putVarint(output, (unsigned int)player->position.y);
+    putVarint(output, zigzag(player->fuel));
+    putVarint(output, zigzag(player->health));
+    putVarint(output, zigzag(player->score));
+    for (int i = 0; i < 4; i++) {
+        putVarint(output, (unsigned int)player->items[i]);
+    }
+    putByte(output, (unsigned int)player->flags);
+    size_t nameLength = strlen(player->playerName);
+    putByte(output, (unsigned int)nameLength);
+    appendOutput(output, player->playerName, nameLength);
+}
+
+/* Read the complete record of a player */
+static void getPlayer(StreamReader* reader, StreamPlayer* player) {
+    memset(player, 0, sizeof(*player));
+    player->active = 1;
+    player->position.x = (int)getVarint(reader);
+    player->position.y = (int)getVarint(reader);
+    player->fuel = unzigzag(getVarint(reader));
+    player->health = unzigzag(getVarint(reader));
+    player->score = unzigzag(getVarint(reader));
+    for (int i = 0; i < 4; i++) {
+        player->items[i] = (int)getVarint(reader);
+    }
+    player->flags = (int)getByte(reader);
+    unsigned int nameLength = getByte(reader);
+    if (nameLength >= MAX_NAME_LENGTH || reader->length - reader->position < nameLength) {
+        reader->failed = 1;
+        return;
+    }
+    memcpy(player->playerName, reader->data + reader->position, nameLength);
+    reader->position += nameLength;
+}
+
+/* Resize the player slots of a snapshot, clearing new slots */
+static int resizePlayers(StreamSnapshot* snapshot, int capacity) {
+    if (capacity == snapshot->playerCapacity) {
+        return 1;
+    }
+    StreamPlayer* players = (StreamPlayer*)realloc(snapshot->players, (size_t)(capacity + 1) * sizeof(StreamPlayer));
+    if (players == NULL) {
+        return 0;
+    }
+    if (capacity > snapshot->playerCapacity) {
+        memset(players + snapshot->playerCapacity, 0,
+               (size_t)(capacity - snapshot->playerCapacity) * sizeof(StreamPlayer));
+    }
+    snapshot->players = players;
+    snapshot->playerCapacity = capacity;
+    return 1;
+}
+
+/* Prepare an empty snapshot */
+void initSnapshot(StreamSnapshot* snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+}
+
+/* Copy the current state of the shared world into a snapshot */
+int captureSnapshot(StreamSnapshot* snapshot, const SharedWorld* world) {
+    /* Obstacles never change after the world is created, so they are copied only once */
+    if (snapshot->obstacleMap == NULL) {
+        size_t cells = (size_t)world->worldWidth * world->worldHeight;
+        snapshot->worldWidth = world->worldWidth;
+        snapshot->worldHeight = world->worldHeight;
+        snapshot->obstacleMap = (unsigned char*)malloc(cells);
+        snapshot->asteroids = (Position*)malloc((size_t)(world->asteroidCount + 1) * sizeof(Position));
+        snapshot->junkItems = (StreamJunk*)malloc((size_t)(world->junkCount + 1) * sizeof(StreamJunk));
+        if (snapshot->obstacleMap == NULL || snapshot->asteroids == NULL || snapshot->junkItems == NULL) {
+            freeSnapshot(snapshot);
+            return 0;
+        }
+        memcpy(snapshot->obstacleMap, world->obstacleMap, cells);
+        snapshot->asteroidCount = world->asteroidCount;
+        snapshot->junkCount = world->junkCount;
+    }
+    if (!resizePlayers(snapshot, world->playerCapacity)) {
+        return 0;
+    }
+
+    snapshot->tick = world->tick;
+    for (int a = 0; a < world->asteroidCount; a++) {
+        snapshot->asteroids[a] = world->asteroids[a].position;
+    }
+    for (int j = 0; j < world->junkCount; j++) {
+        snapshot->junkItems[j].position = world->junkItems[j].position;
+        snapshot->junkItems[j].type = (unsigned char)world->junkItems[j].type;
+        snapshot->junkItems[j].collected = (unsigned char)(world->junkItems[j].collected != 0);
+    }
+    for (int id = 0; id < world->playerCapacity; id++) {
+        const SharedPlayer* source = &world->players[id];
+        StreamPlayer* player = &snapshot->players[id];
+        player->active = source->active;
+        if (!source->active) continue;
+
+        player->position = source->ship.position;
+        player->fuel = source->ship.fuel;
+        player->health = source->ship.health;
+        player->score = source->score;
+        player->items[0] = source->ship.metal;
+        player->items[1] = source->ship.plastic;
+        player->items[2] = source->ship.electronics;
+        player->items[3] = source->ship.fuelCells;
+        player->flags = (source->isGameOver ? STREAM_PLAYER_GAME_OVER : 0) | (source->hasWon ? STREAM_PLAYER_WON : 0);
+        memcpy(player->playerName, source->playerName, MAX_NAME_LENGTH);
+    }
+    return 1;
+}
+
+/* Release the memory used by a snapshot */
+void freeSnapshot(StreamSnapshot* snapshot) {
+    free(snapshot->obstacleMap);
+    free(snapshot->asteroids);
+    free(snapshot->junkItems);
+    free(snapshot->players);
+    initSnapshot(snapshot);
+}
+
+/* Append a keyframe holding the complete snapshot */
+void encodeKeyframe(OutputBuffer* output, const StreamSnapshot* snapshot) {
+    size_t start = startFrame(output, STREAM_KEYFRAME);
+    putVarint(output, snapshot->tick);
+    putVarint(output, (unsigned int)snapshot->worldWidth);
+    putVarint(output, (unsigned int)snapshot->worldHeight);
+
+    /* Obstacles as gaps between their cell indices */
+    size_t cells = (size_t)snapshot->worldWidth * snapshot->worldHeight;
+    unsigned int obstacleCount = 0;
+    for (size_t i = 0; i < cells; i++) {
+        obstacleCount += snapshot->obstacleMap[i];
+    }
+    putVarint(output, obstacleCount);
+    size_t previous = 0;
+    for (size_t i = 0; i < cells; i++) {
+        if (snapshot->obstacleMap[i]) {
+            putVarint(output, (unsigned int)(i - previous));
+            previous = i;
+        }
+    }
+
+    putVarint(output, (unsigned int)snapshot->asteroidCount);
+    for (int a = 0; a < snapshot->asteroidCount; a++) {
+        putVarint(output, (unsigned int)snapshot->asteroids[a].x);
+        putVarint(output, (unsigned int)snapshot->asteroids[a].y);
+    }
+
+    putVarint(output, (unsigned int)snapshot->junkCount);
+    for (int j = 0; j < snapshot->junkCount; j++) {
+        const StreamJunk* junk = &snapshot->junkItems[j];
+        putVarint(output, (unsigned int)junk->position.x);
+        putVarint(output, (unsigned int)junk->position.y);
+        putByte(output, junk->type | (unsigned int)junk->collected << 2);
+    }
+
+    /* Only active players are sent, with their ids */
+    unsigned int activeCount = 0;
+    for (int id = 0; id < snapshot->playerCapacity; id++) {
+        activeCount += snapshot->players[id].active != 0;
+    }
+    putVarint(output, (unsigned int)snapshot->playerCapacity);
+    putVarint(output, activeCount);
+    for (int id = 0; id < snapshot->playerCapacity; id++) {
+        if (snapshot->players[id].active) {
+            putVarint(output, (unsigned int)id);
+            putPlayer(output, &snapshot->players[id]);
+        }
+    }
+    finishFrame(output, start);
+}
+
+/* Append a delta frame turning the base snapshot into the current one */
+void encodeDelta(OutputBuffer* output, const StreamSnapshot* base, const StreamSnapshot* current) {
+    size_t start = startFrame(output, STREAM_DELTA);
+    putVarint(output, current->tick);
+    putVarint(output, base->tick);
+
+    /* Moved asteroids, counted first so the count can lead the section */
+    unsigned int count = 0;
+    for (int a = 0; a < current->asteroidCount; a++) {
+        count += base->asteroids[a].x != current->asteroids[a].x || base->asteroids[a].y != current->asteroids[a].y;
+    }
+    putVarint(output, count);
+    int previous = -1;
+    for (int a = 0; a < current->asteroidCount; a++) {
+        if (base->asteroids[a].x != current->asteroids[a].x || base->asteroids[a].y != current->asteroids[a].y) {
+            putVarint(output, (unsigned int)(a - previous - 1));
+            putMove(output, base->asteroids[a], current->asteroids[a]);
+            previous = a;
+        }
+    }
+
+    /* Collected and respawned junk */
+    count = 0;
+    for (int j = 0; j < current->junkCount; j++) {
+        count += junkChanged(&base->junkItems[j], &current->junkItems[j]);
+    }
+    putVarint(output, count);
+    previous = -1;
+    for (int j = 0; j < current->junkCount; j++) {
+        const StreamJunk* junk = &current->junkItems[j];
+        if (junkChanged(&base->junkItems[j], junk)) {
+            putVarint(output, (unsigned int)(j - previous - 1));
+            putVarint(output, (unsigned int)junk->position.x);
+            putVarint(output, (unsigned int)junk->position.y);
+            putByte(output, junk->type | (unsigned int)junk->collected << 2);
+            previous = j;
+        }
+    }
+
+    /* Players that left, joined or changed; slots past the base capacity count as inactive */
+    putVarint(output, (unsigned int)current->playerCapacity);
+    unsigned int left = 0, joined = 0, changed = 0;
+    for (int id = 0; id < current->playerCapacity; id++) {
+        int wasActive = id < base->playerCapacity && base->players[id].active;
+        int isActive = current->players[id].active;
+        left += wasActive && !isActive;
+        int rejoined = playerJoined(base, current, id);
+        joined += rejoined;
+        changed += !rejoined && wasActive && isActive && playerChanges(&base->players[id], &current->players[id]) != 0;
+    }
+
+    putVarint(output, left);
+    previous = -1;
+    for (int id = 0; id < current->playerCapacity && left > 0; id++) {
+        if (id < base->playerCapacity && base->players[id].active && !current->players[id].active) {
+            putVarint(output, (unsigned int)(id - previous - 1));
+            previous = id;
+        }
+    }
+
+    putVarint(output, joined);
+    previous = -1;
+    for (int id = 0; id < current->playerCapacity && joined > 0; id++) {
+        if (playerJoined(base, current, id)) {
+            putVarint(output, (unsigned int)(id - previous - 1));
+            putPlayer(output, &current->players[id]);
+            previous = id;
+        }
+    }
+
+    putVarint(output, changed);
+    previous = -1;
+    for (int id = 0; id < current->playerCapacity && changed > 0; id++) {
+        if (id >= base->playerCapacity || !base->players[id].active || !current->players[id].active ||
+            playerJoined(base, current, id)) continue;
+        const StreamPlayer* before = &base->players[id];
+        const StreamPlayer* after = &current->players[id];
+        int mask = playerChanges(before, after);
+        if (mask == 0) continue;
+
+        putVarint(output, (unsigned int)(id - previous - 1));
+        putByte(output, (unsigned int)mask);
+        if (mask & STREAM_FIELD_POSITION) putMove(output, before->position, after->position);
+        if (mask & STREAM_FIELD_FUEL) putVarint(output, zigzag(after->fuel - before->fuel));
+        if (mask & STREAM_FIELD_HEALTH) putVarint(output, zigzag(after->health - before->health));
+        if (mask & STREAM_FIELD_SCORE) putVarint(output, zigzag(after->score - before->score));
+        if (mask & STREAM_FIELD_ITEMS) {
+            for (int i = 0; i < 4; i++) {
+                putVarint(output, zigzag(after->items[i] - before->items[i]));
+            }
+        }
+        if (mask & STREAM_FIELD_FLAGS) putByte(output, (unsigned int)after->flags);
+        previous = id;
+    }
+    finishFrame(output, start);
+}
+
+/* Replace the snapshot with the contents of a keyframe body */
+static int decodeKeyframe(StreamSnapshot* snapshot, StreamReader* reader) {
+    unsigned int tick = getVarint(reader);
+    unsigned int width = getVarint(reader);
+    unsigned int height = getVarint(reader);
+    if (reader->failed || width == 0 || height == 0 || width > WORLD_MAX_SIZE || height > WORLD_MAX_SIZE) {
+        return -1;
+    }
+
+    /* Start over from an empty snapshot with the keyframe's sizes */
+    freeSnapshot(snapshot);
+    size_t cells = (size_t)width * height;
+    snapshot->tick = tick;
+    snapshot->worldWidth = (int)width;
+    snapshot->worldHeight = (int)height;
+    snapshot->obstacleMap = (unsigned char*)calloc(cells, 1);
+    if (snapshot->obstacleMap == NULL) {
+        return -1;
+    }
+
+    unsigned int obstacleCount = getVarint(reader);
+    size_t index = 0;
+    for (unsigned int i = 0; i < obstacleCount && !reader->failed; i++) {
+        index += getVarint(reader);
+        if (index >= cells) return -1;
+        snapshot->obstacleMap[index] = 1;
+    }
+
+    unsigned int asteroidCount = getVarint(reader);
+    if (reader->failed || asteroidCount > cells) return -1;
+    snapshot->asteroids = (Position*)malloc((size_t)(asteroidCount + 1) * sizeof(Position));
+    if (snapshot->asteroids == NULL) return -1;
+    snapshot->asteroidCount = (int)asteroidCount;
+    for (unsigned int a = 0; a < asteroidCount; a++) {
+        snapshot->asteroids[a].x = (int)getVarint(reader);
+        snapshot->asteroids[a].y = (int)getVarint(reader);
+    }
+
+    unsigned int junkCount = getVarint(reader);
+    if (reader->failed || junkCount > cells) return -1;
+    snapshot->junkItems = (StreamJunk*)malloc((size_t)(junkCount + 1) * sizeof(StreamJunk));
+    if (snapshot->junkItems == NULL) return -1;
+    snapshot->junkCount = (int)junkCount;
+    for (unsigned int j = 0; j < junkCount; j++) {
+        StreamJunk* junk = &snapshot->junkItems[j];
+        junk->position.x = (int)getVarint(reader);
+        junk->position.y = (int)getVarint(reader);
+        unsigned int type = getByte(reader);
+        junk->type = (unsigned char)(type & 3);
+        junk->collected = (unsigned char)(type >> 2 & 1);
+    }
+
+    unsigned int capacity = getVarint(reader);
+    unsigned int activeCount = getVarint(reader);
+    if (reader->failed || capacity > STREAM_MAX_PLAYERS || activeCount > capacity ||
+        !resizePlayers(snapshot, (int)capacity)) {
+        return -1;
+    }
+    for (unsigned int i = 0; i < activeCount && !reader->failed; i++) {
+        unsigned int id = getVarint(reader);
+        if (id >= capacity) return -1;
+        getPlayer(reader, &snapshot->players[id]);
+    }
+    return reader->failed ? -1 : 1;
+}
+
+/* Apply the contents of a delta body to the snapshot it was encoded against */
+static int decodeDelta(StreamSnapshot* snapshot, StreamReader* reader) {
+    unsigned int tick = getVarint(reader);
+    unsigned int baseTick = getVarint(reader);
+    if (reader->failed || snapshot->obstacleMap == NULL || baseTick != snapshot->tick) {
+        /* A delta is useless without the snapshot it is based on */
+        return -1;
+    }
+
+    unsigned int count = getVarint(reader);
+    int index = -1;
+    for (unsigned int i = 0; i < count && !reader->failed; i++) {
+        index += (int)getVarint(reader) + 1;
+        if (index < 0 || index >= snapshot->asteroidCount) return -1;
+        getMove(reader, &snapshot->asteroids[index]);
+    }
+
+    count = getVarint(reader);
+    index = -1;
+    for (unsigned int i = 0; i < count && !reader->failed; i++) {
+        index += (int)getVarint(reader) + 1;
+        if (index < 0 || index >= snapshot->junkCount) return -1;
+        StreamJunk* junk = &snapshot->junkItems[index];
+        junk->position.x = (int)getVarint(reader);
+        junk->position.y = (int)getVarint(reader);
+        unsigned int type = getByte(reader);
+        junk->type = (unsigned char)(type & 3);
+        junk->collected = (unsigned char)(type >> 2 & 1);
+    }
+
+    unsigned int capacity = getVarint(reader);
+    if (reader->failed || capacity > STREAM_MAX_PLAYERS || !resizePlayers(snapshot, (int)capacity)) {
+        return -1;
+    }
+
+    count = getVarint(reader);
+    index = -1;
+    for (unsigned int i = 0; i < count && !reader->failed; i++) {
+        index += (int)getVarint(reader) + 1;
+        if (index < 0 || index >= snapshot->playerCapacity) return -1;
+        snapshot->players[index].active = 0;
+    }
+
+    count = getVarint(reader);
+    index = -1;
+    for (unsigned int i = 0; i < count && !reader->failed; i++) {
+        index += (int)getVarint(reader) + 1;
+        if (index < 0 || index >= snapshot->playerCapacity) return -1;
+        getPlayer(reader, &snapshot->players[index]);
+    }
+
+    count = getVarint(reader);
+    index = -1;
+    for (unsigned int i = 0; i < count && !reader->failed; i++) {
+        index += (int)getVarint(reader) + 1;
+        if (index < 0 || index >= snapshot->playerCapacity) return -1;
+        StreamPlayer* player = &snapshot->players[index];
+        unsigned int mask = getByte(reader);
+        if (mask & STREAM_FIELD_POSITION) getMove(reader, &player->position);
+        if (mask & STREAM_FIELD_FUEL) player->fuel += unzigzag(getVarint(reader));
+        if (mask & STREAM_FIELD_HEALTH) player->health += unzigzag(getVarint(reader));
+        if (mask & STREAM_FIELD_SCORE) player->score += unzigzag(getVarint(reader));
+        if (mask & STREAM_FIELD_ITEMS) {
+            for (int item = 0; item < 4; item++) {
+                player->items[item] += unzigzag(getVarint(reader));
+            }
+        }
+        if (mask & STREAM_FIELD_FLAGS) player->flags = (int)getByte(reader);
+    }
+
+    snapshot->tick = tick;
+    return reader->failed ? -1 : 1;
+}
+
+/* Apply one frame to a snapshot */
+int decodeFrame(StreamSnapshot* snapshot, const unsigned char* data, size_t length, size_t* frameLength) {
+    if (length < STREAM_HEADER_SIZE) {
+        return 0;
+    }
+    size_t bodyLength = (size_t)data[1] | (size_t)data[2] << 8 | (size_t)data[3] << 16 | (size_t)data[4] << 24;
+    if (length - STREAM_HEADER_SIZE < bodyLength) {
+        return 0;
+    }
+    *frameLength = STREAM_HEADER_SIZE + bodyLength;
+
+    StreamReader reader = {data + STREAM_HEADER_SIZE, bodyLength, 0, 0};
+    switch (data[0]) {
+        case STREAM_KEYFRAME: return decodeKeyframe(snapshot, &reader);
+        case STREAM_DELTA: return decodeDelta(snapshot, &reader);
+        default: return -1;
+    }
+}
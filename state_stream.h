@@ -0,0 +1,99 @@
+/**
+ * SpaceXplorer State Stream Header
+ *
+ * This header defines the compact binary stream that sends the shared
+ * world to spectators. Instead of rendered frames, every tick is sent as
+ * a delta against the previous tick holding only the asteroids and ships
+ * that moved, the junk that was collected or respawned and the player
+ * stats that changed. Keyframes with the complete state are sent
+ * periodically and whenever a spectator has to resynchronize.
+ *
+ * Frame layout:
+ * - Type byte, STREAM_KEYFRAME or STREAM_DELTA
+ * - Length of the body as 4 bytes, least significant byte first
+ * - Body starting with the tick number, see state_stream.c for the sections
+ *
+ * Numbers in the body are varints (7 bits per byte, least significant
+ * group first), signed numbers are zigzag encoded first. Spectators answer
+ * every frame with the 4-byte tick number they applied. Acknowledgements
+ * are only flow control, not a baseline: deltas are always encoded against
+ * the previous tick, and a spectator that falls too far behind has its
+ * unsent frames dropped and starts again from a keyframe.
+ */
+
+#ifndef SPACEXPLORER_STATE_STREAM_H
+#define SPACEXPLORER_STATE_STREAM_H
+
+/* Game structures (Position, MAX_NAME_LENGTH) */
+#include "game.h"
+/* Shared world the snapshots are taken from */
+#include "shared_world.h"
+
+/* Frame type of a complete world state */
+#define STREAM_KEYFRAME 'K'
+/* Frame type of the changes since the previous tick */
+#define STREAM_DELTA 'D'
+/* Size of the frame header, the type byte and the body length */
+#define STREAM_HEADER_SIZE 5
+/* Size of a spectator's acknowledgement */
+#define STREAM_ACK_SIZE 4
+
+/* Player flag set when the player's game has ended */
+#define STREAM_PLAYER_GAME_OVER 1
+/* Player flag set when the player won */
+#define STREAM_PLAYER_WON 2
+
+/**
+ * Junk item as seen by spectators
+ */
+typedef struct {
+    Position position;          /* Location in the world */
+    unsigned char type;         /* JunkType of the item */
+    unsigned char collected;    /* Flag indicating if the item is gone */
+} StreamJunk;
+
+/**
+ * Player as seen by spectators
+ */
+typedef struct {
+    int active;                         /* Flag indicating if this slot is in use */
+    Position position;                  /* Location of the player's ship */
+    int fuel;                           /* Current fuel level */
+    int health;                         /* Current health */
+    int score;                          /* Current score */
+    int items[4];                       /* Metal, plastic, electronics and fuel cells carried */
+    int flags;                          /* STREAM_PLAYER_GAME_OVER and STREAM_PLAYER_WON */
+    char playerName[MAX_NAME_LENGTH];   /* Player's name */
+} StreamPlayer;
+
+/**
+ * World snapshot
+ * Everything spectators see of the shared world at one tick
+ */
+typedef struct {
+    unsigned int tick;              /* Tick the snapshot was taken at */
+    int worldWidth;                 /* Width of the world */
+    int worldHeight;                /* Height of the world */
+    unsigned char* obstacleMap;     /* One flag per cell, set where an obstacle is */
+    Position* asteroids;            /* Asteroid positions */
+    int asteroidCount;              /* Number of asteroids */
+    StreamJunk* junkItems;          /* Junk items */
+    int junkCount;                  /* Number of junk items */
+    StreamPlayer* players;          /* Player slots, indexed by player id */
+    int playerCapacity;             /* Number of player slots */
+} StreamSnapshot;
+
+/* Prepare an empty snapshot */
+void initSnapshot(StreamSnapshot* snapshot);
+/* Copy the current state of the shared world into a snapshot, returns 1 on success */
+int captureSnapshot(StreamSnapshot* snapshot, const SharedWorld* world);
+/* Release the memory used by a snapshot */
+void freeSnapshot(StreamSnapshot* snapshot);
+/* Append a keyframe holding the complete snapshot */
+void encodeKeyframe(OutputBuffer* output, const StreamSnapshot* snapshot);
+/* Append a delta frame turning the base snapshot into the current one */
+void encodeDelta(OutputBuffer* output, const StreamSnapshot* base, const StreamSnapshot* current);
+/* Apply one frame to a snapshot, returns 1 if applied, 0 if more bytes are needed, -1 if malformed */
+int decodeFrame(StreamSnapshot* snapshot, const unsigned char* data, size_t length, size_t* frameLength);
+
+#endif /* SPACEXPLORER_STATE_STREAM_H */
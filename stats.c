@@ -0,0 +1,172 @@
+/* Standard input/output functions (fprintf, fopen, etc.) */
+#include <stdio.h>
+/* Statistics declarations */
+#include "stats.h"
+/* Trace recording of the spans */
+#include "trace.h"
+
+/* Values below this get a bucket each, larger ones share buckets by magnitude */
+#define STATS_LINEAR_LIMIT 16
+/* Number of sub-buckets per power of two, bucket bounds are within 12.5% of a value */
+#define STATS_SUB_BUCKETS 8
+/* Number of buckets in a histogram, enough for any 63-bit value */
+#define STATS_BUCKETS (STATS_LINEAR_LIMIT + (63 - 4 + 1) * STATS_SUB_BUCKETS)
+
+/**
+ * Log-bucketed histogram
+ * Counts values by bucket, keeping the exact maximum and total
+ */
+typedef struct {
+    long long counts[STATS_BUCKETS];    /* Number of values in each bucket */
+    long long count;                    /* Number of values recorded */
+    long long total;                    /* Sum of all values */
+    long long max;                      /* Largest value recorded */
+} Histogram;
+
+/* Recording modes that are on, 0 when the probes record nothing */
+int statsEnabled = 0;
+/* Work counter totals */
+long long statsCounters[STATS_COUNTERS];
+
+/* Duration histogram of every phase */
+static Histogram phaseHistograms[STATS_PHASES];
+/* Names of the phases in reports */
+static const char* phaseNames[STATS_PHASES] = {
+    "turn", "render", "input", "simulate", "update", "moveAsteroid", "checkCollisions",
+    "moveSpaceship", "collectJunk", "waitForEnter", "loadLeaderboard", "saveLeaderboard"
+};
+/* Names of the counters in reports */
+static const char* counterNames[STATS_COUNTERS] = {"asteroid_steps", "collision_checks", "sector_waits"};
+
+/* Find the position of the highest set bit of a value larger than zero */
+static int highestBit(unsigned long long value) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int bit = 0;
+    while (value >>= 1) bit++;
+    return bit;
+#endif
+}
+
+/* Find the bucket a value belongs in */
+static int bucketOf(long long value) {
+    if (value < STATS_LINEAR_LIMIT) {
+        return value < 0 ? 0 : (int)value;
+    }
+    /* Power of two, then the next three bits below the top one */
+    int bit = highestBit((unsigned long long)value);
+    int sub = (int)((unsigned long long)value >> (bit - 3)) & (STATS_SUB_BUCKETS - 1);
+    return STATS_LINEAR_LIMIT + (bit - 4) * STATS_SUB_BUCKETS + sub;
+}
+
+/* Return the smallest value that falls in a bucket */
+static long long bucketLowerBound(int bucket) {
+    if (bucket < STATS_LINEAR_LIMIT) {
+        return bucket;
+    }
+    int bit = (bucket - STATS_LINEAR_LIMIT) / STATS_SUB_BUCKETS + 4;
+    int sub = (bucket - STATS_LINEAR_LIMIT) % STATS_SUB_BUCKETS;
+    return (long long)(STATS_SUB_BUCKETS + sub) << (bit - 3);
+}
+
+/* Estimate a percentile as the upper bound of its bucket, never above the maximum */
+static long long percentile(const Histogram* histogram, double percent) {
+    long long rank = (long long)(percent / 100.0 * (double)histogram->count + 0.5);
+    if (rank < 1) rank = 1;
+    long long seen = 0;
+    for (int bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+        seen += histogram->counts[bucket];
+        if (seen >= rank) {
+            long long upper = bucket + 1 < STATS_BUCKETS ? bucketLowerBound(bucket + 1) - 1 : histogram->max;
+            return upper < histogram->max ? upper : histogram->max;
+        }
+    }
+    return histogram->max;
+}
+
+/* Turn on recording modes, STATS_HISTOGRAMS and/or STATS_TRACE */
+void enableStats(int modes) {
+    statsEnabled |= modes;
+}
+
+/* Record one run of a phase from its start and end times in nanoseconds */
+void recordPhase(StatsPhase phase, long long start, long long end) {
+    if (statsEnabled & STATS_TRACE) {
+        traceSpan(phaseNames[phase], start, end);
+    }
+    if (!(statsEnabled & STATS_HISTOGRAMS)) {
+        return;
+    }
+
+    long long nanos = end - start;
+    Histogram* histogram = &phaseHistograms[phase];
+    histogram->counts[bucketOf(nanos)]++;
+    histogram->count++;
+    histogram->total += nanos;
+    if (nanos > histogram->max) {
+        histogram->max = nanos;
+    }
+}
+
+/* Write every phase's summary and non-empty buckets, and the counters, as JSON */
+static void writeStatsFile(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return;
+    }
+
+    fprintf(file, "{\n  \"unit\": \"ns\",\n  \"phases\": {\n");
+    for (int phase = 0; phase < STATS_PHASES; phase++) {
+        const Histogram* histogram = &phaseHistograms[phase];
+        fprintf(file, "    \"%s\": {\"count\": %lld, \"total\": %lld, \"p50\": %lld, \"p90\": %lld, \"p99\": %lld, "
+                      "\"max\": %lld, \"buckets\": [",
+                phaseNames[phase], histogram->count, histogram->total, percentile(histogram, 50),
+                percentile(histogram, 90), percentile(histogram, 99), histogram->max);
+
+        /* Buckets as [lower bound, count] pairs */
+        int first = 1;
+        for (int bucket = 0; bucket < STATS_BUCKETS; bucket++) {
+            if (histogram->counts[bucket] > 0) {
+                fprintf(file, "%s[%lld, %lld]", first ? "" : ", ", bucketLowerBound(bucket), histogram->counts[bucket]);
+                first = 0;
+            }
+        }
+        fprintf(file, "]}%s\n", phase + 1 < STATS_PHASES ? "," : "");
+    }
+
+    fprintf(file, "  },\n  \"counters\": {");
+    for (int counter = 0; counter < STATS_COUNTERS; counter++) {
+        fprintf(file, "%s\"%s\": %lld", counter > 0 ? ", " : "", counterNames[counter], statsCounters[counter]);
+    }
+    fprintf(file, "}\n}\n");
+    fclose(file);
+}
+
+/* Print the percentiles of every phase to stderr and write the histograms to a file if a path is given */
+void reportStats(const char* path) {
+    fprintf(stderr, "\n%-16s %8s %10s %10s %10s %10s\n", "phase (us)", "count", "p50", "p90", "p99", "max");
+    for (int phase = 0; phase < STATS_PHASES; phase++) {
+        const Histogram* histogram = &phaseHistograms[phase];
+        if (histogram->count == 0) continue;
+        fprintf(stderr, "%-16s %8lld %10.1f %10.1f %10.1f %10.1f\n", phaseNames[phase], histogram->count,
+                percentile(histogram, 50) / 1e3, percentile(histogram, 90) / 1e3,
+                percentile(histogram, 99) / 1e3, histogram->max / 1e3);
+    }
+
+    /* Work per call next to the totals */
+    long long asteroidCalls = phaseHistograms[STATS_MOVE_ASTEROID].count;
+    long long collisionCalls = phaseHistograms[STATS_CHECK_COLLISIONS].count;
+    fprintf(stderr, "asteroid steps:   %lld (%.1f per call)\n", statsCounters[STATS_ASTEROID_STEPS],
+            asteroidCalls > 0 ? (double)statsCounters[STATS_ASTEROID_STEPS] / asteroidCalls : 0.0);
+    fprintf(stderr, "collision checks: %lld (%.1f per call)\n", statsCounters[STATS_COLLISION_CHECKS],
+            collisionCalls > 0 ? (double)statsCounters[STATS_COLLISION_CHECKS] / collisionCalls : 0.0);
+    if (statsCounters[STATS_SECTOR_WAITS] > 0) {
+        fprintf(stderr, "sector waits:     %lld\n", statsCounters[STATS_SECTOR_WAITS]);
+    }
+
+    if (path != NULL) {
+        writeStatsFile(path);
+    }
+}
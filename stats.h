@@ -0,0 +1,75 @@
+/**
+ * SpaceXplorer Statistics Header
+ *
+ * This header defines the optional timing instrumentation of the game
+ * loop. Each phase of a turn and the hot simulation functions record
+ * their duration into a log-bucketed histogram, and counters track how
+ * much work the simulation did. The same probes can also record every
+ * span into a trace for a timeline viewer. When statistics are off,
+ * every probe costs a single predictable branch.
+ */
+
+#ifndef SPACEXPLORER_STATS_H
+#define SPACEXPLORER_STATS_H
+
+/* Monotonic clock used by the probes */
+#include "timing.h"
+
+/**
+ * Timed phases
+ * Each has its own duration histogram
+ */
+typedef enum {
+    STATS_TURN,                 /* One full iteration of the game loop */
+    STATS_RENDER,               /* renderWorld */
+    STATS_INPUT,                /* Waiting for and reading the command in handleInput */
+    STATS_SIMULATE,             /* applyCommand, the simulation of the command */
+    STATS_UPDATE,               /* updateGame and config reloading */
+    STATS_MOVE_ASTEROID,        /* One call of moveAsteroid */
+    STATS_CHECK_COLLISIONS,     /* One call of checkCollisions */
+    STATS_MOVE,                 /* One call of moveSpaceship, including the asteroids and collisions */
+    STATS_COLLECT,              /* One call of collectJunk, including the wait for the player */
+    STATS_WAIT,                 /* Waiting for the player to press Enter */
+    STATS_LOAD_LEADERBOARD,     /* Reading the leaderboard file */
+    STATS_SAVE_LEADERBOARD,     /* Writing the leaderboard file */
+    STATS_PHASES                /* Number of timed phases */
+} StatsPhase;
+
+/**
+ * Work counters
+ * Totals over the whole game
+ */
+typedef enum {
+    STATS_ASTEROID_STEPS,       /* Asteroid steps taken by moveAsteroid */
+    STATS_COLLISION_CHECKS,     /* Junk items tested by checkCollisions */
+    STATS_SECTOR_WAITS,         /* Streamed sectors the map had to wait for */
+    STATS_COUNTERS              /* Number of counters */
+} StatsCounter;
+
+/* Recording mode collecting the duration histograms */
+#define STATS_HISTOGRAMS 1
+/* Recording mode writing every span into the trace */
+#define STATS_TRACE 2
+
+/* Recording modes that are on, 0 when the probes record nothing */
+extern int statsEnabled;
+/* Work counter totals */
+extern long long statsCounters[STATS_COUNTERS];
+
+/* Start a probe, returns the start time or 0 when statistics are off */
+#define STATS_START() (statsEnabled ? currentTimeNanos() : 0)
+/* Finish a probe started with STATS_START and record its span */
+#define STATS_STOP(phase, start) \
+    do { if (statsEnabled) recordPhase((phase), (start), currentTimeNanos()); } while (0)
+/* Add to a work counter */
+#define STATS_COUNT(counter, amount) \
+    do { if (statsEnabled) statsCounters[(counter)] += (amount); } while (0)
+
+/* Turn on recording modes, STATS_HISTOGRAMS and/or STATS_TRACE */
+void enableStats(int modes);
+/* Record one run of a phase from its start and end times in nanoseconds */
+void recordPhase(StatsPhase phase, long long start, long long end);
+/* Print the percentiles of every phase to stderr and write the histograms to a file if a path is given */
+void reportStats(const char* path);
+
+#endif /* SPACEXPLORER_STATS_H */
@@ -0,0 +1,238 @@
+/* Size types (size_t) */
+#include <stddef.h>
+/* Thread pool declarations */
+#include "thread_pool.h"
+
+#ifndef _WIN32
+/* Atomic task ranges the workers take from and steal */
+#include <stdatomic.h>
+/* Worker threads and their wake-up signals */
+#include <pthread.h>
+/* Number of processors (sysconf) */
+#include <unistd.h>
+
+/**
+ * Task numbers a worker still has to run
+ * The next one in the low 32 bits and the end in the high 32 bits, so the
+ * owner taking from the front and a thief taking from the back agree
+ */
+typedef struct {
+    _Atomic unsigned long long range;   /* Packed next and end task numbers */
+    char padding[56];                   /* Keeps each range on a cache line of its own */
+} WorkerRange;
+
+/**
+ * Worker thread pool
+ * The calling thread of runParallel is worker 0, the others are threads of the pool
+ */
+typedef struct {
+    int threads;                    /* Number of workers, including the calling thread */
+    int started;                    /* Number of workers whose threads are running */
+    pthread_t handles[THREAD_POOL_MAX_THREADS]; /* Threads of workers 1 and up */
+    WorkerRange ranges[THREAD_POOL_MAX_THREADS]; /* Task numbers left for each worker */
+    pthread_mutex_t lock;           /* Guards the fields below */
+    pthread_cond_t wake;            /* Signaled when a run starts or the pool stops */
+    pthread_cond_t finished;        /* Signaled when the last worker of a run is done */
+    unsigned long long generation;  /* Number of runs started, workers wake when it changes */
+    unsigned long long startGeneration; /* Runs started before the threads were, so new threads skip them */
+    int busy;                       /* Number of pool threads still working on the current run */
+    int stopping;                   /* Flag telling the threads to exit */
+    ParallelTask task;              /* Task of the current run */
+    void* context;                  /* Context of the current run */
+} ThreadPool;
+
+/* The pool all parallel work runs on */
+static ThreadPool pool = {0, 0, {0}, {{0}}, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+                          PTHREAD_COND_INITIALIZER, 0, 0, 0, 0, NULL, NULL};
+
+/* Pack the next and end task numbers of a range */
+static unsigned long long packRange(unsigned int next, unsigned int end) {
+    return (unsigned long long)end << 32 | next;
+}
+
+/* Take the next task number from the front of a worker's own range, returns -1 if it is empty */
+static int takeTask(WorkerRange* range) {
+    unsigned long long current = atomic_load(&range->range);
+    for (;;) {
+        unsigned int next = (unsigned int)current, end = (unsigned int)(current >> 32);
+        if (next >= end) {
+            return -1;
+        }
+        if (atomic_compare_exchange_weak(&range->range, &current, packRange(next + 1, end))) {
+            return (int)next;
+        }
+    }
+}
+
+/* Move the back half of another worker's range into our own, returns 0 if every range is empty */
+static int stealTasks(int self) {
+    for (int offset = 1; offset < pool.threads; offset++) {
+        WorkerRange* victim = &pool.ranges[(self + offset) % pool.threads];
+        unsigned long long current = atomic_load(&victim->range);
+        for (;;) {
+            unsigned int next = (unsigned int)current, end = (unsigned int)(current >> 32);
+            if (next >= end) {
+                break;
+            }
+            unsigned int split = end - (end - next + 1) / 2;
+            if (atomic_compare_exchange_weak(&victim->range, &current, packRange(next, split))) {
+                atomic_store(&pool.ranges[self].range, packRange(split, end));
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/* Run tasks of the current run until no worker has any left */
+static void workOnRun(int self, ParallelTask task, void* context) {
+    do {
+        int index;
+        while ((index = takeTask(&pool.ranges[self])) >= 0) {
+            task(context, index);
+        }
+    } while (stealTasks(self));
+}
+
+/* Body of a pool thread, waits for runs and works on them until the pool stops */
+static void* workerMain(void* argument) {
+    int self = (int)(size_t)argument;
+    pthread_mutex_lock(&pool.lock);
+    unsigned long long seen = pool.startGeneration;
+    for (;;) {
+        while (pool.generation == seen && !pool.stopping) {
+            pthread_cond_wait(&pool.wake, &pool.lock);
+        }
+        if (pool.stopping) {
+            break;
+        }
+        seen = pool.generation;
+        ParallelTask task = pool.task;
+        void* context = pool.context;
+        pthread_mutex_unlock(&pool.lock);
+
+        workOnRun(self, task, context);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.busy == 0) {
+            pthread_cond_signal(&pool.finished);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/* Start the pool threads for the configured number of workers */
+static void startWorkerThreads(void) {
+    if (pool.threads <= 0) {
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        pool.threads = processors > 0 ? (int)processors : 1;
+    }
+    if (pool.threads > THREAD_POOL_MAX_THREADS) {
+        pool.threads = THREAD_POOL_MAX_THREADS;
+    }
+
+    /* Threads that fail to start leave the pool smaller */
+    pool.stopping = 0;
+    pool.startGeneration = pool.generation;
+    pool.started = 1;
+    while (pool.started < pool.threads &&
+           pthread_create(&pool.handles[pool.started], NULL, workerMain, (void*)(size_t)pool.started) == 0) {
+        pool.started++;
+    }
+    pool.threads = pool.started;
+}
+
+/* Set the number of threads parallel work runs on, 0 for one per processor */
+void setWorkerThreads(int threads) {
+    stopWorkerThreads();
+    pool.threads = threads > 0 ? threads : 0;
+}
+
+/* Number of threads parallel work runs on, including the calling thread */
+int workerThreads(void) {
+    if (pool.started == 0) {
+        startWorkerThreads();
+    }
+    return pool.threads;
+}
+
+/* Run task(context, i) for every i below count, returns once all of them are done */
+void runParallel(int count, ParallelTask task, void* context) {
+    if (pool.started == 0) {
+        startWorkerThreads();
+    }
+
+    /* A single task or worker needs no hand-over to other threads */
+    if (count <= 1 || pool.threads == 1) {
+        for (int i = 0; i < count; i++) {
+            task(context, i);
+        }
+        return;
+    }
+
+    /* Give every worker an even share of the task numbers */
+    for (int w = 0; w < pool.threads; w++) {
+        unsigned int first = (unsigned int)((long long)count * w / pool.threads);
+        unsigned int end = (unsigned int)((long long)count * (w + 1) / pool.threads);
+        atomic_store(&pool.ranges[w].range, packRange(first, end));
+    }
+
+    pthread_mutex_lock(&pool.lock);
+    pool.task = task;
+    pool.context = context;
+    pool.busy = pool.threads - 1;
+    pool.generation++;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    /* The calling thread works as worker 0, then waits for the others */
+    workOnRun(0, task, context);
+    pthread_mutex_lock(&pool.lock);
+    while (pool.busy > 0) {
+        pthread_cond_wait(&pool.finished, &pool.lock);
+    }
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/* Stop the worker threads, the next parallel run starts them again */
+void stopWorkerThreads(void) {
+    if (pool.started == 0) {
+        return;
+    }
+    pthread_mutex_lock(&pool.lock);
+    pool.stopping = 1;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+    for (int w = 1; w < pool.started; w++) {
+        pthread_join(pool.handles[w], NULL);
+    }
+    pool.started = 0;
+}
+
+#else
+
+/* Tasks run on the calling thread where pthreads are not available */
+
+/* Set the number of threads parallel work runs on, only one is supported here */
+void setWorkerThreads(int threads) {
+    (void)threads;
+}
+
+/* Number of threads parallel work runs on */
+int workerThreads(void) {
+    return 1;
+}
+
+/* Run task(context, i) for every i below count on the calling thread */
+void runParallel(int count, ParallelTask task, void* context) {
+    for (int i = 0; i < count; i++) {
+        task(context, i);
+    }
+}
+
+/* Nothing to stop without worker threads */
+void stopWorkerThreads(void) {
+}
+
+#endif
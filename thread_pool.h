@@ -0,0 +1,30 @@
+/**
+ * SpaceXplorer Thread Pool Header
+ *
+ * This header defines a pool of worker threads that runs a numbered set
+ * of tasks in parallel. Each worker starts with an even share of the task
+ * numbers and takes them from the front, and a worker that runs out steals
+ * the back half of another worker's share, so uneven tasks stay balanced.
+ * Which thread runs a task is not fixed, so tasks must only write to data
+ * of their own.
+ */
+
+#ifndef SPACEXPLORER_THREAD_POOL_H
+#define SPACEXPLORER_THREAD_POOL_H
+
+/* Largest number of threads the pool runs */
+#define THREAD_POOL_MAX_THREADS 256
+
+/* Task run by the pool, index is the task number */
+typedef void (*ParallelTask)(void* context, int index);
+
+/* Set the number of threads parallel work runs on, 0 for one per processor */
+void setWorkerThreads(int threads);
+/* Number of threads parallel work runs on, including the calling thread */
+int workerThreads(void);
+/* Run task(context, i) for every i below count, returns once all of them are done */
+void runParallel(int count, ParallelTask task, void* context);
+/* Stop the worker threads, the next parallel run starts them again */
+void stopWorkerThreads(void);
+
+#endif /* SPACEXPLORER_THREAD_POOL_H */
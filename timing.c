@@ -0,0 +1,16 @@
+/* Time functions (clock_gettime, timespec_get) */
+#include <time.h>
+/* Timing declarations */
+#include "timing.h"
+
+/* Read a monotonic clock in nanoseconds */
+long long currentTimeNanos(void) {
+    struct timespec now;
+#if defined(CLOCK_MONOTONIC)
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#else
+    /* Fall back to the standard C11 wall clock where no monotonic clock exists */
+    timespec_get(&now, TIME_UTC);
+#endif
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
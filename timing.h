@@ -0,0 +1,14 @@
+/**
+ * SpaceXplorer Timing Header
+ *
+ * This header defines the clock used to measure how long parts
+ * of the game take to run.
+ */
+
+#ifndef SPACEXPLORER_TIMING_H
+#define SPACEXPLORER_TIMING_H
+
+/* Read a monotonic clock in nanoseconds */
+long long currentTimeNanos(void);
+
+#endif /* SPACEXPLORER_TIMING_H */
@@ -0,0 +1,115 @@
+/* Standard input/output functions (fprintf, fopen, etc.) */
+#include <stdio.h>
+/* Memory allocation functions (malloc, free, etc.) */
+#include <stdlib.h>
+/* Atomic operations for registering the rings without a lock */
+#include <stdatomic.h>
+/* Trace declarations */
+#include "trace.h"
+/* Monotonic clock the spans are measured with */
+#include "timing.h"
+
+/**
+ * Recorded span
+ * Times are from the monotonic clock in nanoseconds
+ */
+typedef struct {
+    const char* name;   /* Name shown on the timeline */
+    long long start;    /* Time the span began */
+    long long end;      /* Time the span ended */
+} TraceEvent;
+
+/**
+ * Span ring of one thread
+ * Only its own thread writes to it, the rings are chained for writing the file
+ */
+typedef struct TraceRing {
+    TraceEvent events[TRACE_RING_EVENTS];   /* Recorded spans, indexed by count modulo the size */
+    unsigned long long written;             /* Number of spans recorded, including overwritten ones */
+    int threadId;                           /* Thread id shown on the timeline */
+    struct TraceRing* next;                 /* Ring of the thread registered before this one */
+} TraceRing;
+
+/* Most recently registered ring, the head of the chain of all rings */
+static _Atomic(TraceRing*) traceRings = NULL;
+/* Last thread id handed out */
+static atomic_int lastThreadId = 0;
+/* Ring of the calling thread, NULL until it records its first span */
+static _Thread_local TraceRing* threadRing = NULL;
+/* Time the trace started, the zero of the timeline */
+static long long traceOrigin = 0;
+
+/* Give the calling thread a ring and add it to the chain, returns NULL if out of memory */
+static TraceRing* registerRing(void) {
+    TraceRing* ring = (TraceRing*)malloc(sizeof(TraceRing));
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->written = 0;
+    ring->threadId = atomic_fetch_add(&lastThreadId, 1) + 1;
+
+    /* Push onto the chain, retrying if another thread registered in between */
+    TraceRing* head = atomic_load(&traceRings);
+    do {
+        ring->next = head;
+    } while (!atomic_compare_exchange_weak(&traceRings, &head, ring));
+
+    threadRing = ring;
+    return ring;
+}
+
+/* Start a trace, giving the calling thread its ring, returns 0 if out of memory */
+int startTrace(void) {
+    traceOrigin = currentTimeNanos();
+    return threadRing != NULL || registerRing() != NULL;
+}
+
+/* Record a span of the calling thread, the name must stay valid until the trace is written */
+void traceSpan(const char* name, long long start, long long end) {
+    TraceRing* ring = threadRing;
+    if (ring == NULL && (ring = registerRing()) == NULL) {
+        return;
+    }
+    TraceEvent* event = &ring->events[ring->written % TRACE_RING_EVENTS];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    ring->written++;
+}
+
+/* Write the spans of every thread to a trace-event JSON file, once the other threads are done */
+int writeTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        return 0;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n");
+    fprintf(file, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"spaceXplorer\"}}");
+    unsigned long long dropped = 0;
+    for (TraceRing* ring = atomic_load(&traceRings); ring != NULL; ring = ring->next) {
+        /* Oldest span still in the ring first */
+        unsigned long long first = 0;
+        if (ring->written > TRACE_RING_EVENTS) {
+            first = ring->written - TRACE_RING_EVENTS;
+            dropped += first;
+        }
+
+        /* Each span is one complete event, with its begin time and duration in microseconds */
+        for (unsigned long long i = first; i < ring->written; i++) {
+            const TraceEvent* event = &ring->events[i % TRACE_RING_EVENTS];
+            fprintf(file, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %d}",
+                    event->name, (event->start - traceOrigin) / 1e3, (event->end - event->start) / 1e3,
+                    ring->threadId);
+        }
+    }
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    if (dropped > 0) {
+        fprintf(stderr, "Trace: %llu oldest spans were overwritten, the trace keeps %d per thread\n",
+                dropped, TRACE_RING_EVENTS);
+    }
+    return 1;
+}
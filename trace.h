@@ -0,0 +1,24 @@
+/**
+ * SpaceXplorer Trace Header
+ *
+ * This header defines the recording of timed spans for a timeline
+ * viewer. Every thread writes its spans into its own fixed ring, so
+ * recording takes no lock and never allocates after the first span,
+ * and the rings are written out in the Chrome trace-event format that
+ * chrome://tracing and Perfetto open.
+ */
+
+#ifndef SPACEXPLORER_TRACE_H
+#define SPACEXPLORER_TRACE_H
+
+/* Number of spans kept per thread, older ones are overwritten once a ring is full */
+#define TRACE_RING_EVENTS 65536
+
+/* Start a trace, giving the calling thread its ring, returns 0 if out of memory */
+int startTrace(void);
+/* Record a span of the calling thread, the name must stay valid until the trace is written */
+void traceSpan(const char* name, long long start, long long end);
+/* Write the spans of every thread to a trace-event JSON file, once the other threads are done */
+int writeTrace(const char* path);
+
+#endif /* SPACEXPLORER_TRACE_H */
@@ -0,0 +1,395 @@
+/* Memory allocation functions (malloc, realloc, free) */
+#include <stdlib.h>
+/* String manipulation functions (memcpy) */
+#include <string.h>
+/* World generator declarations */
+#include "worldgen.h"
+/* Worker threads the chunks are generated on */
+#include "thread_pool.h"
+
+/* Rows generated by one task */
+#define WORLDGEN_CHUNK_ROWS 64
+/* Lattice spacing of the belt field, as a power of two */
+#define WORLDGEN_BELT_SHIFT 6
+/* Lattice spacing of the detail added to the belt field */
+#define WORLDGEN_DETAIL_SHIFT 4
+/* Lattice spacing of the junk cluster field */
+#define WORLDGEN_CLUSTER_SHIFT 5
+/* Lattice spacing of the void field */
+#define WORLDGEN_VOID_SHIFT 7
+/* Void field value below which a cell is empty space, about a fifth of the world */
+#define WORLDGEN_VOID_LEVEL 20000
+/* Cluster field value above which junk gathers */
+#define WORLDGEN_CLUSTER_LEVEL 36000
+/* Weight of every open cell, so a few obstacles and junk items are scattered outside belts and clusters */
+#define WORLDGEN_BASE_WEIGHT 256
+/* Highest weight a belt or a cluster adds to a cell */
+#define WORLDGEN_MAX_WEIGHT 4096
+/* Largest factor turning a weight into a 32-bit threshold, a cell of the highest weight is then always filled */
+#define WORLDGEN_MAX_SCALE (0xFFFFFFFFu / (WORLDGEN_BASE_WEIGHT + WORLDGEN_MAX_WEIGHT))
+/* Most cells sampled to estimate the total weight of a world */
+#define WORLDGEN_MAX_SAMPLES 262144
+
+/* Seeds of the noise fields are the world seed mixed with a constant of their own */
+#define WORLDGEN_BELT_SALT 0x68E31DA4u
+#define WORLDGEN_DETAIL_SALT 0xB5297A4Du
+#define WORLDGEN_CLUSTER_SALT 0x1B56C4E9u
+#define WORLDGEN_VOID_SALT 0x9E3779B9u
+#define WORLDGEN_SAMPLE_SALT 0x27D4EB2Fu
+
+/*
+ * The row kernels are compiled for the x86-64 feature levels with AVX2 and
+ * AVX-512 and the highest one the processor supports is picked when the
+ * program loads. They only use integers, so every version gives the same world.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define WORLDGEN_KERNEL_CLONES __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default")))
+#else
+#define WORLDGEN_KERNEL_CLONES
+#endif
+
+/**
+ * Cells placed by one chunk of rows
+ * Joined into the generated world in chunk order
+ */
+typedef struct {
+    GeneratedCell* obstacles;   /* Obstacles of the chunk */
+    int obstacleCount;          /* Number of obstacles */
+    int obstacleCapacity;       /* Room in the obstacle list */
+    GeneratedCell* junk;        /* Junk of the chunk */
+    int junkCount;              /* Number of junk items */
+    int junkCapacity;           /* Room in the junk list */
+    int failed;                 /* Flag set if the chunk ran out of memory */
+} WorldChunk;
+
+/**
+ * Generation shared by the chunk tasks
+ * Each task only writes to its own chunk
+ */
+typedef struct {
+    char** world;               /* World rows, only '.' cells are used */
+    int width;                  /* Width of the world */
+    int height;                 /* Height of the world */
+    unsigned int seed;          /* World seed */
+    unsigned int obstacleScale; /* Factor turning an obstacle weight into a threshold of the cell's random number */
+    unsigned int junkScale;     /* Factor turning a junk weight into a threshold */
+    WorldChunk* chunks;         /* Results of each chunk */
+} WorldGenJob;
+
+/* Scramble the bits of a 32-bit value */
+static inline unsigned int mixBits(unsigned int value) {
+    value ^= value >> 16;
+    value *= 0x7FEB352Du;
+    value ^= value >> 15;
+    value *= 0x846CA68Bu;
+    value ^= value >> 16;
+    return value;
+}
+
+/* Key of a row, mixed with a column to get the random number of a cell */
+static inline unsigned int rowKey(unsigned int seed, int y) {
+    return mixBits(seed ^ ((unsigned int)y * 0x85EBCA77u));
+}
+
+/* Random number of a cell from the key of its row */
+static inline unsigned int cellHash(unsigned int key, int x) {
+    return mixBits(key ^ ((unsigned int)x * 0x9E3779B1u));
+}
+
+/* Value of a noise field's lattice point, 0 to 65535 */
+static inline int latticeValue(unsigned int seed, int x, int y) {
+    return (int)(cellHash(rowKey(seed, y), x) >> 16);
+}
+
+/* Smoothstep of a position inside a lattice cell, 0 to the lattice spacing */
+static inline int fade(int offset, int shift) {
+    int size = 1 << shift;
+    return (offset * offset * (3 * size - 2 * offset)) >> (2 * shift);
+}
+
+/* Value of a lattice column between the rows of two row keys, wy along the way from the top one */
+static inline int latticeMix(unsigned int top, unsigned int bottom, int x, int wy, int shift) {
+    int upper = (int)(cellHash(top, x) >> 16);
+    int lower = (int)(cellHash(bottom, x) >> 16);
+    return upper + (((lower - upper) * wy) >> shift);
+}
+
+/* Value of a noise field at a cell, 0 to 65535, the same arithmetic as fillNoiseRow */
+static int noiseAt(unsigned int seed, int shift, int x, int y) {
+    int size = 1 << shift;
+    int gx = x >> shift;
+    int gy = y >> shift;
+    int wx = fade(x & (size - 1), shift);
+    int wy = fade(y & (size - 1), shift);
+    int left = latticeValue(seed, gx, gy) + (((latticeValue(seed, gx, gy + 1) - latticeValue(seed, gx, gy)) * wy) >> shift);
+    int right = latticeValue(seed, gx + 1, gy) + (((latticeValue(seed, gx + 1, gy + 1) - latticeValue(seed, gx + 1, gy)) * wy) >> shift);
+    return left + (((right - left) * wx) >> shift);
+}
+
+/* Values of a noise field along a row, interpolated between the lattice points on either side of each span */
+WORLDGEN_KERNEL_CLONES
+static void fillNoiseRow(int* restrict row, int width, unsigned int seed, int shift, int y) {
+    int size = 1 << shift;
+    int gy = y >> shift;
+    int wy = fade(y & (size - 1), shift);
+    unsigned int top = rowKey(seed, gy);
+    unsigned int bottom = rowKey(seed, gy + 1);
+    int right = latticeMix(top, bottom, 0, wy, shift);
+    for (int gx = 0; gx * size < width; gx++) {
+        int left = right;
+        right = latticeMix(top, bottom, gx + 1, wy, shift);
+        int start = gx * size;
+        int count = width - start < size ? width - start : size;
+        for (int i = 0; i < count; i++) {
+            row[start + i] = left + (((right - left) * fade(i, shift)) >> shift);
+        }
+    }
+}
+
+/* Weight of a cell for obstacles, highest along the ridges where the belt field crosses its middle value */
+static inline int beltWeight(int belt, int detail) {
+    int value = (3 * belt + detail) >> 2;
+    int distance = value > 32768 ? value - 32768 : 32768 - value;
+    int weight = WORLDGEN_MAX_WEIGHT - (distance >> 1);
+    return weight > 0 ? weight : 0;
+}
+
+/* Weight of a cell for junk, highest where the cluster field peaks */
+static inline int clusterWeight(int cluster) {
+    int weight = (cluster - WORLDGEN_CLUSTER_LEVEL) >> 2;
+    weight = weight > 0 ? weight : 0;
+    return weight < WORLDGEN_MAX_WEIGHT ? weight : WORLDGEN_MAX_WEIGHT;
+}
+
+/*
+ * Decide the content of each cell of a row from its noise values: 1 for an
+ * obstacle, 2 for junk and 0 for empty space. A cell is an obstacle if its
+ * random number falls below the obstacle threshold and junk if it falls
+ * in the junk range just above, so the two never share a cell. Where both
+ * are likely the junk range is cut short at the top of the 32-bit range.
+ */
+WORLDGEN_KERNEL_CLONES
+static void classifyRow(unsigned char* restrict kinds, const int* restrict belt, const int* restrict detail,
+                        const int* restrict cluster, const int* restrict voids, int width, unsigned int key,
+                        unsigned int obstacleScale, unsigned int junkScale) {
+    for (int x = 0; x < width; x++) {
+        int open = voids[x] >= WORLDGEN_VOID_LEVEL;
+        unsigned int obstacleWeight = open ? (unsigned int)(WORLDGEN_BASE_WEIGHT + beltWeight(belt[x], detail[x])) : 0u;
+        unsigned int junkWeight = open ? (unsigned int)(WORLDGEN_BASE_WEIGHT + clusterWeight(cluster[x])) : 0u;
+        unsigned int random = cellHash(key, x);
+        unsigned int obstacleLimit = obstacleWeight * obstacleScale;
+        unsigned int junkRange = junkWeight * junkScale;
+        unsigned int junkLimit = obstacleLimit + (junkRange < ~obstacleLimit ? junkRange : ~obstacleLimit);
+        kinds[x] = (unsigned char)(random < obstacleLimit ? 1 : random < junkLimit ? 2 : 0);
+    }
+}
+
+/* Pick a junk type for a cell, metal is found along belts and electronics in dense clusters */
+static int junkTypeAt(unsigned int random, int beltWeight, int clusterWeight) {
+    int weights[4];
+    weights[0] = 64 + beltWeight / 32;      /* Metal */
+    weights[1] = 96;                        /* Plastic */
+    weights[2] = 32 + clusterWeight / 16;   /* Electronics */
+    weights[3] = 48;                        /* Fuel cell */
+    int pick = (int)(mixBits(random) % (unsigned int)(weights[0] + weights[1] + weights[2] + weights[3]));
+    int type = 0;
+    while (pick >= weights[type]) {
+        pick -= weights[type];
+        type++;
+    }
+    return type;
+}
+
+/* Add a cell to a list, doubling it when full, returns 0 if out of memory */
+static int appendCell(GeneratedCell** cells, int* count, int* capacity, int x, int y, int type) {
+    if (*count == *capacity) {
+        int grown = *capacity > 0 ? *capacity * 2 : 256;
+        GeneratedCell* resized = (GeneratedCell*)realloc(*cells, (size_t)grown * sizeof(GeneratedCell));
+        if (resized == NULL) {
+            return 0;
+        }
+        *cells = resized;
+        *capacity = grown;
+    }
+    (*cells)[*count].x = x;
+    (*cells)[*count].y = y;
+    (*cells)[*count].type = type;
+    (*count)++;
+    return 1;
+}
+
+/* Generate the rows of one chunk */
+static void generateChunkTask(void* context, int index) {
+    WorldGenJob* job = (WorldGenJob*)context;
+    WorldChunk* chunk = &job->chunks[index];
+    int width = job->width;
+
+    /* Noise rows of the four fields and the content of each cell */
+    int* rows = (int*)malloc((size_t)width * 4 * sizeof(int));
+    unsigned char* kinds = (unsigned char*)malloc((size_t)width + sizeof(unsigned long long));
+    if (rows == NULL || kinds == NULL) {
+        chunk->failed = 1;
+        free(rows);
+        free(kinds);
+        return;
+    }
+    int* belt = rows;
+    int* detail = rows + width;
+    int* cluster = rows + 2 * width;
+    int* voids = rows + 3 * width;
+
+    int last = (index + 1) * WORLDGEN_CHUNK_ROWS < job->height ? (index + 1) * WORLDGEN_CHUNK_ROWS : job->height;
+    for (int y = index * WORLDGEN_CHUNK_ROWS; y < last && !chunk->failed; y++) {
+        fillNoiseRow(belt, width, job->seed ^ WORLDGEN_BELT_SALT, WORLDGEN_BELT_SHIFT, y);
+        fillNoiseRow(detail, width, job->seed ^ WORLDGEN_DETAIL_SALT, WORLDGEN_DETAIL_SHIFT, y);
+        fillNoiseRow(cluster, width, job->seed ^ WORLDGEN_CLUSTER_SALT, WORLDGEN_CLUSTER_SHIFT, y);
+        fillNoiseRow(voids, width, job->seed ^ WORLDGEN_VOID_SALT, WORLDGEN_VOID_SHIFT, y);
+        unsigned int key = rowKey(job->seed, y);
+        classifyRow(kinds, belt, detail, cluster, voids, width, key, job->obstacleScale, job->junkScale);
+
+        /* Most cells are empty, so the row is skipped eight cells at a time */
+        memset(kinds + width, 0, sizeof(unsigned long long));
+        const char* cells = job->world[y];
+        for (int x = 0; x < width; x += 8) {
+            unsigned long long eight;
+            memcpy(&eight, kinds + x, sizeof(eight));
+            if (eight == 0) {
+                continue;
+            }
+            int end = x + 8 < width ? x + 8 : width;
+            for (int i = x; i < end; i++) {
+                if (kinds[i] == 0 || cells[i] != '.') {
+                    continue;
+                }
+                int ok;
+                if (kinds[i] == 1) {
+                    ok = appendCell(&chunk->obstacles, &chunk->obstacleCount, &chunk->obstacleCapacity, i, y, 0);
+                } else {
+                    int type = junkTypeAt(cellHash(key, i), beltWeight(belt[i], detail[i]), clusterWeight(cluster[i]));
+                    ok = appendCell(&chunk->junk, &chunk->junkCount, &chunk->junkCapacity, i, y, type);
+                }
+                if (!ok) {
+                    chunk->failed = 1;
+                    break;
+                }
+            }
+        }
+    }
+    free(rows);
+    free(kinds);
+}
+
+/* Factor turning the weights of a world into thresholds that place about the wanted number of cells */
+static unsigned int weightScale(unsigned long long totalWeight, int wanted) {
+    if (totalWeight == 0 || wanted <= 0) {
+        return 0;
+    }
+    unsigned long long scale = ((unsigned long long)wanted << 32) / totalWeight;
+    return scale < WORLDGEN_MAX_SCALE ? (unsigned int)scale : WORLDGEN_MAX_SCALE;
+}
+
+/* Estimate the total obstacle and junk weight of a world from one sample cell in each square of a grid */
+static void measureWeights(unsigned int seed, int width, int height, unsigned long long* obstacleWeight,
+                           unsigned long long* junkWeight) {
+    int step = 1;
+    while ((long long)(width / step + 1) * (height / step + 1) > WORLDGEN_MAX_SAMPLES) {
+        step *= 2;
+    }
+    *obstacleWeight = 0;
+    *junkWeight = 0;
+    for (int y = 0; y < height; y += step) {
+        int rows = height - y < step ? height - y : step;
+        unsigned int key = rowKey(seed ^ WORLDGEN_SAMPLE_SALT, y);
+        for (int x = 0; x < width; x += step) {
+            int columns = width - x < step ? width - x : step;
+
+            /* The sample is placed at random in its square, the lattice points alone would not show the spread of the fields */
+            unsigned int random = cellHash(key, x);
+            int sampleX = x + (int)(random % (unsigned int)columns);
+            int sampleY = y + (int)((random >> 16) % (unsigned int)rows);
+            if (noiseAt(seed ^ WORLDGEN_VOID_SALT, WORLDGEN_VOID_SHIFT, sampleX, sampleY) < WORLDGEN_VOID_LEVEL) {
+                continue;
+            }
+            int belt = noiseAt(seed ^ WORLDGEN_BELT_SALT, WORLDGEN_BELT_SHIFT, sampleX, sampleY);
+            int detail = noiseAt(seed ^ WORLDGEN_DETAIL_SALT, WORLDGEN_DETAIL_SHIFT, sampleX, sampleY);
+            int cluster = noiseAt(seed ^ WORLDGEN_CLUSTER_SALT, WORLDGEN_CLUSTER_SHIFT, sampleX, sampleY);
+            unsigned long long area = (unsigned long long)rows * columns;
+            *obstacleWeight += (unsigned long long)(WORLDGEN_BASE_WEIGHT + beltWeight(belt, detail)) * area;
+            *junkWeight += (unsigned long long)(WORLDGEN_BASE_WEIGHT + clusterWeight(cluster)) * area;
+        }
+    }
+}
+
+/* Join the lists of the chunks in row order */
+static GeneratedCell* joinChunks(WorldChunk* chunks, int count, int obstacles, int* total) {
+    *total = 0;
+    for (int c = 0; c < count; c++) {
+        *total += obstacles ? chunks[c].obstacleCount : chunks[c].junkCount;
+    }
+    GeneratedCell* cells = (GeneratedCell*)malloc(((size_t)*total + 1) * sizeof(GeneratedCell));
+    if (cells == NULL) {
+        return NULL;
+    }
+    int next = 0;
+    for (int c = 0; c < count; c++) {
+        int length = obstacles ? chunks[c].obstacleCount : chunks[c].junkCount;
+        if (length > 0) {
+            memcpy(cells + next, obstacles ? chunks[c].obstacles : chunks[c].junk, (size_t)length * sizeof(GeneratedCell));
+            next += length;
+        }
+    }
+    return cells;
+}
+
+/* Generate obstacles and junk for a world, about the given number of each */
+int generateWorld(GeneratedWorld* generated, char** world, int width, int height, unsigned int seed,
+                  int obstacles, int junk) {
+    memset(generated, 0, sizeof(*generated));
+
+    /* Scale the weights so the whole world expects the wanted counts */
+    unsigned long long obstacleWeight;
+    unsigned long long junkWeight;
+    measureWeights(seed, width, height, &obstacleWeight, &junkWeight);
+
+    WorldGenJob job;
+    job.world = world;
+    job.width = width;
+    job.height = height;
+    job.seed = seed;
+    job.obstacleScale = weightScale(obstacleWeight, obstacles);
+    job.junkScale = weightScale(junkWeight, junk);
+    int chunkCount = height > 0 ? (height + WORLDGEN_CHUNK_ROWS - 1) / WORLDGEN_CHUNK_ROWS : 1;
+    job.chunks = (WorldChunk*)calloc((size_t)chunkCount, sizeof(WorldChunk));
+    if (job.chunks == NULL) {
+        return 0;
+    }
+
+    /* The chunks are fixed by the world size, not by the number of threads */
+    runParallel(chunkCount, generateChunkTask, &job);
+
+    int ok = 1;
+    for (int c = 0; c < chunkCount; c++) {
+        ok = ok && !job.chunks[c].failed;
+    }
+    if (ok) {
+        generated->obstacles = joinChunks(job.chunks, chunkCount, 1, &generated->obstacleCount);
+        generated->junk = joinChunks(job.chunks, chunkCount, 0, &generated->junkCount);
+        ok = generated->obstacles != NULL && generated->junk != NULL;
+    }
+    for (int c = 0; c < chunkCount; c++) {
+        free(job.chunks[c].obstacles);
+        free(job.chunks[c].junk);
+    }
+    free(job.chunks);
+    if (!ok) {
+        freeGeneratedWorld(generated);
+    }
+    return ok;
+}
+
+/* Free the cell lists of a generated world */
+void freeGeneratedWorld(GeneratedWorld* generated) {
+    free(generated->obstacles);
+    free(generated->junk);
+    memset(generated, 0, sizeof(*generated));
+}
@@ -0,0 +1,49 @@
+/**
+ * SpaceXplorer World Generator Header
+ *
+ * This header defines the procedural placement of obstacles and junk.
+ * Coherent value noise fields seeded from the game seed shape the world:
+ * a ridged field draws winding asteroid belts where obstacles gather, a
+ * second field marks the dense clusters junk drifts into, and a coarse
+ * third one cuts out empty voids. Every cell draws its own random number
+ * from a hash of the seed and its position, so a cell's content does not
+ * depend on any other cell. The rows are generated in chunks on the
+ * thread pool with integer arithmetic only, and the chunks' results are
+ * joined in row order, so a seed gives the same world on any number of
+ * threads and on any processor.
+ */
+
+#ifndef SPACEXPLORER_WORLDGEN_H
+#define SPACEXPLORER_WORLDGEN_H
+
+/**
+ * Cell placed by the generator
+ * For junk the type is a JunkType, for obstacles it is unused
+ */
+typedef struct {
+    int x;      /* X-coordinate */
+    int y;      /* Y-coordinate */
+    int type;   /* Kind of junk placed on the cell */
+} GeneratedCell;
+
+/**
+ * Generated world
+ * Cells are listed row by row, left to right
+ */
+typedef struct {
+    GeneratedCell* obstacles;   /* Cells turned into obstacles */
+    int obstacleCount;          /* Number of obstacles */
+    GeneratedCell* junk;        /* Cells junk was placed on */
+    int junkCount;              /* Number of junk items */
+} GeneratedWorld;
+
+/*
+ * Generate obstacles and junk for a world, about the given number of each.
+ * Only cells marked '.' in the world rows are used, returns 0 if out of memory.
+ */
+int generateWorld(GeneratedWorld* generated, char** world, int width, int height, unsigned int seed,
+                  int obstacles, int junk);
+/* Free the cell lists of a generated world */
+void freeGeneratedWorld(GeneratedWorld* generated);
+
+#endif /* SPACEXPLORER_WORLDGEN_H */